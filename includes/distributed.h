@@ -0,0 +1,56 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include "platform.h"
+#include "mandelbrot.h"
+
+/*
+Renderização distribuída entre processos (platforms/distributed.c). O coordenador
+escuta num endereço, "unix:<caminho>" ou "[tcp:]<host>:<porta>", e os workers se
+conectam a ele; cada um recebe blocos da vista (o centro em ponto fixo, o zoom e o
+retângulo) e devolve as iterações comprimidas. O coordenador monta o frame inteiro
+e colore como se tivesse renderizado sozinho: as contagens são as mesmas.
+
+Um worker que cai (a conexão fecha) tem os seus blocos pendentes devolvidos à fila;
+workers novos podem se conectar a qualquer momento enquanto falta algum bloco.
+*/
+
+// Lado dos blocos enviados aos workers e quantos ficam pendentes em cada um, para ele não esperar o próximo
+#define DISTRIBUTED_TILE_SIZE 256
+#define DISTRIBUTED_JOBS_PER_WORKER 2
+#define DISTRIBUTED_MAX_WORKERS 64
+
+// Quanto tempo um worker tenta se conectar antes de desistir, para poder ser iniciado antes do coordenador
+#define DISTRIBUTED_CONNECT_SECONDS 10
+
+typedef struct {
+    HPReal center_x;
+    HPReal center_y;
+    f64 zoom;
+    i32 width;
+    i32 height;
+    i32 max_iterations;
+    RenderPrecision precision; // Já resolvida: todos os workers precisam usar a mesma
+} DistributedView;
+
+typedef struct {
+    i32 tiles;
+    i32 workers;          // Conexões aceitas ao longo da renderização
+    i32 lost_workers;     // Conexões que fecharam antes do fim
+    i32 reassigned_tiles; // Blocos que estavam com um worker perdido e voltaram para a fila
+    i64 raw_bytes;
+    i64 compressed_bytes;
+} DistributedStats;
+
+/*
+Renderiza a vista inteira em 'iterations' (width x height, linha a linha) pelos
+workers que se conectarem a 'address'. Com spawn_workers > 0, o próprio coordenador
+inicia esse número de workers locais antes de esperar pelos outros.
+*/
+b32 DistributedRender(const char *address, const DistributedView *view, i32 spawn_workers, i32 *iterations,
+                      DistributedStats *stats);
+
+// Laço do worker: calcula os blocos recebidos até o coordenador fechar a conexão; retorna o código de saída
+int DistributedWorker(const char *address);
+
+#endif
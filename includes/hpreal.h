@@ -0,0 +1,35 @@
+#ifndef HPREAL_H
+#define HPREAL_H
+
+#include "platform.h"
+
+/*
+Número real de ponto fixo com precisão arbitrária, usado só para o centro da
+vista e para a órbita de referência do modo deep zoom.
+
+Os limbs são de 32 bits em ordem little-endian: limbs[HP_MAX_LIMBS - 1] é a
+parte inteira e os anteriores são a fração. As operações recebem quantos limbs
+(a partir do mais significativo) estão ativos; os demais são tratados como zero.
+*/
+#define HP_MAX_LIMBS 40
+
+typedef struct {
+    u32 limbs[HP_MAX_LIMBS];
+    b32 negative;
+} HPReal;
+
+void HPZero(HPReal *r);
+void HPFromF64(HPReal *r, f64 value);
+f64  HPToF64(const HPReal *a);
+b32  HPFromString(HPReal *r, const char *text);
+
+void HPAdd(HPReal *r, const HPReal *a, const HPReal *b, i32 limbs);
+void HPSub(HPReal *r, const HPReal *a, const HPReal *b, i32 limbs);
+void HPMul(HPReal *r, const HPReal *a, const HPReal *b, i32 limbs);
+void HPAddF64(HPReal *r, f64 value);
+void HPTruncate(HPReal *r, i32 limbs);
+
+// Limbs suficientes para distinguir pixels vizinhos com esse zoom, com folga de 64 bits
+i32 HPLimbsForZoom(f64 zoom);
+
+#endif
@@ -0,0 +1,324 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "platform.h"
+#include "mandelbrot.h"
+
+#include <math.h>
+
+/*
+Kernels de iteração por conjunto de instruções. Cada um fica na sua própria
+unidade de tradução (renderer/kernel_*.c), compilada só com as flags do seu ISA,
+e renderer/kernels.c escolhe um deles em tempo de execução. Todos fazem as mesmas
+operações na mesma ordem, sem FMA contraída, então devolvem as mesmas contagens
+bit a bit; o que muda é só quantos pixels andam juntos.
+
+As funções de trecho devolvem quantas iterações as saídas antecipadas economizaram.
+*/
+typedef i64 IterateSpanF32Fn(i32 *iterations, i32 x0, i32 x1, i32 step, f32 start_x, f32 c_im, f32 zoom, i32 max_iterations);
+typedef i64 IterateSpanF64Fn(i32 *iterations, i32 x0, i32 x1, i32 step, f64 start_x, f64 c_im, f64 zoom, i32 max_iterations);
+typedef i64 IterateColumnF32Fn(i32 *iterations, i32 stride, i32 y0, i32 y1, f32 c_re, f32 start_y, f32 zoom, i32 max_iterations);
+typedef i64 IterateColumnF64Fn(i32 *iterations, i32 stride, i32 y0, i32 y1, f64 c_re, f64 start_y, f64 zoom, i32 max_iterations);
+
+/*
+Bloco [x0, x1) x [y0, y1) de um buffer com 'stride' pixels por linha, com
+c = (start_x + x * zoom, start_y + y * zoom), a mesma conta dos trechos. Os kernels
+vetoriais tratam o bloco como uma fila de pixels: a lane que termina grava a sua
+contagem e já recebe o próximo pixel da fila, em vez de esperar mascarada pela
+lane mais lenta do grupo. Kernels sem esta entrada (NULL) iteram o bloco linha a linha.
+*/
+typedef i64 IterateBlockF32Fn(i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1,
+                              f32 start_x, f32 start_y, f32 zoom, i32 max_iterations);
+typedef i64 IterateBlockF64Fn(i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1,
+                              f64 start_x, f64 start_y, f64 zoom, i32 max_iterations);
+
+/*
+Double-double: c = start + k * zoom, com start em hi + lo e o produto k * zoom em
+f64 (o erro dele é uma fração desprezível de pixel). Todos os kernels fazem as
+mesmas operações, e as transformações sem erro dão o mesmo resultado com ou sem
+FMA, então as contagens também batem bit a bit entre eles.
+*/
+typedef i64 IterateSpanDDFn(i32 *iterations, i32 x0, i32 x1, i32 step, DoubleDouble start_x, DoubleDouble c_im,
+                            f64 zoom, i32 max_iterations);
+typedef i64 IterateColumnDDFn(i32 *iterations, i32 stride, i32 y0, i32 y1, DoubleDouble c_re, DoubleDouble start_y,
+                              f64 zoom, i32 max_iterations);
+
+// Órbita de referência do deep zoom, vista pelos kernels: Z_0 .. Z_{length - 1}
+typedef struct {
+    const f64 *z_re;
+    const f64 *z_im;
+    const f32 *z_re32;
+    const f32 *z_im32;
+    i32 length;
+} ReferenceLanes;
+
+/*
+Perturbação de PERTURB_LANES_F32 (ou _F64) pixels a partir da iteração 'skip', com
+dc e o desvio inicial (já avaliado pela série) por lane; grava as contagens em 'counts'.
+*/
+#define PERTURB_LANES_F32 8
+#define PERTURB_LANES_F64 4
+typedef void PerturbLanesF32Fn(const ReferenceLanes *ref, const f32 *dc_re, const f32 *dc_im,
+                               const f32 *d_re, const f32 *d_im, i32 skip, i32 max_iterations, i32 *counts);
+typedef void PerturbLanesF64Fn(const ReferenceLanes *ref, const f64 *dc_re, const f64 *dc_im,
+                               const f64 *d_re, const f64 *d_im, i32 skip, i32 max_iterations, i32 *counts);
+void AVX2ColorizeSpan(u32 *pixels, const i32 *iterations, i32 count, const u32 *lut, i32 max_iterations);
+
+/*
+Coloração: pixels[k] = lut[min(iterations[k], max_iterations)], com lut de max_iterations + 1 cores.
+Linhas longas que começam alinhadas ao vetor (as do buffer da janela sempre começam)
+são gravadas sem passar pelo cache: o frame inteiro não caberia nele e quem o lê
+depois é o servidor X. Linhas curtas ficam no cache, que as devolve mais rápido.
+*/
+#define COLORIZE_STREAM_MIN_PIXELS 1024
+typedef void ColorizeSpanFn(u32 *pixels, const i32 *iterations, i32 count, const u32 *lut, i32 max_iterations);
+
+typedef struct {
+    const char *name;
+    IterateSpanF32Fn *span_f32;
+    IterateSpanF64Fn *span_f64;
+    IterateColumnF32Fn *column_f32;
+    IterateColumnF64Fn *column_f64;
+    PerturbLanesF32Fn *perturb_f32;
+    PerturbLanesF64Fn *perturb_f64;
+    ColorizeSpanFn *colorize;
+    IterateBlockF32Fn *block_f32;
+    IterateBlockF64Fn *block_f64;
+    IterateSpanDDFn *span_dd;
+    IterateColumnDDFn *column_dd;
+} IterationKernel;
+
+extern const IterationKernel KernelScalar;
+extern const IterationKernel KernelSSE2;
+extern const IterationKernel KernelAVX2;
+extern const IterationKernel KernelAVX512;
+extern const IterationKernel KernelFMA;
+
+// Kernel escolhido por SelectIterationKernel (ou, na primeira chamada, pela CPU e por MANDELBROT_KERNEL)
+const IterationKernel *GetIterationKernel(void);
+
+// Implementações escalares de referência, usadas pelo kernel escalar e nas sobras de cada linha dos outros
+i64 ScalarSpanF32(i32 *iterations, i32 x0, i32 x1, i32 step, f32 start_x, f32 c_im, f32 zoom, i32 max_iterations);
+i64 ScalarSpanF64(i32 *iterations, i32 x0, i32 x1, i32 step, f64 start_x, f64 c_im, f64 zoom, i32 max_iterations);
+i64 ScalarColumnF32(i32 *iterations, i32 stride, i32 y0, i32 y1, f32 c_re, f32 start_y, f32 zoom, i32 max_iterations);
+i64 ScalarColumnF64(i32 *iterations, i32 stride, i32 y0, i32 y1, f64 c_re, f64 start_y, f64 zoom, i32 max_iterations);
+void ScalarPerturbLanesF32(const ReferenceLanes *ref, const f32 *dc_re, const f32 *dc_im,
+                           const f32 *d_re, const f32 *d_im, i32 skip, i32 max_iterations, i32 *counts);
+void ScalarPerturbLanesF64(const ReferenceLanes *ref, const f64 *dc_re, const f64 *dc_im,
+                           const f64 *d_re, const f64 *d_im, i32 skip, i32 max_iterations, i32 *counts);
+void ScalarColorizeSpan(u32 *pixels, const i32 *iterations, i32 count, const u32 *lut, i32 max_iterations);
+i64 ScalarSpanDD(i32 *iterations, i32 x0, i32 x1, i32 step, DoubleDouble start_x, DoubleDouble c_im, f64 zoom,
+                 i32 max_iterations);
+i64 ScalarColumnDD(i32 *iterations, i32 stride, i32 y0, i32 y1, DoubleDouble c_re, DoubleDouble start_y, f64 zoom,
+                   i32 max_iterations);
+
+// O AVX-512 e o FMA reaproveitam a perturbação e o double-double em AVX2, que toda CPU com AVX-512 também tem
+i64 AVX2SpanDD(i32 *iterations, i32 x0, i32 x1, i32 step, DoubleDouble start_x, DoubleDouble c_im, f64 zoom,
+               i32 max_iterations);
+i64 AVX2ColumnDD(i32 *iterations, i32 stride, i32 y0, i32 y1, DoubleDouble c_re, DoubleDouble start_y, f64 zoom,
+                 i32 max_iterations);
+void AVX2PerturbLanesF32(const ReferenceLanes *ref, const f32 *dc_re, const f32 *dc_im,
+                         const f32 *d_re, const f32 *d_im, i32 skip, i32 max_iterations, i32 *counts);
+void AVX2PerturbLanesF64(const ReferenceLanes *ref, const f64 *dc_re, const f64 *dc_im,
+                         const f64 *d_re, const f64 *d_im, i32 skip, i32 max_iterations, i32 *counts);
+
+/*
+Recarregar custa uma passada escalar pelas lanes, então só vale a pena quando várias
+terminaram juntas; até lá as que acabaram ficam mascaradas, como no kernel sem recarga.
+*/
+#define REFILL_MIN_LANES(lanes) ((lanes) / 2)
+
+/*
+Saídas antecipadas para pixels do interior, que sem elas sempre rodam até o limite:
+
+- O cardioide principal e o bulbo de período 2 têm fórmula fechada; quem está
+  dentro deles nunca escapa e recebe o limite sem iterar.
+- Detecção de periodicidade (Brent): guardamos z nas iterações 2^k e comparamos
+  as seguintes com ele. Se a órbita voltar para perto do ponto guardado ela caiu
+  num ciclo atrator e também não escapa mais.
+
+Em ambos os casos a contagem final é max_iterations, igual à do laço completo.
+Os kernels vetoriais repetem exatamente estas contas em cada lane.
+*/
+static inline i32 IterateScalarF32(f32 c_re, f32 c_im, i32 max_iterations, i64 *saved)
+{
+    // Cardioide: q (q + x - 1/4) <= y^2 / 4, com q = (x - 1/4)^2 + y^2; bulbo: (x + 1)^2 + y^2 <= 1/16
+    f32 c_im2 = c_im * c_im;
+    f32 xq = c_re - 0.25f;
+    f32 q = xq * xq + c_im2;
+    f32 x1 = c_re + 1.0f;
+    if (q * (q + xq) <= 0.25f * c_im2 || x1 * x1 + c_im2 <= 1.0f / 16.0f) {
+        *saved += max_iterations;
+        return max_iterations;
+    }
+
+    f32 z_re = 0, z_im = 0, z_re2 = 0, z_im2 = 0;
+    f32 old_re = 0, old_im = 0;
+    int next_save = 1;
+    int iteration = 0;
+    while (z_re2 + z_im2 <= 4.0f && iteration < max_iterations)
+    {
+        z_im = 2 * (z_re * z_im) + c_im;
+        z_re = (z_re2 - z_im2) + c_re;
+        z_re2 = z_re * z_re;
+        z_im2 = z_im * z_im;
+        iteration++;
+
+        if (fabsf(z_re - old_re) <= PERIODICITY_EPSILON_F32 && fabsf(z_im - old_im) <= PERIODICITY_EPSILON_F32) {
+            *saved += max_iterations - iteration;
+            return max_iterations;
+        }
+        if (iteration == next_save) {
+            old_re = z_re;
+            old_im = z_im;
+            next_save *= 2;
+        }
+    }
+    return iteration;
+}
+
+static inline i32 IterateScalarF64(f64 c_re, f64 c_im, i32 max_iterations, i64 *saved)
+{
+    f64 c_im2 = c_im * c_im;
+    f64 xq = c_re - 0.25;
+    f64 q = xq * xq + c_im2;
+    f64 x1 = c_re + 1.0;
+    if (q * (q + xq) <= 0.25 * c_im2 || x1 * x1 + c_im2 <= 1.0 / 16.0) {
+        *saved += max_iterations;
+        return max_iterations;
+    }
+
+    f64 z_re = 0, z_im = 0, z_re2 = 0, z_im2 = 0;
+    f64 old_re = 0, old_im = 0;
+    int next_save = 1;
+    int iteration = 0;
+    while (z_re2 + z_im2 <= 4.0 && iteration < max_iterations)
+    {
+        z_im = 2 * (z_re * z_im) + c_im;
+        z_re = (z_re2 - z_im2) + c_re;
+        z_re2 = z_re * z_re;
+        z_im2 = z_im * z_im;
+        iteration++;
+
+        if (fabs(z_re - old_re) <= PERIODICITY_EPSILON_F64 && fabs(z_im - old_im) <= PERIODICITY_EPSILON_F64) {
+            *saved += max_iterations - iteration;
+            return max_iterations;
+        }
+        if (iteration == next_save) {
+            old_re = z_re;
+            old_im = z_im;
+            next_save *= 2;
+        }
+    }
+    return iteration;
+}
+
+/*
+Aritmética double-double a partir de transformações sem erro: TwoSum e TwoProd
+devolvem o resultado arredondado e o erro exato dele. Com FMA o erro do produto
+sai de uma instrução (fma(a, b, -p)); sem ela, da divisão de Dekker em metades
+de 26 bits. As duas formas dão o mesmo erro, que é exato.
+*/
+static inline DoubleDouble DDTwoSum(f64 a, f64 b)
+{
+    f64 s = a + b;
+    f64 bb = s - a;
+    return (DoubleDouble){s, (a - (s - bb)) + (b - bb)};
+}
+
+// Só vale com |a| >= |b|, como depois de uma soma ou produto já normalizados
+static inline DoubleDouble DDQuickTwoSum(f64 a, f64 b)
+{
+    f64 s = a + b;
+    return (DoubleDouble){s, b - (s - a)};
+}
+
+static inline DoubleDouble DDTwoProd(f64 a, f64 b)
+{
+    f64 p = a * b;
+#ifdef __FMA__
+    return (DoubleDouble){p, fma(a, b, -p)};
+#else
+    const f64 split = 134217729.0; // 2^27 + 1
+    f64 ta = split * a, tb = split * b;
+    f64 a_hi = ta - (ta - a), b_hi = tb - (tb - b);
+    f64 a_lo = a - a_hi, b_lo = b - b_hi;
+    return (DoubleDouble){p, ((a_hi * b_hi - p) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo};
+#endif
+}
+
+static inline DoubleDouble DDAdd(DoubleDouble a, DoubleDouble b)
+{
+    DoubleDouble s = DDTwoSum(a.hi, b.hi);
+    return DDQuickTwoSum(s.hi, s.lo + (a.lo + b.lo));
+}
+
+static inline DoubleDouble DDSub(DoubleDouble a, DoubleDouble b)
+{
+    return DDAdd(a, (DoubleDouble){-b.hi, -b.lo});
+}
+
+static inline DoubleDouble DDAddF64(DoubleDouble a, f64 b)
+{
+    DoubleDouble s = DDTwoSum(a.hi, b);
+    return DDQuickTwoSum(s.hi, s.lo + a.lo);
+}
+
+static inline DoubleDouble DDMul(DoubleDouble a, DoubleDouble b)
+{
+    DoubleDouble p = DDTwoProd(a.hi, b.hi);
+    return DDQuickTwoSum(p.hi, p.lo + (a.hi * b.lo + a.lo * b.hi));
+}
+
+static inline DoubleDouble DDSqr(DoubleDouble a)
+{
+    DoubleDouble p = DDTwoProd(a.hi, a.hi);
+    return DDQuickTwoSum(p.hi, p.lo + 2.0 * (a.hi * a.lo));
+}
+
+/*
+Mesmo laço do f64 em double-double. O cardioide, o bulbo e a fuga olham só as
+partes hi: errar ali por 2^-52 só muda pixels a essa distância da borda do
+cardioide ou do raio 2, que nem assim escapariam dentro do limite.
+*/
+static inline i32 IterateScalarDD(DoubleDouble c_re, DoubleDouble c_im, i32 max_iterations, i64 *saved)
+{
+    f64 c_im2 = c_im.hi * c_im.hi;
+    f64 xq = c_re.hi - 0.25;
+    f64 q = xq * xq + c_im2;
+    f64 x1 = c_re.hi + 1.0;
+    if (q * (q + xq) <= 0.25 * c_im2 || x1 * x1 + c_im2 <= 1.0 / 16.0) {
+        *saved += max_iterations;
+        return max_iterations;
+    }
+
+    DoubleDouble z_re = {0, 0}, z_im = {0, 0}, z_re2 = {0, 0}, z_im2 = {0, 0};
+    DoubleDouble old_re = {0, 0}, old_im = {0, 0};
+    int next_save = 1;
+    int iteration = 0;
+    while (z_re2.hi + z_im2.hi <= 4.0 && iteration < max_iterations)
+    {
+        DoubleDouble product = DDMul(z_re, z_im);
+        z_im = DDAdd((DoubleDouble){2.0 * product.hi, 2.0 * product.lo}, c_im);
+        z_re = DDAdd(DDSub(z_re2, z_im2), c_re);
+        z_re2 = DDSqr(z_re);
+        z_im2 = DDSqr(z_im);
+        iteration++;
+
+        // Perto do ponto guardado, hi - hi é exato, então a diferença sai com a precisão toda
+        f64 delta_re = (z_re.hi - old_re.hi) + (z_re.lo - old_re.lo);
+        f64 delta_im = (z_im.hi - old_im.hi) + (z_im.lo - old_im.lo);
+        if (fabs(delta_re) <= PERIODICITY_EPSILON_DD && fabs(delta_im) <= PERIODICITY_EPSILON_DD) {
+            *saved += max_iterations - iteration;
+            return max_iterations;
+        }
+        if (iteration == next_save) {
+            old_re = z_re;
+            old_im = z_im;
+            next_save *= 2;
+        }
+    }
+    return iteration;
+}
+
+#endif
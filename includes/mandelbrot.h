@@ -0,0 +1,317 @@
+#ifndef MANDELBROT_H
+#define MANDELBROT_H
+
+#include "platform.h"
+#include "hpreal.h"
+
+// Limite de iterações inicial; o limite em si é um parâmetro de cada renderização
+#define DEFAULT_MAX_ITERATIONS 256
+
+// Quantas cores a paleta gerada tem antes de se repetir
+#define PALETTE_DEFAULT_LENGTH 256
+
+/*
+Limite adaptativo (ChooseAdaptiveIterations): piso que cresce com a profundidade
+do zoom e ajuste pelo último frame, dobrando quando mais que ADAPTIVE_LATE_FRACTION
+dos pixels escapou só na metade de cima do limite.
+*/
+#define ADAPTIVE_REFERENCE_ZOOM 0.004
+#define ADAPTIVE_ITERATIONS_PER_OCTAVE 32
+#define ADAPTIVE_MIN_ITERATIONS 64
+#define ADAPTIVE_MAX_ITERATIONS (1 << 20)
+#define ADAPTIVE_LATE_FRACTION 0.001
+#define ADAPTIVE_SAMPLE_STRIDE 4
+
+// Quantos ULPs um pixel precisa ter para os kernels f32/f64 ainda serem exatos
+#define F32_PRECISION_MARGIN 32.0
+#define F64_PRECISION_MARGIN 32.0
+#define DD_PRECISION_MARGIN 32.0
+
+// Precisão relativa do double-double (hi + lo): 2^-104, contra 2^-52 do f64
+#define DD_EPSILON 4.930380657631324e-32
+
+// Distância em que a órbita é considerada de volta ao ponto guardado pela detecção de periodicidade
+#define PERIODICITY_EPSILON_F32 1e-6f
+#define PERIODICITY_EPSILON_F64 1e-13
+#define PERIODICITY_EPSILON_DD 1e-28
+
+// Quanto o deslocamento entre dois frames pode fugir de um número inteiro de pixels e ainda ser reaproveitado
+#define PAN_SUBPIXEL_TOLERANCE 1e-3
+
+// Modo progressivo: a primeira passada calcula 1 a cada 16x16 pixels e as seguintes refinam pela metade
+#define PROGRESSIVE_FIRST_STRIDE 16
+#define PROGRESSIVE_TARGET_FRAME_SECONDS (1.0 / 60.0)
+#define PROGRESSIVE_MIN_BUDGET_SECONDS 0.004
+#define PROGRESSIVE_BATCH_ROWS 4
+
+// Resolução dinâmica durante a interação: a escala da grade interna busca esta meta e não desce abaixo do piso
+#define DYNAMIC_RESOLUTION_TARGET_SECONDS (1.0 / 60.0)
+#define DYNAMIC_RESOLUTION_MIN_SCALE 0.25f
+
+// O zoom da janela anda em degraus de 2^(1/ZOOM_LEVELS_PER_OCTAVE), para os mesmos zooms se repetirem
+#define ZOOM_LEVELS_PER_OCTAVE 8
+
+// Cache de blocos: lado de cada bloco em pixels e limite padrão de memória
+#define TILE_CACHE_SIZE 128
+#define TILE_CACHE_DEFAULT_MEGABYTES 64
+// Fração dos blocos que precisa já estar no cache para um frame de zoom usá-lo em vez da resolução dinâmica
+#define TILE_CACHE_WARM_FRACTION 0.75f
+
+// Velocidade da animação da paleta (tecla C), em cores por segundo
+#define PALETTE_CYCLE_COLORS_PER_SECOND 64.0f
+
+// Blocos do escalonador: largos para as lanes SIMD andarem juntas, baixos para haver muitos por frame
+#define TILE_DEFAULT_WIDTH 64
+#define TILE_DEFAULT_HEIGHT 16
+
+typedef enum {
+    PRECISION_AUTO,
+    PRECISION_F32,
+    PRECISION_F64,
+    PRECISION_DD,   // Iteração direta em double-double, entre o fim do f64 e a perturbação
+    PRECISION_DEEP
+} RenderPrecision;
+
+// Número com o dobro da mantissa do f64: o valor é hi + lo, com |lo| <= ULP(hi) / 2
+typedef struct {
+    f64 hi;
+    f64 lo;
+} DoubleDouble;
+
+typedef struct {
+    i32 reference_length;
+    i32 reference_limbs;
+    i32 series_skip;
+    b32 reference_reused;
+    RenderPrecision lanes;
+} PerturbationStats;
+
+typedef struct {
+    i64 computed_pixels;
+    i64 reused_pixels;
+} IncrementalStats;
+
+typedef struct {
+    i64 computed_pixels;
+    i64 filled_pixels;
+} SubdivisionStats;
+
+// Distribuição das contagens do último frame completo, amostrada a cada ADAPTIVE_SAMPLE_STRIDE linhas
+typedef struct {
+    i32 max_iterations;
+    i32 max_escaped;
+    i64 sampled_pixels;
+    i64 limit_pixels;
+    i64 late_pixels;
+} IterationLimitStats;
+
+// Distribuição dos blocos entre as threads; o desequilíbrio é max_busy_seconds / mean_busy_seconds
+typedef struct {
+    i32 threads;
+    i32 tile_width;
+    i32 tile_height;
+    i64 tiles;
+    i64 steals;
+    f64 max_busy_seconds;
+    f64 mean_busy_seconds;
+} TileStats;
+
+// Um bloco do cache: posição na grade absoluta do zoom (o pixel global i tem c = i * zoom) e o que muda as contagens
+typedef struct {
+    f64 zoom;
+    i64 tile_x;
+    i64 tile_y;
+    i32 max_iterations;
+    RenderPrecision precision;
+} TileCacheKey;
+
+// Acertos e faltas do último frame montado pelo cache, e o que ele ocupa agora
+typedef struct {
+    i64 hits;
+    i64 misses;
+    i32 tiles;
+    i64 bytes;
+} TileCacheStats;
+
+// Custo de um filme de zoom até agora: pixels iterados nos quadros-chave e tempo de cada etapa
+typedef struct {
+    i32 frames;
+    i32 keyframes;
+    i64 computed_pixels;
+    f64 keyframe_seconds;
+    f64 resample_seconds;
+} ZoomMovieStats;
+
+// Parâmetros já resolvidos de um frame, para calcular qualquer trecho dele
+typedef struct {
+    RenderPrecision precision;
+    i32 max_iterations;
+    f32 start_x32;
+    f32 start_y32;
+    f32 zoom32;
+    f64 start_x;
+    f64 start_y;
+    f64 zoom;
+    DoubleDouble start_x_dd;
+    DoubleDouble start_y_dd;
+    b32 use_subdivision;
+} FrameSetup;
+
+// Camada de aplicação exposta para as plataformas que renderizam sem janela
+void InitColorPalette(void);
+
+/*
+Coloração (renderer/coloring.c), separada da iteração: PrepareColorLookup monta a
+tabela contagem -> cor com o ciclo e, se ligada e com 'iterations', a equalização
+por histograma; ColorizeRow só pode ser chamada depois dela. ColorizeFrame faz as duas.
+*/
+void PrepareColorLookup(const i32 *iterations, i32 stride, i32 width, i32 height, i32 max_iterations);
+void ColorizeRow(u32 *row_pixel, const i32 *iterations, i32 count, i32 max_iterations);
+void ColorizeFrame(OffscreenBuffer *buffer, const i32 *iterations, i32 stride, i32 max_iterations);
+void SetPaletteLength(i32 length);
+i32 GetPaletteLength(void);
+void SetPaletteCycle(i32 offset);
+i32 GetPaletteCycle(void);
+void SetHistogramEqualization(b32 enabled);
+b32 IsHistogramEqualizationEnabled(void);
+
+// Estatísticas do último frame completo e o limite que o modo adaptativo escolhe a partir delas e do zoom
+b32 GetIterationLimitStats(IterationLimitStats *stats);
+i64 GetFrameIterationCount(void); // Soma das contagens do último frame completo (o custo sem saídas antecipadas)
+i32 ChooseAdaptiveIterations(i32 current_iterations, f64 zoom);
+
+// Colore de novo as iterações guardadas do último frame, sem iterar; false se não há frame do tamanho do buffer
+b32 RecolorMandelbrot(OffscreenBuffer *buffer);
+void RenderMandelbrotF32(OffscreenBuffer *buffer, f32 center_x, f32 center_y, f32 zoom, i32 max_iterations);
+void RenderMandelbrotF64(OffscreenBuffer *buffer, f64 center_x, f64 center_y, f64 zoom, i32 max_iterations);
+
+/*
+Iteração de trechos de linha ou coluna pelo kernel escolhido em tempo de execução
+(renderer/kernels.c). A escolha é pela CPU, a não ser que MANDELBROT_KERNEL ou
+SelectIterationKernel peçam outro: "scalar", "sse2", "avx2", "avx512" ou "fma". O
+"fma" só entra quando pedido pelo nome, porque o arredondamento fundido muda as
+contagens em relação aos outros kernels.
+*/
+void IterateSpanF32(i32 *iterations, i32 x0, i32 x1, i32 step, f32 start_x, f32 c_im, f32 zoom, i32 max_iterations);
+void IterateSpanF64(i32 *iterations, i32 x0, i32 x1, i32 step, f64 start_x, f64 c_im, f64 zoom, i32 max_iterations);
+void IterateColumnF32(i32 *iterations, i32 stride, i32 y0, i32 y1, f32 c_re, f32 start_y, f32 zoom, i32 max_iterations);
+void IterateColumnF64(i32 *iterations, i32 stride, i32 y0, i32 y1, f64 c_re, f64 start_y, f64 zoom, i32 max_iterations);
+void IterateBlockF32(i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1,
+                     f32 start_x, f32 start_y, f32 zoom, i32 max_iterations);
+void IterateBlockF64(i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1,
+                     f64 start_x, f64 start_y, f64 zoom, i32 max_iterations);
+void IterateSpanDD(i32 *iterations, i32 x0, i32 x1, i32 step, DoubleDouble start_x, DoubleDouble c_im, f64 zoom,
+                   i32 max_iterations);
+void IterateColumnDD(i32 *iterations, i32 stride, i32 y0, i32 y1, DoubleDouble c_re, DoubleDouble start_y, f64 zoom,
+                     i32 max_iterations);
+b32 SelectIterationKernel(const char *name);
+const char *GetIterationKernelName(void);
+
+// Recarga de lanes nos blocos (AVX2 e AVX-512): ligada por padrão; ativa só se o kernel atual a tiver
+void SetLaneRefill(b32 enabled);
+b32 IsLaneRefillActive(void);
+
+// Iterações que o frame deixou de fazer graças ao teste do cardioide/bulbo e à detecção de periodicidade
+void ResetSavedIterations(void);
+i64 GetSavedIterations(void);
+
+// Escolhe o kernel pelo zoom em relação ao espaçamento representável em f32; retorna a precisão usada
+RenderPrecision ChooseRenderPrecision(f64 center_x, f64 center_y, f64 zoom, i32 width, i32 height);
+// Deixa a escolha automática usar o double-double depois do f64 (desligado, vai direto para a perturbação)
+void SetDoubleDoubleEnabled(b32 enabled);
+RenderPrecision RenderMandelbrot(OffscreenBuffer *buffer, const HPReal *center_x, const HPReal *center_y,
+                                 f64 zoom, i32 max_iterations, RenderPrecision precision);
+
+// Guarda as iterações do frame anterior; se a vista nova for um deslocamento inteiro, só calcula as faixas expostas
+RenderPrecision RenderMandelbrotIncremental(OffscreenBuffer *buffer, const HPReal *center_x, const HPReal *center_y,
+                                            f64 zoom, i32 max_iterations, RenderPrecision precision);
+IncrementalStats GetIncrementalStats(void);
+
+// Resolve a precisão e o início da vista; no modo deep também prepara a órbita de referência
+b32 FrameSetupInit(FrameSetup *frame, const HPReal *center_x, const HPReal *center_y, f64 zoom,
+                   i32 width, i32 height, i32 max_iterations, RenderPrecision precision);
+void FrameIterateSpan(const FrameSetup *frame, i32 *row_iterations, i32 x0, i32 x1, i32 step, i32 y);
+void FrameIterateColumn(const FrameSetup *frame, i32 *iterations, i32 stride, i32 y0, i32 y1, i32 x);
+void FrameIterateBlock(const FrameSetup *frame, i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1);
+
+// Calcula e colore o frame inteiro, bloco a bloco pelo escalonador
+void FrameRender(const FrameSetup *frame, OffscreenBuffer *buffer);
+
+// Calcula só o retângulo [x0, x1) x [y0, y1) da vista, em paralelo; 'iterations' guarda só ele, linha a linha
+void FrameIterateRegion(const FrameSetup *frame, i32 *iterations, i32 x0, i32 y0, i32 x1, i32 y1);
+
+/*
+Escalonador de blocos com roubo de trabalho (renderer/tile_scheduler.c): 'work' é
+chamada uma vez para cada bloco [x0, x1) x [y0, y1) do retângulo, em paralelo.
+*/
+typedef void TileWorkFn(void *context, i32 x0, i32 y0, i32 x1, i32 y1);
+void ScheduleTiles(i32 x0, i32 y0, i32 x1, i32 y1, TileWorkFn *work, void *context);
+void SetTileSize(i32 width, i32 height);
+void SetThreadPinning(b32 enabled);
+void ResetTileStats(void);
+TileStats GetTileStats(void);
+
+// Mariani-Silver (renderer/mariani_silver.c): só a borda de cada retângulo é iterada e bordas uniformes são preenchidas
+void SubdivisionIterateRect(const FrameSetup *frame, i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1);
+void ResetSubdivisionStats(void);
+SubdivisionStats GetSubdivisionStats(void);
+
+// Liga a subdivisão nos frames completos e nas faixas expostas do modo incremental
+void SetSubdivisionEnabled(b32 enabled);
+RenderPrecision RenderMandelbrotSubdivided(OffscreenBuffer *buffer, const HPReal *center_x, const HPReal *center_y,
+                                           f64 zoom, i32 max_iterations, RenderPrecision precision);
+
+/*
+Cache de blocos (renderer/tile_cache.c) com limite de memória e descarte do usado
+há mais tempo. Find devolve as iterações de um bloco guardado; Insert reserva a
+entrada de um bloco novo, a ser preenchida por quem chamou, e devolve NULL se todas
+as entradas já foram usadas neste frame (BeginFrame marca o início de um). Contains
+só consulta, sem contar acerto nem marcar o bloco como usado.
+*/
+void TileCacheBeginFrame(void);
+i32 *TileCacheFind(const TileCacheKey *key);
+b32 TileCacheContains(const TileCacheKey *key);
+i32 *TileCacheInsert(const TileCacheKey *key);
+void TileCacheRemove(const TileCacheKey *key);
+void SetTileCacheLimit(i64 bytes); // Também esvazia o cache
+TileCacheStats GetTileCacheStats(void);
+
+// Calcula numa só passada do escalonador os blocos reservados com TileCacheInsert; 0 se a renderização foi cancelada
+b32 RenderCacheTiles(const TileCacheKey *keys, i32 *const *tiles, i32 count);
+
+// Monta o frame com os blocos do cache e calcula só os que faltam; no deep zoom é o incremental
+RenderPrecision RenderMandelbrotCached(OffscreenBuffer *buffer, const HPReal *center_x, const HPReal *center_y,
+                                       f64 zoom, i32 max_iterations, RenderPrecision precision);
+
+// Calcula a vista numa grade com 'scale' vezes a resolução do buffer e amplia para ele; scale >= 1 é o incremental
+RenderPrecision RenderMandelbrotScaled(OffscreenBuffer *buffer, const HPReal *center_x, const HPReal *center_y,
+                                       f64 zoom, i32 max_iterations, RenderPrecision precision, f32 scale);
+
+// Próxima escala da resolução dinâmica, a partir do tempo que a atual levou
+f32 ChooseRenderScale(f32 scale, f64 frame_seconds);
+
+// Refina a vista até esgotar o orçamento do frame; retorna true quando a imagem está completa
+b32 RenderMandelbrotProgressive(OffscreenBuffer *buffer, const HPReal *center_x, const HPReal *center_y,
+                                 f64 zoom, i32 max_iterations, RenderPrecision precision, f32 time_delta);
+
+/*
+Filme de zoom (renderer/zoom_movie.c): frame_count frames de width x height, do zoom
+inicial até 'octaves' oitavas para dentro, tirados de um quadro-chave a cada 2x de
+zoom em vez de calculados um a um. ZoomMovieFrame precisa dos frames em ordem.
+*/
+b32 ZoomMovieBegin(const HPReal *center_x, const HPReal *center_y, f64 start_zoom, f64 octaves, i32 frame_count,
+                   i32 width, i32 height, i32 max_iterations, RenderPrecision precision);
+b32 ZoomMovieFrame(i32 frame_index, OffscreenBuffer *buffer);
+void ZoomMovieEnd(void);
+ZoomMovieStats GetZoomMovieStats(void);
+
+// Deep zoom por perturbação (renderer/perturbation.c); a órbita de referência é reaproveitada entre frames
+void RenderMandelbrotPerturbation(OffscreenBuffer *buffer, const HPReal *center_x, const HPReal *center_y,
+                                  f64 zoom, i32 max_iterations);
+b32 PerturbationPrepare(const HPReal *center_x, const HPReal *center_y, f64 zoom,
+                        i32 width, i32 height, i32 max_iterations);
+void PerturbationIterateSpan(i32 *iterations, i32 x0, i32 x1, i32 step, i32 y);
+void PerturbationIterateColumn(i32 *iterations, i32 stride, i32 y0, i32 y1, i32 x);
+PerturbationStats GetPerturbationStats(void);
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "platform.h"
+
+#include <omp.h>
+
+/*
+Instrumentação dos frames (renderer/profiler.c). Zonas com início e fim marcados
+por thread, contadores por frame e histogramas dos últimos PROFILE_HISTORY_FRAMES
+frames; tudo pode ser gravado como trace do Chrome (chrome://tracing ou Perfetto)
+ou desenhado por cima da imagem.
+
+Desligada, cada zona custa o teste de IsProfilingEnabled e nada mais: nenhum
+relógio é lido e nenhum buffer existe até a primeira vez que ela é ligada.
+*/
+
+// Eventos guardados por thread; quando o anel enche, os mais antigos são descartados
+#define PROFILE_RING_EVENTS (1 << 15)
+#define PROFILE_MAX_THREADS 256
+#define PROFILE_HISTORY_FRAMES 240
+
+// Faixas dos histogramas: a faixa b vai de 2^(b-3) a 2^(b-2) ms; a primeira e a última acumulam as pontas
+#define PROFILE_HISTOGRAM_BUCKETS 14
+
+// Etapas do laço principal acompanhadas nos histogramas; PROFILE_PHASE_FRAME é o frame inteiro
+typedef enum {
+    PROFILE_PHASE_FRAME,
+    PROFILE_PHASE_EVENTS,
+    PROFILE_PHASE_RENDER,
+    PROFILE_PHASE_PRESENT,
+    PROFILE_PHASE_COUNT
+} ProfilePhase;
+
+typedef enum {
+    PROFILE_COUNTER_PIXELS,     // Pixels iterados (sem os preenchidos ou reaproveitados)
+    PROFILE_COUNTER_ITERATIONS, // Soma das contagens desses pixels, o custo sem saídas antecipadas
+    PROFILE_COUNTER_COUNT
+} ProfileCounter;
+
+typedef struct {
+    const char *name;
+    f64 start;
+    i32 phase; // -1 se a zona não é uma etapa do frame
+} ProfileZone;
+
+typedef struct {
+    f64 p50_ms;
+    f64 p99_ms;
+    f64 max_ms;
+    i32 histogram[PROFILE_HISTOGRAM_BUCKETS];
+} ProfilePhaseSummary;
+
+// Resumo dos frames guardados, para o overlay e para o modo sem janela
+typedef struct {
+    i32 frames;
+    ProfilePhaseSummary phases[PROFILE_PHASE_COUNT];
+    i64 pixels;      // Do último frame
+    i64 iterations;  // Iterações de fato calculadas no último frame
+    i64 saved;       // Iterações que as saídas antecipadas pouparam no último frame
+} ProfileSummary;
+
+extern b32 IsProfilingEnabled;
+
+void SetProfilingEnabled(b32 enabled);
+void ProfileRecordZone(const ProfileZone *zone, f64 end);
+void ProfileAddCount(ProfileCounter counter, i64 value);
+
+static inline ProfileZone ProfileBegin(const char *name)
+{
+    ProfileZone zone = {name, 0.0, -1};
+    if (IsProfilingEnabled) zone.start = omp_get_wtime();
+    return zone;
+}
+
+ProfileZone ProfileBeginPhase(ProfilePhase phase);
+
+static inline void ProfileEnd(const ProfileZone *zone)
+{
+    if (IsProfilingEnabled && zone->start > 0.0) ProfileRecordZone(zone, omp_get_wtime());
+}
+
+static inline void ProfileCount(ProfileCounter counter, i64 value)
+{
+    if (IsProfilingEnabled) ProfileAddCount(counter, value);
+}
+
+// Marcam o frame no laço da plataforma; o fim fecha os contadores e alimenta os histogramas
+void ProfileFrameBegin(void);
+void ProfileFrameEnd(void);
+
+b32 GetProfileSummary(ProfileSummary *summary);
+b32 ProfileWriteChromeTrace(const char *path);
+
+// Painel com os tempos, os contadores e o histograma do frame, no canto superior esquerdo
+void ProfileDrawOverlay(OffscreenBuffer *buffer);
+
+#endif
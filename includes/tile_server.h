@@ -0,0 +1,47 @@
+#ifndef TILE_SERVER_H
+#define TILE_SERVER_H
+
+#include <stdio.h>
+
+#include "platform.h"
+#include "mandelbrot.h"
+
+/*
+Servidor de blocos para visualizadores web (platforms/tile_server.c): HTTP/1.1
+mínimo em que GET /<z>/<x>/<y>.png devolve o bloco (x, y) do nível z, no esquema
+das pirâmides de mapas. O nível 0 é um único bloco com o quadrado [-2, 2] x [-2, 2]
+e cada nível divide os blocos do anterior em quatro; ?i=<n> muda o limite de
+iterações. GET /stats devolve os contadores e os percentis de latência.
+
+Os pedidos que chegam juntos viram um lote calculado numa só passada do escalonador,
+os blocos ficam no cache de blocos (renderer/tile_cache.c) e um pedido cujo cliente
+fechou a conexão antes do lote sair é descartado sem ser calculado.
+*/
+
+// Cada bloco servido é formado por (TILE_SERVER_TILE_SIZE / TILE_CACHE_SIZE)² blocos do cache
+#define TILE_SERVER_TILE_SIZE (2 * TILE_CACHE_SIZE)
+#define TILE_SERVER_WORLD_SIZE 4.0
+#define TILE_SERVER_MAX_LEVEL 48
+
+// Quanto o primeiro pedido de um lote espera pelos outros que chegam junto com ele
+#define TILE_SERVER_BATCH_SECONDS 0.002
+
+#define TILE_SERVER_MAX_CONNECTIONS 256
+#define TILE_SERVER_REQUEST_BYTES 4096
+#define TILE_SERVER_SEND_TIMEOUT_SECONDS 2
+#define TILE_SERVER_LATENCY_SAMPLES 4096
+#define TILE_SERVER_REPORT_SECONDS 10.0
+
+// Codificador da imagem de cada bloco (o PNG do modo sem janela)
+typedef b32 TileEncodeFn(FILE *f, OffscreenBuffer *buffer);
+
+typedef struct {
+    const char *address;    // [<host>:]<porta>; sem host, escuta só em 127.0.0.1
+    i32 max_iterations;     // Limite dos pedidos sem ?i=
+    TileEncodeFn *encode;
+} TileServerOptions;
+
+// Atende até o processo ser encerrado; só retorna se não conseguir escutar no endereço
+int TileServerRun(const TileServerOptions *options);
+
+#endif
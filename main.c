@@ -1,153 +1,1283 @@
-#include "platform.h"
-
-#include <math.h>
-#include <stdbool.h>
-#include <omp.h> // Paralelismo
-#include <immintrin.h> // AVX2
-
-#define MAX_ITERATIONS 256
-
-static u32 ColorPalette[MAX_ITERATIONS + 1];
-static bool IsPaletteInitialized = false;
-
-void InitColorPalette(void)
-{
-    if (IsPaletteInitialized) return;
-
-    for (int i = 0; i < MAX_ITERATIONS; ++i)
-    {
-        // Truque matemático para criar um gradiente suave
-        float t = (float)i / (float)MAX_ITERATIONS;
-        
-        // Usando ondas senoidais para gerar RGB baseados na iteração
-        u8 r = (u8)(9 * (1 - t) * t * t * 255);
-        u8 g = (u8)(15 * (1 - t) * (1 - t) * t * 255);
-        u8 b = (u8)(8.5 * (1 - t) * (1 - t) * (1 - t) * 255);
-        ColorPalette[i] = ((u32)0xFF << 24) | ((u32)r << 16) | ((u32)g << 8) | (u32)b;
-    }
-
-    // Os pontos do conjunto são pretos
-    ColorPalette[MAX_ITERATIONS] = 0xFF000000;
-    IsPaletteInitialized = true;
-}
-
-// Função principal de renderização usando AVX2
-void RenderMandelbrotAVX2(OffscreenBuffer *buffer, f32 center_x, f32 center_y, f32 zoom)
-{
-    if (!IsPaletteInitialized) InitColorPalette();
-
-    int width = buffer->width;
-    int height = buffer->height;
-    u32 *pixels = (u32 *)buffer->memory;
-
-    f32 start_x = center_x - (width / 2.0f) * zoom;
-    f32 start_y = center_y - (height / 2.0f) * zoom;
-
-    const __m256 v_threshold = _mm256_set1_ps(4.0f);
-    const __m256 v_two = _mm256_set1_ps(2.0f);
-    const __m256 v_zoom_x = _mm256_set1_ps(zoom);
-    const __m256 v_x_offsets = _mm256_mul_ps(_mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7), v_zoom_x);
-
-    // OpenMP divide as linhas entre os núcleos
-    #pragma omp parallel for schedule(dynamic)
-    for (int y = 0; y < height; ++y) {
-        u32 *row_pixel = pixels + (y * (buffer->pitch / 4));
-        f32 c_im_scalar = start_y + y * zoom;
-        __m256 v_c_im = _mm256_set1_ps(c_im_scalar);
-        
-        int iter_counts[8] __attribute__((aligned(32)));
-
-        int x = 0;
-        // Loop principal AVX
-        for (; x <= width - 8; x += 8)
-        {
-            f32 base_c_re = start_x + x * zoom;
-            __m256 v_c_re = _mm256_add_ps(_mm256_set1_ps(base_c_re), v_x_offsets);
-            __m256 v_z_re = _mm256_setzero_ps();
-            __m256 v_z_im = _mm256_setzero_ps();
-            __m256i v_iterations = _mm256_setzero_si256();
-
-            // Loop de iteração do Mandelbrot
-            for (int i = 0; i < MAX_ITERATIONS; ++i)
-            {
-                /*
-                A fórmula do Mandelbrot é:
-                    Z_{n+1} = Z_n^2 + C
-                Expandindo Z = x + yi:
-                    Z^2 = (x + yi)(x + yi) = x^2 - y^2 + 2xyi
-                A verificação de escape (para otimização) é:
-                    |Z| <= 2, isto é, raiz(x^2 + y^2) <= 2,
-                ou melhor ainda:
-                    x^2 + y^2 <= 4
-                */
-
-                __m256 v_z_re2 = _mm256_mul_ps(v_z_re, v_z_re); // Z_re^2
-                __m256 v_z_im2 = _mm256_mul_ps(v_z_im, v_z_im); // Z_im^2
-                __m256 v_mag2 = _mm256_add_ps(v_z_re2, v_z_im2); // mag^2 = re^2 + im^2
-
-                // Cria uma máscara
-                __m256 v_mask_active = _mm256_cmp_ps(v_mag2, v_threshold, _CMP_LE_OQ);
-
-                // Se a máscara for toda zero, todos os pixels escaparam
-                int mask_bits = _mm256_movemask_ps(v_mask_active);
-                if (mask_bits == 0) break;
-
-                // A máscara 'v_mask_active' tem -1 para pixels ativos
-                v_iterations = _mm256_sub_epi32(v_iterations, _mm256_castps_si256(v_mask_active));
-
-                __m256 v_new_re = _mm256_add_ps(_mm256_sub_ps(v_z_re2, v_z_im2), v_c_re);
-                __m256 v_new_im = _mm256_add_ps(_mm256_mul_ps(v_two, _mm256_mul_ps(v_z_re, v_z_im)), v_c_im);
-
-                // _mm256_blendv_ps seleciona o segundo argumento se a máscara for true
-                v_z_re = _mm256_blendv_ps(v_z_re, v_new_re, v_mask_active);
-                v_z_im = _mm256_blendv_ps(v_z_im, v_new_im, v_mask_active);
-            }
-
-            // Uso do 'storeu' previne crash se o GCC falhar no alinhamento da thread
-            _mm256_storeu_si256((__m256i*)iter_counts, v_iterations);
-
-            // // Loop escalar curto para aplicar as cores nos 8 pixels
-            for (int k = 0; k < 8; ++k)
-            {
-                row_pixel[x + k] = ColorPalette[iter_counts[k]];
-            }
-        }
-
-        // Processa os pixels restantes se a largura não for múltipla de 8
-        for (; x < width; ++x)
-        {
-            f32 c_re = start_x + x * zoom;
-            f32 z_re = 0, z_im = 0, z_re2 = 0, z_im2 = 0;
-            int iteration = 0;
-            while (z_re2 + z_im2 <= 4.0f && iteration < MAX_ITERATIONS)
-            {
-                z_im = 2 * z_re * z_im + c_im_scalar;
-                z_re = z_re2 - z_im2 + c_re;
-                z_re2 = z_re * z_re;
-                z_im2 = z_im * z_im;
-                iteration++;
-            }
-            row_pixel[x] = ColorPalette[iteration];
-        }
-    }
-}
-
-void UpdateAndRender(Input *input, OffscreenBuffer *buffer)
-{
-    static f32 center_x = -0.75f;
-    static f32 center_y = 0.0f;
-    static f32 zoom = 0.004f;
-
-    f32 zoom_factor = 1.0f;
-    if (input->keys[KEY_PLUS].is_ended_down) zoom_factor = 0.92f; // Zoom in
-    if (input->keys[KEY_MINUS].is_ended_down) zoom_factor = 1.087f; // Zoom out
-    zoom *= zoom_factor;
-
-    f32 move_speed = 10.0f * zoom; 
-    if (input->keys[KEY_RIGHT].is_ended_down) center_x += move_speed;
-    if (input->keys[KEY_LEFT].is_ended_down)  center_x -= move_speed;
-    if (input->keys[KEY_DOWN].is_ended_down)  center_y += move_speed;
-    if (input->keys[KEY_UP].is_ended_down)    center_y -= move_speed;
-
-    RenderMandelbrotAVX2(buffer, center_x, center_y, zoom);
+#include "platform.h"
+#include "mandelbrot.h"
+#include "kernels.h" // Aritmética double-double do início de cada linha
+#include "profiler.h"
+
+#include <math.h>
+#include <float.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h> // Paralelismo
+
+/*
+Buffer persistente com as iterações do último frame, de qualquer renderizador. A
+coloração lê dele (e por isso pode ser refeita sem iterar) e, quando is_valid, a
+vista guardada permite reaproveitar pixels se a próxima só se deslocar.
+*/
+typedef struct {
+    i32 *iterations;
+    i32 width;
+    i32 height;
+    HPReal center_x;
+    HPReal center_y;
+    f64 zoom;
+    i32 max_iterations;
+    RenderPrecision precision;
+    bool is_valid;
+    bool has_iterations;
+    bool is_complete;
+} FrameHistory;
+
+/*
+Estado do modo progressivo. A passada p calcula os pixels cujas coordenadas são
+múltiplas de PROGRESSIVE_FIRST_STRIDE >> p e que não foram calculados antes; cada
+amostra nova preenche o seu bloco stride x stride até ser refinada.
+*/
+typedef struct {
+    FrameSetup frame;
+    HPReal center_x;
+    HPReal center_y;
+    i32 width;
+    i32 height;
+    i32 pass;
+    i32 next_row;
+    f64 last_render_seconds;
+    const void *colored_memory; // Buffer que recebeu a última coloração
+    bool is_active;
+    bool is_complete;
+} ProgressiveState;
+
+static FrameHistory History;
+static IncrementalStats LastIncrementalStats;
+static ProgressiveState Progressive;
+static bool IsSubdivisionEnabled = false;
+static bool IsDoubleDoubleEnabled = false;
+
+// Pedidos de cancelamento já feitos, e quantos havia quando a renderização atual começou
+static _Atomic u32 RenderCancelRequests;
+static u32 RenderCancelSnapshot;
+
+typedef struct {
+    const FrameSetup *frame;
+    i32 *iterations;
+    i32 stride;
+    u32 *pixels;
+    i32 pitch;
+} TileRenderContext;
+
+// Função principal de renderização em f32, pelo kernel SIMD escolhido para a CPU
+void RenderMandelbrotF32(OffscreenBuffer *buffer, f32 center_x, f32 center_y, f32 zoom, i32 max_iterations)
+{
+    FrameSetup frame = {0};
+    frame.precision = PRECISION_F32;
+    frame.max_iterations = max_iterations < 1 ? 1 : max_iterations;
+    frame.zoom32 = zoom;
+    frame.start_x32 = center_x - (buffer->width / 2.0f) * zoom;
+    frame.start_y32 = center_y - (buffer->height / 2.0f) * zoom;
+    FrameRender(&frame, buffer);
+}
+
+void RenderMandelbrotF64(OffscreenBuffer *buffer, f64 center_x, f64 center_y, f64 zoom, i32 max_iterations)
+{
+    FrameSetup frame = {0};
+    frame.precision = PRECISION_F64;
+    frame.max_iterations = max_iterations < 1 ? 1 : max_iterations;
+    frame.zoom = zoom;
+    frame.start_x = center_x - (buffer->width / 2.0) * zoom;
+    frame.start_y = center_y - (buffer->height / 2.0) * zoom;
+    FrameRender(&frame, buffer);
+}
+
+/*
+O kernel f32 só é exato enquanto o espaçamento entre pixels (zoom) for bem maior
+que o ULP das coordenadas da vista. Abaixo disso, pixels vizinhos caem no mesmo
+float e a imagem vira blocos; então passamos para o kernel f64, com metade da vazão.
+O mesmo vale para o f64, a partir de onde só a perturbação resolve.
+
+O double-double cobre a faixa logo depois do f64, mas só entra se foi ligado: nas
+vistas medidas a perturbação, com o salto pela série, ficou mais rápida que ele.
+*/
+RenderPrecision ChooseRenderPrecision(f64 center_x, f64 center_y, f64 zoom, i32 width, i32 height)
+{
+    f64 extent_x = fabs(center_x) + 0.5 * width * zoom;
+    f64 extent_y = fabs(center_y) + 0.5 * height * zoom;
+    f64 magnitude = fmax(fmax(extent_x, extent_y), 2.0);
+
+    f64 f32_ulp = magnitude * FLT_EPSILON;
+    if (zoom >= f32_ulp * F32_PRECISION_MARGIN) return PRECISION_F32;
+
+    f64 f64_ulp = magnitude * DBL_EPSILON;
+    if (zoom >= f64_ulp * F64_PRECISION_MARGIN) return PRECISION_F64;
+
+    f64 dd_ulp = magnitude * DD_EPSILON;
+    if (IsDoubleDoubleEnabled && zoom >= dd_ulp * DD_PRECISION_MARGIN) return PRECISION_DD;
+    return PRECISION_DEEP;
+}
+
+RenderPrecision RenderMandelbrot(OffscreenBuffer *buffer, const HPReal *center_x, const HPReal *center_y,
+                                 f64 zoom, i32 max_iterations, RenderPrecision precision)
+{
+    ResetSavedIterations();
+    ResetTileStats();
+
+    f64 approx_x = HPToF64(center_x);
+    f64 approx_y = HPToF64(center_y);
+
+    if (precision == PRECISION_AUTO) {
+        precision = ChooseRenderPrecision(approx_x, approx_y, zoom, buffer->width, buffer->height);
+    }
+
+    if (precision == PRECISION_F32) {
+        RenderMandelbrotF32(buffer, (f32)approx_x, (f32)approx_y, (f32)zoom, max_iterations);
+    } else if (precision == PRECISION_F64) {
+        RenderMandelbrotF64(buffer, approx_x, approx_y, zoom, max_iterations);
+    } else if (precision == PRECISION_DD) {
+        FrameSetup frame;
+        FrameSetupInit(&frame, center_x, center_y, zoom, buffer->width, buffer->height, max_iterations, precision);
+        FrameRender(&frame, buffer);
+    } else {
+        RenderMandelbrotPerturbation(buffer, center_x, center_y, zoom, max_iterations);
+    }
+
+    return precision;
+}
+
+b32 FrameSetupInit(FrameSetup *frame, const HPReal *center_x, const HPReal *center_y, f64 zoom,
+                   i32 width, i32 height, i32 max_iterations, RenderPrecision precision)
+{
+    f64 approx_x = HPToF64(center_x);
+    f64 approx_y = HPToF64(center_y);
+
+    if (precision == PRECISION_AUTO) {
+        precision = ChooseRenderPrecision(approx_x, approx_y, zoom, width, height);
+    }
+    if (max_iterations < 1) max_iterations = 1;
+
+    frame->precision = precision;
+    frame->max_iterations = max_iterations;
+    frame->use_subdivision = IsSubdivisionEnabled;
+
+    // Mesmas contas de RenderMandelbrotF32/F64, para os pixels saírem idênticos
+    frame->zoom32 = (f32)zoom;
+    frame->start_x32 = (f32)approx_x - (width / 2.0f) * frame->zoom32;
+    frame->start_y32 = (f32)approx_y - (height / 2.0f) * frame->zoom32;
+    frame->zoom = zoom;
+    frame->start_x = approx_x - (width / 2.0) * zoom;
+    frame->start_y = approx_y - (height / 2.0) * zoom;
+
+    // O início em ponto fixo e depois em duas partes: hi é o f64 mais próximo e lo o que sobra
+    if (precision == PRECISION_DD) {
+        HPReal start_x = *center_x, start_y = *center_y, hi, rest;
+        HPAddF64(&start_x, -(width / 2.0) * zoom);
+        HPAddF64(&start_y, -(height / 2.0) * zoom);
+
+        frame->start_x_dd.hi = HPToF64(&start_x);
+        HPFromF64(&hi, frame->start_x_dd.hi);
+        HPSub(&rest, &start_x, &hi, HP_MAX_LIMBS);
+        frame->start_x_dd.lo = HPToF64(&rest);
+
+        frame->start_y_dd.hi = HPToF64(&start_y);
+        HPFromF64(&hi, frame->start_y_dd.hi);
+        HPSub(&rest, &start_y, &hi, HP_MAX_LIMBS);
+        frame->start_y_dd.lo = HPToF64(&rest);
+    }
+
+    if (precision == PRECISION_DEEP) {
+        return PerturbationPrepare(center_x, center_y, zoom, width, height, max_iterations);
+    }
+    return true;
+}
+
+// Contadores do frame para a instrumentação: pixels iterados e a soma das suas contagens
+static void CountIteratedPixels(const i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1, i32 step)
+{
+    if (!IsProfilingEnabled || x1 <= x0 || y1 <= y0) return;
+    i64 sum = 0;
+    for (int y = y0; y < y1; ++y) {
+        const i32 *row = iterations + (size_t)y * stride;
+        for (int x = x0; x < x1; x += step) sum += row[x];
+    }
+    ProfileAddCount(PROFILE_COUNTER_PIXELS, (i64)((x1 - x0 + step - 1) / step) * (y1 - y0));
+    ProfileAddCount(PROFILE_COUNTER_ITERATIONS, sum);
+}
+
+void FrameIterateSpan(const FrameSetup *frame, i32 *row_iterations, i32 x0, i32 x1, i32 step, i32 y)
+{
+    switch (frame->precision) {
+        case PRECISION_F32:
+            IterateSpanF32(row_iterations, x0, x1, step, frame->start_x32, frame->start_y32 + y * frame->zoom32,
+                            frame->zoom32, frame->max_iterations);
+            break;
+        case PRECISION_F64:
+            IterateSpanF64(row_iterations, x0, x1, step, frame->start_x, frame->start_y + y * frame->zoom,
+                               frame->zoom, frame->max_iterations);
+            break;
+        case PRECISION_DD:
+            IterateSpanDD(row_iterations, x0, x1, step, frame->start_x_dd, DDAddF64(frame->start_y_dd, y * frame->zoom),
+                          frame->zoom, frame->max_iterations);
+            break;
+        default:
+            PerturbationIterateSpan(row_iterations, x0, x1, step, y);
+            break;
+    }
+    CountIteratedPixels(row_iterations, 0, x0, 0, x1, 1, step);
+}
+
+// Pixels [y0, y1) da coluna x; 'iterations' aponta para o pixel (0, 0) de um buffer com 'stride' pixels por linha
+void FrameIterateColumn(const FrameSetup *frame, i32 *iterations, i32 stride, i32 y0, i32 y1, i32 x)
+{
+    switch (frame->precision) {
+        case PRECISION_F32:
+            IterateColumnF32(iterations + x, stride, y0, y1, frame->start_x32 + x * frame->zoom32,
+                              frame->start_y32, frame->zoom32, frame->max_iterations);
+            break;
+        case PRECISION_F64:
+            IterateColumnF64(iterations + x, stride, y0, y1, frame->start_x + x * frame->zoom,
+                                 frame->start_y, frame->zoom, frame->max_iterations);
+            break;
+        case PRECISION_DD:
+            IterateColumnDD(iterations + x, stride, y0, y1, DDAddF64(frame->start_x_dd, x * frame->zoom),
+                            frame->start_y_dd, frame->zoom, frame->max_iterations);
+            break;
+        default:
+            PerturbationIterateColumn(iterations + x, stride, y0, y1, x);
+            break;
+    }
+    CountIteratedPixels(iterations, stride, x, y0, x + 1, y1, 1);
+}
+
+// Bloco [x0, x1) x [y0, y1) inteiro de uma vez, para os kernels com recarga de lanes; no deep zoom vai linha a linha
+void FrameIterateBlock(const FrameSetup *frame, i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1)
+{
+    switch (frame->precision) {
+        case PRECISION_F32:
+            IterateBlockF32(iterations, stride, x0, y0, x1, y1, frame->start_x32, frame->start_y32,
+                            frame->zoom32, frame->max_iterations);
+            break;
+        case PRECISION_F64:
+            IterateBlockF64(iterations, stride, x0, y0, x1, y1, frame->start_x, frame->start_y,
+                            frame->zoom, frame->max_iterations);
+            break;
+        case PRECISION_DD:
+            for (int y = y0; y < y1; ++y) {
+                IterateSpanDD(iterations + (size_t)y * stride, x0, x1, 1, frame->start_x_dd,
+                              DDAddF64(frame->start_y_dd, y * frame->zoom), frame->zoom, frame->max_iterations);
+            }
+            break;
+        default:
+            for (int y = y0; y < y1; ++y) {
+                PerturbationIterateSpan(iterations + (size_t)y * stride, x0, x1, 1, y);
+            }
+            break;
+    }
+    CountIteratedPixels(iterations, stride, x0, y0, x1, y1, 1);
+}
+
+static void IterateTile(void *context, i32 x0, i32 y0, i32 x1, i32 y1)
+{
+    TileRenderContext *tile = context;
+    ProfileZone zone = ProfileBegin("tile");
+    FrameIterateBlock(tile->frame, tile->iterations, tile->stride, x0, y0, x1, y1);
+    ProfileEnd(&zone);
+}
+
+// O bloco é colorido logo depois de calculado, enquanto as iterações ainda estão no cache
+static void RenderTile(void *context, i32 x0, i32 y0, i32 x1, i32 y1)
+{
+    TileRenderContext *tile = context;
+    ProfileZone zone = ProfileBegin("tile");
+    FrameIterateBlock(tile->frame, tile->iterations, tile->stride, x0, y0, x1, y1);
+    if (tile->pixels) {
+        for (int y = y0; y < y1; ++y) {
+            ColorizeRow(tile->pixels + (size_t)y * tile->pitch + x0, tile->iterations + (size_t)y * tile->stride + x0,
+                        x1 - x0, tile->frame->max_iterations);
+        }
+    }
+    ProfileEnd(&zone);
+}
+
+// Garante o buffer de iterações do tamanho da tela; um buffer novo não tem vista para reaproveitar
+static i32 *GetFrameIterations(i32 width, i32 height)
+{
+    if (History.width != width || History.height != height) {
+        free(History.iterations);
+        History.iterations = malloc(sizeof(i32) * (size_t)width * height);
+        History.width = width;
+        History.height = height;
+        History.is_valid = false;
+        History.has_iterations = false;
+        History.is_complete = false;
+        if (!History.iterations) History.width = History.height = 0;
+    }
+    return History.iterations;
+}
+
+/*
+Cancelamento pedido por outra thread: a janela, quando roda a renderização numa
+thread à parte, avisa que a vista mudou e o frame em andamento já não serve. Os
+renderizadores param no próximo bloco (ou lote de linhas, ou tarefa da subdivisão)
+e não marcam o frame como completo; a plataforma descarta o buffer.
+*/
+void CancelRender(void)
+{
+    atomic_fetch_add(&RenderCancelRequests, 1);
+}
+
+b32 IsRenderCancelled(void)
+{
+    return atomic_load_explicit(&RenderCancelRequests, memory_order_relaxed) != RenderCancelSnapshot;
+}
+
+void FrameRender(const FrameSetup *frame, OffscreenBuffer *buffer)
+{
+    int width = buffer->width;
+    int height = buffer->height;
+    if (width <= 0 || height <= 0) return;
+
+    i32 *iterations = GetFrameIterations(width, height);
+    if (!iterations) return;
+
+    // O buffer passa a ter outra vista, que não sabemos descrever aqui
+    History.is_valid = false;
+    History.has_iterations = true;
+    History.is_complete = true;
+    History.max_iterations = frame->max_iterations;
+    Progressive.is_active = false;
+
+    // A equalização precisa do histograma do frame inteiro, então só colore no fim
+    b32 is_equalized = IsHistogramEqualizationEnabled();
+    if (!is_equalized) PrepareColorLookup(NULL, 0, 0, 0, frame->max_iterations);
+
+    TileRenderContext context = {frame, iterations, width, is_equalized ? NULL : (u32 *)buffer->memory,
+                                 buffer->pitch / 4};
+    ScheduleTiles(0, 0, width, height, RenderTile, &context);
+    if (IsRenderCancelled()) {
+        History.is_complete = false;
+        return;
+    }
+
+    if (is_equalized) ColorizeFrame(buffer, iterations, width, frame->max_iterations);
+}
+
+void FrameIterateRegion(const FrameSetup *frame, i32 *iterations, i32 x0, i32 y0, i32 x1, i32 y1)
+{
+    if (x1 <= x0 || y1 <= y0) return;
+
+    // Os kernels endereçam pelo pixel da vista inteira, então a origem recua até o pixel (0, 0)
+    i32 stride = x1 - x0;
+    TileRenderContext context = {frame, iterations - ((ptrdiff_t)y0 * stride + x0), stride, NULL, 0};
+    ScheduleTiles(x0, y0, x1, y1, IterateTile, &context);
+}
+
+b32 GetIterationLimitStats(IterationLimitStats *stats)
+{
+    if (!History.has_iterations || !History.is_complete) return false;
+
+    i32 max_iterations = History.max_iterations;
+    i32 late_threshold = max_iterations / 2;
+    i32 width = History.width;
+    i64 sampled = 0, limit = 0, late = 0;
+    i32 max_escaped = 0;
+
+    #pragma omp parallel for schedule(static) reduction(+:sampled, limit, late) reduction(max:max_escaped)
+    for (int y = 0; y < History.height; y += ADAPTIVE_SAMPLE_STRIDE) {
+        const i32 *row = History.iterations + (size_t)y * width;
+        for (int x = 0; x < width; ++x) {
+            i32 iteration = row[x];
+            if (iteration >= max_iterations) {
+                ++limit;
+            } else {
+                if (iteration >= late_threshold) ++late;
+                if (iteration > max_escaped) max_escaped = iteration;
+            }
+        }
+        sampled += width;
+    }
+
+    stats->max_iterations = max_iterations;
+    stats->max_escaped = max_escaped;
+    stats->sampled_pixels = sampled;
+    stats->limit_pixels = limit;
+    stats->late_pixels = late;
+    return true;
+}
+
+i64 GetFrameIterationCount(void)
+{
+    if (!History.has_iterations || !History.is_complete) return 0;
+
+    i64 total = 0;
+    size_t count = (size_t)History.width * History.height;
+    #pragma omp parallel for schedule(static) reduction(+:total)
+    for (size_t i = 0; i < count; ++i) total += History.iterations[i];
+    return total;
+}
+
+/*
+O piso vem da profundidade: cada oitava de zoom abaixo de ADAPTIVE_REFERENCE_ZOOM
+pede mais iterações, porque as órbitas perto da fronteira ficam mais longas. Em
+cima dele decide o último frame completo. Se há pixels no limite e uma fração
+relevante dos outros só escapou na metade de cima dele, parte dos que bateram no
+limite também escaparia (e está preta por engano), então o limite dobra. Se
+nenhum pixel passou de um quarto do limite, o resto só serve ao interior e o
+limite cai pela metade. Depois de dobrar ainda há pixels acima de um quarto, e
+depois de cair não há nenhum na metade de cima; então uma vista parada não oscila.
+*/
+i32 ChooseAdaptiveIterations(i32 current_iterations, f64 zoom)
+{
+    i32 next = current_iterations;
+
+    IterationLimitStats stats;
+    if (GetIterationLimitStats(&stats) && stats.max_iterations == current_iterations && stats.sampled_pixels) {
+        f64 late_fraction = (f64)stats.late_pixels / (f64)stats.sampled_pixels;
+        if (stats.limit_pixels && late_fraction > ADAPTIVE_LATE_FRACTION) next = current_iterations * 2;
+        else if (stats.max_escaped < current_iterations / 4) next = current_iterations / 2;
+    }
+
+    f64 octaves = log2(ADAPTIVE_REFERENCE_ZOOM / zoom);
+    f64 depth_floor = ADAPTIVE_MIN_ITERATIONS + (octaves > 0.0 ? octaves * ADAPTIVE_ITERATIONS_PER_OCTAVE : 0.0);
+    if (depth_floor > ADAPTIVE_MAX_ITERATIONS) depth_floor = ADAPTIVE_MAX_ITERATIONS;
+    if (next < (i32)depth_floor) next = (i32)depth_floor;
+    if (next > ADAPTIVE_MAX_ITERATIONS) next = ADAPTIVE_MAX_ITERATIONS;
+    return next;
+}
+
+b32 RecolorMandelbrot(OffscreenBuffer *buffer)
+{
+    if (!History.has_iterations || History.width != buffer->width || History.height != buffer->height) return false;
+    ColorizeFrame(buffer, History.iterations, History.width, History.max_iterations);
+    return true;
+}
+
+// Calcula o retângulo [x0, x1) x [y0, y1) de um buffer de iterações com 'stride' pixels por linha
+static void FrameIterateRect(const FrameSetup *frame, i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1)
+{
+    if (x0 >= x1) return;
+
+    if (frame->use_subdivision) {
+        SubdivisionIterateRect(frame, iterations, stride, x0, y0, x1, y1);
+        return;
+    }
+
+    TileRenderContext context = {frame, iterations, stride, NULL, 0};
+    ScheduleTiles(x0, y0, x1, y1, IterateTile, &context);
+}
+
+// Desloca o conteúdo do buffer: o novo pixel (x, y) é o antigo (x + shift_x, y + shift_y)
+static void ShiftIterations(i32 *iterations, i32 width, i32 height, i32 shift_x, i32 shift_y)
+{
+    int src_x = shift_x > 0 ? shift_x : 0;
+    int dst_x = shift_x < 0 ? -shift_x : 0;
+    size_t count = (size_t)(width - abs(shift_x));
+
+    if (shift_y >= 0) {
+        for (int y = 0; y < height - shift_y; ++y) {
+            memmove(iterations + (size_t)y * width + dst_x,
+                    iterations + (size_t)(y + shift_y) * width + src_x, count * sizeof(i32));
+        }
+    } else {
+        for (int y = height - 1; y >= -shift_y; --y) {
+            memmove(iterations + (size_t)y * width + dst_x,
+                    iterations + (size_t)(y + shift_y) * width + src_x, count * sizeof(i32));
+        }
+    }
+}
+
+/*
+Descobre se a vista nova é a anterior deslocada por um número inteiro de pixels.
+As setinhas andam 10 * zoom, então o deslocamento só não é inteiro por arredondamento.
+*/
+static bool FindPanShift(const FrameHistory *history, const FrameSetup *frame, const HPReal *center_x,
+                         const HPReal *center_y, i32 width, i32 height, i32 *shift_x, i32 *shift_y)
+{
+    if (!history->is_valid || history->width != width || history->height != height) return false;
+    if (history->zoom != frame->zoom || history->max_iterations != frame->max_iterations) return false;
+    if (history->precision != frame->precision) return false;
+
+    HPReal delta_x, delta_y;
+    HPSub(&delta_x, center_x, &history->center_x, HP_MAX_LIMBS);
+    HPSub(&delta_y, center_y, &history->center_y, HP_MAX_LIMBS);
+    f64 pixels_x = HPToF64(&delta_x) / frame->zoom;
+    f64 pixels_y = HPToF64(&delta_y) / frame->zoom;
+
+    if (fabs(pixels_x) >= width || fabs(pixels_y) >= height) return false;
+
+    f64 rounded_x = round(pixels_x);
+    f64 rounded_y = round(pixels_y);
+    if (fabs(pixels_x - rounded_x) > PAN_SUBPIXEL_TOLERANCE) return false;
+    if (fabs(pixels_y - rounded_y) > PAN_SUBPIXEL_TOLERANCE) return false;
+
+    *shift_x = (i32)rounded_x;
+    *shift_y = (i32)rounded_y;
+    return true;
+}
+
+RenderPrecision RenderMandelbrotIncremental(OffscreenBuffer *buffer, const HPReal *center_x, const HPReal *center_y,
+                                            f64 zoom, i32 max_iterations, RenderPrecision precision)
+{
+    ResetSavedIterations();
+    ResetTileStats();
+
+    int width = buffer->width;
+    int height = buffer->height;
+    if (width <= 0 || height <= 0) return precision;
+
+    FrameSetup frame;
+    if (!FrameSetupInit(&frame, center_x, center_y, zoom, width, height, max_iterations, precision)) {
+        return frame.precision;
+    }
+
+    i32 *iterations = GetFrameIterations(width, height);
+    if (!iterations) return frame.precision;
+    i32 shift_x = 0, shift_y = 0;
+    i64 computed = (i64)width * height;
+    ResetSubdivisionStats();
+
+    if (FindPanShift(&History, &frame, center_x, center_y, width, height, &shift_x, &shift_y)) {
+        ShiftIterations(iterations, width, height, shift_x, shift_y);
+
+        // Faixas horizontais expostas ocupam a largura toda; as verticais, só o resto das linhas
+        int rows_y0 = shift_y > 0 ? height - shift_y : 0;
+        int rows_y1 = shift_y > 0 ? height : -shift_y;
+        int kept_y0 = shift_y > 0 ? 0 : -shift_y;
+        int kept_y1 = shift_y > 0 ? height - shift_y : height;
+        int cols_x0 = shift_x > 0 ? width - shift_x : 0;
+        int cols_x1 = shift_x > 0 ? width : -shift_x;
+
+        FrameIterateRect(&frame, iterations, width, 0, rows_y0, width, rows_y1);
+        FrameIterateRect(&frame, iterations, width, cols_x0, kept_y0, cols_x1, kept_y1);
+
+        computed = (i64)width * abs(shift_y) + (i64)abs(shift_x) * (kept_y1 - kept_y0);
+    } else {
+        FrameIterateRect(&frame, iterations, width, 0, 0, width, height);
+    }
+
+    // Parte do buffer ficou sem calcular (e, num deslocamento, o resto já foi movido)
+    if (IsRenderCancelled()) {
+        History.is_valid = false;
+        History.is_complete = false;
+        return frame.precision;
+    }
+
+    History.center_x = *center_x;
+    History.center_y = *center_y;
+    History.zoom = frame.zoom;
+    History.max_iterations = frame.max_iterations;
+    History.precision = frame.precision;
+    History.is_valid = true;
+    History.has_iterations = true;
+    History.is_complete = true;
+
+    LastIncrementalStats.computed_pixels = computed;
+    LastIncrementalStats.reused_pixels = (i64)width * height - computed;
+
+    ColorizeFrame(buffer, iterations, width, frame.max_iterations);
+
+    return frame.precision;
+}
+
+IncrementalStats GetIncrementalStats(void)
+{
+    return LastIncrementalStats;
+}
+
+void SetSubdivisionEnabled(b32 enabled)
+{
+    IsSubdivisionEnabled = enabled;
+}
+
+void SetDoubleDoubleEnabled(b32 enabled)
+{
+    IsDoubleDoubleEnabled = enabled;
+}
+
+RenderPrecision RenderMandelbrotSubdivided(OffscreenBuffer *buffer, const HPReal *center_x, const HPReal *center_y,
+                                           f64 zoom, i32 max_iterations, RenderPrecision precision)
+{
+    ResetSavedIterations();
+    ResetTileStats();
+
+    int width = buffer->width;
+    int height = buffer->height;
+    if (width <= 0 || height <= 0) return precision;
+
+    FrameSetup frame;
+    if (!FrameSetupInit(&frame, center_x, center_y, zoom, width, height, max_iterations, precision)) {
+        return frame.precision;
+    }
+
+    // A subdivisão lê a borda dos vizinhos, então precisa do frame inteiro de iterações e não só de uma linha
+    i32 *iterations = GetFrameIterations(width, height);
+    if (!iterations) return frame.precision;
+    History.is_valid = false;
+    History.has_iterations = true;
+    History.is_complete = true;
+    History.max_iterations = frame.max_iterations;
+    Progressive.is_active = false;
+
+    ResetSubdivisionStats();
+    SubdivisionIterateRect(&frame, iterations, width, 0, 0, width, height);
+    if (IsRenderCancelled()) {
+        History.is_complete = false;
+        return frame.precision;
+    }
+
+    ColorizeFrame(buffer, iterations, width, frame.max_iterations);
+    return frame.precision;
+}
+
+// Divisão que arredonda para baixo também com negativos, para achar o bloco de um pixel global
+static i64 FloorDivide(i64 value, i64 divisor)
+{
+    i64 quotient = value / divisor;
+    return (value % divisor != 0 && value < 0) ? quotient - 1 : quotient;
+}
+
+/*
+Frame montado com o cache de blocos. A grade dos blocos é absoluta para cada zoom,
+então a vista é arredondada para o pixel global mais próximo: o frame pode ficar até
+meio pixel deslocado em relação ao dos outros renderizadores, e em troca qualquer
+vista com o mesmo zoom, de um deslocamento ou de uma ida e volta no zoom, reaproveita
+os blocos em comum. Os índices globais de pixel só são exatos num f64 enquanto a
+vista cabe no kernel f64; depois disso o frame vai para o incremental.
+*/
+static i32 **CachedTiles;
+static TileCacheKey *MissingKeys;
+static i32 **MissingBuffers;
+static i32 CachedTilesCapacity;
+
+// Blocos da grade absoluta que a vista arredondada cobre; origin é o pixel global do canto
+typedef struct {
+    i64 origin_x;
+    i64 origin_y;
+    i64 first_tile_x;
+    i64 first_tile_y;
+    i32 tiles_x;
+    i32 tiles_y;
+} CacheTileGrid;
+
+static CacheTileGrid GetCacheTileGrid(f64 approx_x, f64 approx_y, f64 zoom, int width, int height)
+{
+    CacheTileGrid grid;
+    grid.origin_x = (i64)floor(approx_x / zoom - width / 2.0 + 0.5);
+    grid.origin_y = (i64)floor(approx_y / zoom - height / 2.0 + 0.5);
+    grid.first_tile_x = FloorDivide(grid.origin_x, TILE_CACHE_SIZE);
+    grid.first_tile_y = FloorDivide(grid.origin_y, TILE_CACHE_SIZE);
+    grid.tiles_x = (i32)(FloorDivide(grid.origin_x + width - 1, TILE_CACHE_SIZE) - grid.first_tile_x + 1);
+    grid.tiles_y = (i32)(FloorDivide(grid.origin_y + height - 1, TILE_CACHE_SIZE) - grid.first_tile_y + 1);
+    return grid;
+}
+
+/*
+Os blocos a calcular ficam lado a lado num retângulo virtual de count blocos de
+largura, e uma única passada do escalonador reparte todos eles entre as threads,
+em vez de uma passada por bloco. Cada bloco tem o seu FrameSetup, com o início na
+grade absoluta do zoom.
+*/
+typedef struct {
+    const FrameSetup *frames;
+    i32 *const *tiles;
+} CacheFillContext;
+
+static FrameSetup *FillFrames;
+static i32 FillFramesCapacity;
+
+static void IterateCacheTiles(void *context, i32 x0, i32 y0, i32 x1, i32 y1)
+{
+    CacheFillContext *fill = context;
+    ProfileZone zone = ProfileBegin("tile");
+    // Um bloco do escalonador pode atravessar a divisa entre dois blocos do cache
+    while (x0 < x1) {
+        i32 index = x0 / TILE_CACHE_SIZE;
+        i32 tile_x0 = index * TILE_CACHE_SIZE;
+        i32 end = tile_x0 + TILE_CACHE_SIZE < x1 ? tile_x0 + TILE_CACHE_SIZE : x1;
+        FrameIterateBlock(&fill->frames[index], fill->tiles[index], TILE_CACHE_SIZE, x0 - tile_x0, y0, end - tile_x0, y1);
+        x0 = end;
+    }
+    ProfileEnd(&zone);
+}
+
+b32 RenderCacheTiles(const TileCacheKey *keys, i32 *const *tiles, i32 count)
+{
+    if (count <= 0) return true;
+    if (count > FillFramesCapacity) {
+        free(FillFrames);
+        FillFrames = malloc(sizeof(FrameSetup) * count);
+        FillFramesCapacity = FillFrames ? count : 0;
+        if (!FillFrames) return false;
+    }
+
+    for (i32 i = 0; i < count; ++i) {
+        FrameSetup *frame = &FillFrames[i];
+        memset(frame, 0, sizeof(*frame));
+        frame->precision = keys[i].precision;
+        frame->max_iterations = keys[i].max_iterations;
+        frame->zoom = keys[i].zoom;
+        frame->start_x = (f64)(keys[i].tile_x * TILE_CACHE_SIZE) * keys[i].zoom;
+        frame->start_y = (f64)(keys[i].tile_y * TILE_CACHE_SIZE) * keys[i].zoom;
+        frame->zoom32 = (f32)frame->zoom;
+        frame->start_x32 = (f32)frame->start_x;
+        frame->start_y32 = (f32)frame->start_y;
+    }
+
+    CacheFillContext context = {FillFrames, tiles};
+    ScheduleTiles(0, 0, count * TILE_CACHE_SIZE, TILE_CACHE_SIZE, IterateCacheTiles, &context);
+    return !IsRenderCancelled();
+}
+
+RenderPrecision RenderMandelbrotCached(OffscreenBuffer *buffer, const HPReal *center_x, const HPReal *center_y,
+                                       f64 zoom, i32 max_iterations, RenderPrecision precision)
+{
+    int width = buffer->width;
+    int height = buffer->height;
+    if (width <= 0 || height <= 0) return precision;
+
+    f64 approx_x = HPToF64(center_x);
+    f64 approx_y = HPToF64(center_y);
+    if (precision == PRECISION_AUTO) precision = ChooseRenderPrecision(approx_x, approx_y, zoom, width, height);
+    if (precision == PRECISION_DD || precision == PRECISION_DEEP) {
+        return RenderMandelbrotIncremental(buffer, center_x, center_y, zoom, max_iterations, precision);
+    }
+    if (max_iterations < 1) max_iterations = 1;
+
+    ResetSavedIterations();
+    ResetTileStats();
+
+    CacheTileGrid grid = GetCacheTileGrid(approx_x, approx_y, zoom, width, height);
+    i64 origin_x = grid.origin_x, origin_y = grid.origin_y;
+    i64 first_tile_x = grid.first_tile_x, first_tile_y = grid.first_tile_y;
+    i32 tiles_x = grid.tiles_x, tiles_y = grid.tiles_y;
+    i32 tile_count = tiles_x * tiles_y;
+
+    i32 *iterations = GetFrameIterations(width, height);
+    if (tile_count > CachedTilesCapacity) {
+        free(CachedTiles);
+        free(MissingKeys);
+        free(MissingBuffers);
+        CachedTiles = malloc(sizeof(i32 *) * tile_count);
+        MissingKeys = malloc(sizeof(TileCacheKey) * tile_count);
+        MissingBuffers = malloc(sizeof(i32 *) * tile_count);
+        CachedTilesCapacity = (CachedTiles && MissingKeys && MissingBuffers) ? tile_count : 0;
+    }
+    if (!iterations || !CachedTilesCapacity) return precision;
+
+    TileCacheKey key = {zoom, 0, 0, max_iterations, precision};
+    TileCacheBeginFrame();
+    i32 missing_count = 0;
+    bool is_cache_full = false;
+    for (i32 tile = 0; tile < tile_count; ++tile) {
+        key.tile_x = first_tile_x + tile % tiles_x;
+        key.tile_y = first_tile_y + tile / tiles_x;
+        CachedTiles[tile] = TileCacheFind(&key);
+        if (CachedTiles[tile]) continue;
+        CachedTiles[tile] = TileCacheInsert(&key);
+        if (!CachedTiles[tile]) {
+            is_cache_full = true;
+            break;
+        }
+        MissingKeys[missing_count] = key;
+        MissingBuffers[missing_count++] = CachedTiles[tile];
+    }
+
+    b32 is_filled = !is_cache_full && RenderCacheTiles(MissingKeys, MissingBuffers, missing_count);
+
+    // Blocos reservados e não calculados (ou calculados pela metade) não podem ficar no cache
+    if (!is_filled) {
+        for (i32 i = 0; i < missing_count; ++i) TileCacheRemove(&MissingKeys[i]);
+        // Uma tela maior que o cache inteiro não tem como ser montada por ele
+        if (is_cache_full) return RenderMandelbrotIncremental(buffer, center_x, center_y, zoom, max_iterations, precision);
+        History.is_valid = false;
+        History.is_complete = false;
+        return precision;
+    }
+
+    for (i32 tile = 0; tile < tile_count; ++tile) {
+        i64 tile_x0 = (first_tile_x + tile % tiles_x) * TILE_CACHE_SIZE - origin_x;
+        i64 tile_y0 = (first_tile_y + tile / tiles_x) * TILE_CACHE_SIZE - origin_y;
+        i32 x0 = tile_x0 > 0 ? (i32)tile_x0 : 0;
+        i32 y0 = tile_y0 > 0 ? (i32)tile_y0 : 0;
+        i32 x1 = tile_x0 + TILE_CACHE_SIZE < width ? (i32)(tile_x0 + TILE_CACHE_SIZE) : width;
+        i32 y1 = tile_y0 + TILE_CACHE_SIZE < height ? (i32)(tile_y0 + TILE_CACHE_SIZE) : height;
+        for (i32 y = y0; y < y1; ++y) {
+            memcpy(iterations + (size_t)y * width + x0,
+                   CachedTiles[tile] + (size_t)(y - tile_y0) * TILE_CACHE_SIZE + (x0 - tile_x0),
+                   sizeof(i32) * (x1 - x0));
+        }
+    }
+
+    // A vista arredondada não é a que o incremental saberia deslocar
+    History.is_valid = false;
+    History.has_iterations = true;
+    History.is_complete = true;
+    History.max_iterations = max_iterations;
+    Progressive.is_active = false;
+
+    ColorizeFrame(buffer, iterations, width, max_iterations);
+    return precision;
+}
+
+// Fração dos blocos da vista que já estão no cache, sem tocar nele; 'precision' é f32 ou f64
+static f32 GetCachedViewCoverage(const HPReal *center_x, const HPReal *center_y, f64 zoom, i32 width, i32 height,
+                                 i32 max_iterations, RenderPrecision precision)
+{
+    if (width <= 0 || height <= 0) return 0.0f;
+    CacheTileGrid grid = GetCacheTileGrid(HPToF64(center_x), HPToF64(center_y), zoom, width, height);
+    TileCacheKey key = {zoom, 0, 0, max_iterations < 1 ? 1 : max_iterations, precision};
+    i32 hits = 0;
+    for (i32 ty = 0; ty < grid.tiles_y; ++ty) {
+        for (i32 tx = 0; tx < grid.tiles_x; ++tx) {
+            key.tile_x = grid.first_tile_x + tx;
+            key.tile_y = grid.first_tile_y + ty;
+            hits += TileCacheContains(&key) ? 1 : 0;
+        }
+    }
+    return (f32)hits / (f32)(grid.tiles_x * grid.tiles_y);
+}
+
+/*
+Resolução dinâmica: a vista é calculada numa grade menor, com o mesmo centro e
+pixels 1/scale vezes maiores, e ampliada para o buffer pelo vizinho mais próximo.
+O custo cai com scale², então a janela troca nitidez por frames enquanto a vista
+se mexe e calcula a resolução cheia quando ela para.
+*/
+static OffscreenBuffer ScaledBuffer;
+static i32 *ScaledColumns;
+static i32 ScaledColumnsCapacity;
+
+RenderPrecision RenderMandelbrotScaled(OffscreenBuffer *buffer, const HPReal *center_x, const HPReal *center_y,
+                                       f64 zoom, i32 max_iterations, RenderPrecision precision, f32 scale)
+{
+    int width = buffer->width;
+    int height = buffer->height;
+    if (width <= 0 || height <= 0) return precision;
+    if (scale >= 1.0f) return RenderMandelbrotIncremental(buffer, center_x, center_y, zoom, max_iterations, precision);
+    if (scale < DYNAMIC_RESOLUTION_MIN_SCALE) scale = DYNAMIC_RESOLUTION_MIN_SCALE;
+
+    // A largura define o fator; a altura arredonda para cima para a grade cobrir o buffer inteiro
+    i32 scaled_width = (i32)(width * scale + 0.5f);
+    if (scaled_width < 1) scaled_width = 1;
+    f64 factor = (f64)width / scaled_width;
+    i32 scaled_height = (i32)ceil(height / factor);
+    if (scaled_height < 1) scaled_height = 1;
+
+    if (ScaledBuffer.width != scaled_width || ScaledBuffer.height != scaled_height || !ScaledBuffer.memory) {
+        free(ScaledBuffer.memory);
+        ScaledBuffer.memory = malloc(sizeof(u32) * (size_t)scaled_width * scaled_height);
+        ScaledBuffer.width = scaled_width;
+        ScaledBuffer.height = scaled_height;
+        ScaledBuffer.bytes_per_pixel = 4;
+        ScaledBuffer.pitch = scaled_width * 4;
+    }
+    if (width > ScaledColumnsCapacity) {
+        free(ScaledColumns);
+        ScaledColumns = malloc(sizeof(i32) * width);
+        ScaledColumnsCapacity = ScaledColumns ? width : 0;
+    }
+    if (!ScaledBuffer.memory || !ScaledColumns) {
+        return RenderMandelbrotIncremental(buffer, center_x, center_y, zoom, max_iterations, precision);
+    }
+
+    // As iterações guardadas passam a ser da grade menor, que o progressivo não sabe continuar
+    Progressive.is_active = false;
+    precision = RenderMandelbrotIncremental(&ScaledBuffer, center_x, center_y, zoom * factor, max_iterations, precision);
+    if (IsRenderCancelled()) return precision;
+
+    for (int x = 0; x < width; ++x) {
+        i32 source = (i32)((x + 0.5) / factor);
+        ScaledColumns[x] = source < scaled_width ? source : scaled_width - 1;
+    }
+
+    const u32 *source_pixels = ScaledBuffer.memory;
+    #pragma omp parallel for schedule(static)
+    for (int y = 0; y < height; ++y) {
+        i32 source_y = (i32)((y + 0.5) / factor);
+        if (source_y >= scaled_height) source_y = scaled_height - 1;
+        const u32 *source_row = source_pixels + (size_t)source_y * scaled_width;
+        u32 *row = (u32 *)((u8 *)buffer->memory + (size_t)y * buffer->pitch);
+        for (int x = 0; x < width; ++x) row[x] = source_row[ScaledColumns[x]];
+    }
+    return precision;
+}
+
+f32 ChooseRenderScale(f32 scale, f64 frame_seconds)
+{
+    if (frame_seconds <= 0.0) return scale;
+
+    // O custo é proporcional aos pixels, scale², então a escala que teria cumprido a meta é esta
+    f64 ideal = scale * sqrt(DYNAMIC_RESOLUTION_TARGET_SECONDS / frame_seconds);
+
+    // Desce de uma vez e sobe aos poucos: um frame rápido pode ser só uma região mais barata passando
+    if (ideal > scale * 1.25) ideal = scale * 1.25;
+    if (ideal < DYNAMIC_RESOLUTION_MIN_SCALE) ideal = DYNAMIC_RESOLUTION_MIN_SCALE;
+    if (ideal > 1.0) ideal = 1.0;
+    return (f32)ideal;
+}
+
+static bool ProgressiveSameView(const ProgressiveState *state, const HPReal *center_x, const HPReal *center_y,
+                                f64 zoom, i32 width, i32 height, i32 max_iterations, RenderPrecision precision)
+{
+    if (!state->is_active || state->width != width || state->height != height) return false;
+    if (state->frame.zoom != zoom || state->frame.max_iterations != max_iterations) return false;
+    if (precision != PRECISION_AUTO && precision != state->frame.precision) return false;
+    return memcmp(&state->center_x, center_x, sizeof(HPReal)) == 0 &&
+           memcmp(&state->center_y, center_y, sizeof(HPReal)) == 0;
+}
+
+// Linha y da passada com esse stride: só as colunas ainda não calculadas nas passadas anteriores
+static void ProgressiveIterateRow(const FrameSetup *frame, i32 *iterations, i32 width, i32 height,
+                                  i32 stride, bool is_first_pass, i32 y)
+{
+    i32 *row = iterations + (size_t)y * width;
+    int x0 = 0, step = stride;
+    if (!is_first_pass && (y % (2 * stride)) == 0) {
+        x0 = stride;
+        step = 2 * stride;
+    }
+    FrameIterateSpan(frame, row, x0, width, step, y);
+
+    // Cada amostra cobre o seu bloco enquanto a próxima passada não chega
+    if (stride == 1) return;
+    int block_y1 = (y + stride < height) ? y + stride : height;
+    for (int x = x0; x < width; x += step) {
+        int block_x1 = (x + stride < width) ? x + stride : width;
+        i32 value = row[x];
+        for (int by = y; by < block_y1; ++by) {
+            i32 *block_row = iterations + (size_t)by * width;
+            for (int bx = x; bx < block_x1; ++bx) block_row[bx] = value;
+        }
+    }
+}
+
+/*
+Renderização progressiva: a primeira chamada sempre completa a grade grossa e as
+seguintes refinam até esgotar o orçamento de tempo, retomando de onde pararam. O
+orçamento vem do último time_delta: o que passou da renderização anterior é custo
+fixo da plataforma (eventos, apresentação) e o resto do frame-alvo fica para nós.
+*/
+b32 RenderMandelbrotProgressive(OffscreenBuffer *buffer, const HPReal *center_x, const HPReal *center_y,
+                                f64 zoom, i32 max_iterations, RenderPrecision precision, f32 time_delta)
+{
+    ResetSavedIterations();
+    ResetTileStats();
+
+    int width = buffer->width;
+    int height = buffer->height;
+    if (width <= 0 || height <= 0) return true;
+    if (max_iterations < 1) max_iterations = 1;
+
+    f64 start_time = omp_get_wtime();
+
+    if (!ProgressiveSameView(&Progressive, center_x, center_y, zoom, width, height, max_iterations, precision)) {
+        // Deslocamento puro de um frame completo: as faixas expostas saem mais baratas que recomeçar
+        if (Progressive.is_complete) {
+            FrameSetup frame;
+            i32 shift_x, shift_y;
+            if (FrameSetupInit(&frame, center_x, center_y, zoom, width, height, max_iterations, precision) &&
+                FindPanShift(&History, &frame, center_x, center_y, width, height, &shift_x, &shift_y)) {
+                RenderMandelbrotIncremental(buffer, center_x, center_y, zoom, max_iterations, precision);
+                // Cancelado no meio: as faixas expostas ficaram velhas e a mesma vista não pode ser dada como pronta
+                if (IsRenderCancelled()) {
+                    Progressive.is_active = false;
+                    Progressive.is_complete = false;
+                    return false;
+                }
+                Progressive.frame = frame;
+                Progressive.colored_memory = buffer->memory;
+                Progressive.center_x = *center_x;
+                Progressive.center_y = *center_y;
+                Progressive.last_render_seconds = omp_get_wtime() - start_time;
+                return true;
+            }
+        }
+
+        if (!GetFrameIterations(width, height)) {
+            Progressive.is_active = false;
+            return true;
+        }
+        History.is_valid = false;
+
+        Progressive.is_active = FrameSetupInit(&Progressive.frame, center_x, center_y, zoom, width, height,
+                                               max_iterations, precision);
+        if (!Progressive.is_active) return true;
+        History.has_iterations = true;
+        History.is_complete = false;
+        History.max_iterations = Progressive.frame.max_iterations;
+        Progressive.center_x = *center_x;
+        Progressive.center_y = *center_y;
+        Progressive.width = width;
+        Progressive.height = height;
+        Progressive.pass = 0;
+        Progressive.next_row = 0;
+        Progressive.is_complete = false;
+    }
+
+    if (!Progressive.is_complete) {
+        f64 overhead = time_delta - Progressive.last_render_seconds;
+        f64 budget = PROGRESSIVE_TARGET_FRAME_SECONDS - (overhead > 0.0 ? overhead : 0.0);
+        if (budget < PROGRESSIVE_MIN_BUDGET_SECONDS) budget = PROGRESSIVE_MIN_BUDGET_SECONDS;
+
+        const FrameSetup *frame = &Progressive.frame;
+        i32 *iterations = History.iterations;
+        int batch_rows = PROGRESSIVE_BATCH_ROWS * omp_get_max_threads();
+
+        while (!Progressive.is_complete && !IsRenderCancelled()) {
+            i32 stride = PROGRESSIVE_FIRST_STRIDE >> Progressive.pass;
+            bool is_first_pass = (Progressive.pass == 0);
+            int row_count = (height - Progressive.next_row + stride - 1) / stride;
+            if (row_count > batch_rows) row_count = batch_rows;
+            int first_row = Progressive.next_row;
+
+            ProfileZone zone = ProfileBegin("progressive");
+            #pragma omp parallel for schedule(dynamic)
+            for (int r = 0; r < row_count; ++r) {
+                ProgressiveIterateRow(frame, iterations, width, height, stride, is_first_pass, first_row + r * stride);
+            }
+            ProfileEnd(&zone);
+
+            Progressive.next_row += row_count * stride;
+            if (Progressive.next_row >= height) {
+                Progressive.next_row = 0;
+                if (stride == 1) Progressive.is_complete = true;
+                else ++Progressive.pass;
+            }
+
+            // A grade grossa é barata e sempre termina; daí em diante respeitamos o orçamento
+            if (Progressive.pass > 0 && omp_get_wtime() - start_time >= budget) break;
+        }
+
+        if (Progressive.is_complete) {
+            History.center_x = *center_x;
+            History.center_y = *center_y;
+            History.zoom = frame->zoom;
+            History.max_iterations = frame->max_iterations;
+            History.precision = frame->precision;
+            History.is_valid = true;
+            History.is_complete = true;
+        }
+
+        if (IsRenderCancelled()) return false;
+        ColorizeFrame(buffer, iterations, width, frame->max_iterations);
+        Progressive.colored_memory = buffer->memory;
+    } else if (buffer->memory != Progressive.colored_memory) {
+        // Com buffers em rodízio (buffer triplo da janela), este ainda pode ter um frame antigo
+        ColorizeFrame(buffer, History.iterations, width, Progressive.frame.max_iterations);
+        Progressive.colored_memory = buffer->memory;
+    }
+
+    Progressive.last_render_seconds = omp_get_wtime() - start_time;
+    return Progressive.is_complete;
+}
+
+/*
+Tudo o que decide a imagem da janela. Se nada disso mudou desde um frame completo,
+UpdateAndRender não tem o que fazer e deixa a plataforma dormir até a próxima entrada.
+*/
+typedef struct {
+    HPReal center_x;
+    HPReal center_y;
+    f64 zoom;
+    i32 max_iterations;
+    i32 width;
+    i32 height;
+    i32 palette_cycle;
+    b32 is_equalized;
+    b32 is_progressive;
+    b32 is_subdivided;
+    b32 is_overlay_visible;
+    b32 is_tile_cached;
+    b32 is_double_double;
+} ViewState;
+
+// Pressionada desde a cópia anterior da entrada: terminou abaixada depois de mudar, ou desceu e
+// subiu entre duas cópias (um toque rápido durante um frame longo)
+static bool WasKeyPressed(Input *input, KeyId key)
+{
+    ButtonState *state = &input->keys[key];
+    return state->half_transition_count >= 2 || (state->is_ended_down && state->half_transition_count > 0);
+}
+
+b32 UpdateAndRender(Input *input, OffscreenBuffer *buffer)
+{
+    // O centro fica em ponto fixo para permitir deep zoom; o zoom em f64 vai até ~1e-300
+    static HPReal center_x;
+    static HPReal center_y;
+    static i32 zoom_level = 0; // zoom = 0.004 * 2^(-zoom_level / ZOOM_LEVELS_PER_OCTAVE)
+    static bool is_view_initialized = false;
+    static bool is_progressive = true;
+    static bool is_subdivided = false;
+    static bool is_cycling = false;
+    static bool is_equalized = false;
+    static f32 cycle_phase = 0.0f;
+    static i32 max_iterations = DEFAULT_MAX_ITERATIONS;
+    static bool is_adaptive = true;
+    static bool is_overlay_visible = false;
+    static i32 trace_count = 0;
+    static ViewState last_view;
+    static bool is_last_view_complete = false;
+    static bool is_dynamic_resolution = true;
+    static f32 render_scale = 1.0f;
+    static bool is_tile_cached = true;
+    static bool is_double_double = false;
+
+    // Cancelamentos pedidos antes daqui valiam para frames anteriores
+    RenderCancelSnapshot = atomic_load(&RenderCancelRequests);
+
+    if (!is_view_initialized) {
+        HPFromF64(&center_x, -0.75);
+        HPFromF64(&center_y, 0.0);
+        is_view_initialized = true;
+    }
+
+    // P alterna entre o modo progressivo e o frame completo a cada chamada
+    if (WasKeyPressed(input, KEY_P)) is_progressive = !is_progressive;
+
+    // M liga a subdivisão de Mariani-Silver, que precisa do frame completo e por isso desliga o progressivo
+    if (WasKeyPressed(input, KEY_M)) {
+        is_subdivided = !is_subdivided;
+        SetSubdivisionEnabled(is_subdivided);
+    }
+
+    // C anima a paleta e H liga a equalização por histograma; nenhuma das duas itera pixels
+    bool are_colors_changed = false;
+    if (WasKeyPressed(input, KEY_C)) is_cycling = !is_cycling;
+    if (WasKeyPressed(input, KEY_H)) {
+        is_equalized = !is_equalized;
+        SetHistogramEqualization(is_equalized);
+        are_colors_changed = true;
+    }
+    if (is_cycling) {
+        cycle_phase += input->time_delta * PALETTE_CYCLE_COLORS_PER_SECOND;
+        if (cycle_phase >= 1.0f) {
+            SetPaletteCycle(GetPaletteCycle() + (i32)cycle_phase);
+            cycle_phase -= (f32)(i32)cycle_phase;
+            are_colors_changed = true;
+        }
+    }
+
+    // O mostra o painel de instrumentação; tirá-lo só pede uma recoloração para apagar o canto
+    if (WasKeyPressed(input, KEY_O)) {
+        is_overlay_visible = !is_overlay_visible;
+        if (is_overlay_visible) SetProfilingEnabled(true);
+        else are_colors_changed = true;
+    }
+
+    // T grava o trace do Chrome dos últimos frames; com a instrumentação desligada, o primeiro T só a liga
+    if (WasKeyPressed(input, KEY_T)) {
+        if (!IsProfilingEnabled) {
+            SetProfilingEnabled(true);
+            fprintf(stderr, "Instrumentação ligada; T de novo grava o trace\n");
+        } else {
+            char path[32];
+            snprintf(path, sizeof(path), "trace-%03d.json", trace_count++);
+            if (ProfileWriteChromeTrace(path)) fprintf(stderr, "Trace gravado em %s\n", path);
+            else fprintf(stderr, "Não consegui gravar %s\n", path);
+        }
+    }
+
+    // R liga a resolução dinâmica: enquanto a vista se mexe, a grade interna encolhe até caber na meta de frame
+    if (WasKeyPressed(input, KEY_R)) is_dynamic_resolution = !is_dynamic_resolution;
+
+    // K liga o cache de blocos, que guarda as iterações de cada zoom para as vistas revisitadas
+    if (WasKeyPressed(input, KEY_K)) is_tile_cached = !is_tile_cached;
+
+    // D põe o double-double entre o f64 e a perturbação na escolha automática da precisão
+    if (WasKeyPressed(input, KEY_D)) {
+        is_double_double = !is_double_double;
+        SetDoubleDoubleEnabled(is_double_double);
+    }
+
+    // A liga o limite adaptativo; I e U dobram e cortam pela metade o limite na mão, o que desliga o adaptativo
+    if (WasKeyPressed(input, KEY_A)) is_adaptive = !is_adaptive;
+    if (WasKeyPressed(input, KEY_I) && max_iterations < ADAPTIVE_MAX_ITERATIONS) {
+        max_iterations *= 2;
+        is_adaptive = false;
+    }
+    if (WasKeyPressed(input, KEY_U) && max_iterations > 1) {
+        max_iterations /= 2;
+        is_adaptive = false;
+    }
+
+    // O zoom sai do nível inteiro, e não de multiplicações acumuladas, para voltar bit a bit ao mesmo valor
+    i32 zoom_step = 0;
+    if (input->keys[KEY_PLUS].is_ended_down) zoom_step = 1;   // Zoom in
+    if (input->keys[KEY_MINUS].is_ended_down) zoom_step = -1; // Zoom out
+    zoom_level += zoom_step;
+    f64 zoom = 0.004 * exp2(-zoom_level / (f64)ZOOM_LEVELS_PER_OCTAVE);
+
+    f64 move_speed = 10.0 * zoom; 
+    if (input->keys[KEY_RIGHT].is_ended_down) HPAddF64(&center_x, move_speed);
+    if (input->keys[KEY_LEFT].is_ended_down)  HPAddF64(&center_x, -move_speed);
+    if (input->keys[KEY_DOWN].is_ended_down)  HPAddF64(&center_y, move_speed);
+    if (input->keys[KEY_UP].is_ended_down)    HPAddF64(&center_y, -move_speed);
+
+    if (is_adaptive) max_iterations = ChooseAdaptiveIterations(max_iterations, zoom);
+
+    ViewState view;
+    memset(&view, 0, sizeof(view)); // O memcmp abaixo também compara o enchimento
+    view.center_x = center_x;
+    view.center_y = center_y;
+    view.zoom = zoom;
+    view.max_iterations = max_iterations;
+    view.width = buffer->width;
+    view.height = buffer->height;
+    view.palette_cycle = GetPaletteCycle();
+    view.is_equalized = is_equalized;
+    view.is_progressive = is_progressive;
+    view.is_subdivided = is_subdivided;
+    view.is_overlay_visible = is_overlay_visible;
+    view.is_tile_cached = is_tile_cached;
+    view.is_double_double = is_double_double;
+
+    // A animação da paleta precisa das chamadas para o tempo andar, mesmo quando a cor ainda não mudou
+    if (is_last_view_complete && !is_cycling && memcmp(&view, &last_view, sizeof(view)) == 0) return false;
+
+    bool is_interacting = zoom_step != 0 || input->keys[KEY_RIGHT].is_ended_down ||
+                          input->keys[KEY_LEFT].is_ended_down || input->keys[KEY_DOWN].is_ended_down ||
+                          input->keys[KEY_UP].is_ended_down;
+
+    // O cache não serve depois do f64 nem a subdivisão; fora isso, atende a interação e o modo não progressivo
+    RenderPrecision view_precision = ChooseRenderPrecision(HPToF64(&center_x), HPToF64(&center_y), zoom,
+                                                           buffer->width, buffer->height);
+    bool is_cacheable = is_tile_cached && !is_subdivided &&
+                        (view_precision == PRECISION_F32 || view_precision == PRECISION_F64);
+
+    /*
+    Na interação o cache só compensa se a vista já está quase toda nele ou se é um deslocamento
+    dentro do mesmo zoom, que só calcula as faixas novas. Cada passo de zoom é um nível novo da
+    grade, uma falta completa: esses frames vão para a resolução dinâmica.
+    */
+    bool is_cache_used = is_cacheable && (is_interacting || !is_progressive);
+    if (is_cache_used && is_interacting && is_dynamic_resolution && zoom_step != 0) {
+        is_cache_used = GetCachedViewCoverage(&center_x, &center_y, zoom, buffer->width, buffer->height,
+                                              max_iterations, view_precision) >= TILE_CACHE_WARM_FRACTION;
+    }
+
+    bool is_complete = true;
+    if (is_cache_used) {
+        RenderMandelbrotCached(buffer, &center_x, &center_y, zoom, max_iterations, PRECISION_AUTO);
+    } else if (is_dynamic_resolution && is_interacting) {
+        f64 start = omp_get_wtime();
+        RenderMandelbrotScaled(buffer, &center_x, &center_y, zoom, max_iterations, PRECISION_AUTO, render_scale);
+        render_scale = ChooseRenderScale(render_scale, omp_get_wtime() - start);
+        // Quando a vista parar, a próxima chamada faz o frame em resolução cheia
+        is_complete = false;
+    } else if (is_progressive && !is_subdivided) {
+        is_complete = RenderMandelbrotProgressive(buffer, &center_x, &center_y, zoom, max_iterations, PRECISION_AUTO,
+                                                  input->time_delta);
+    } else {
+        // Um deslocamento puro só recalcula as faixas que entraram na tela
+        RenderMandelbrotIncremental(buffer, &center_x, &center_y, zoom, max_iterations, PRECISION_AUTO);
+    }
+
+    // Um frame progressivo já completo não é colorido de novo pelo renderizador
+    if (are_colors_changed) RecolorMandelbrot(buffer);
+
+    if (is_overlay_visible) ProfileDrawOverlay(buffer);
+
+    last_view = view;
+    is_last_view_complete = is_complete && !IsRenderCancelled();
+    return true;
 }
\ No newline at end of file
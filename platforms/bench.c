@@ -0,0 +1,379 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <omp.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "platform.h"
+#include "mandelbrot.h"
+
+/*
+Suíte de benchmark (make bench). Roda cada kernel suportado pela CPU sobre vistas
+fixas, em várias resoluções e quantidades de threads, e grava uma linha por
+combinação em CSV ou JSON para comparar commits. As vistas são definidas pela
+largura no plano complexo, então todas as resoluções mostram a mesma imagem.
+*/
+
+#define BENCH_MAX_LIST 16
+
+typedef struct {
+    const char *name;
+    const char *center_x;
+    const char *center_y;
+    f64 extent;
+    i32 iterations;
+    RenderPrecision precision; // PRECISION_AUTO escolhe pelo zoom, como a janela
+} BenchView;
+
+static const BenchView BenchViews[] = {
+    {"full",     "-0.75",         "0",            3.2,    1000, PRECISION_AUTO},
+    {"seahorse", "-0.7436447860", "0.1318252536", 0.025,  1000, PRECISION_AUTO},
+    {"interior", "-0.1226",       "0.7449",       0.05,   2000, PRECISION_AUTO}, // Dentro do bulbo de período 3
+    {"escaped",  "0.6",           "0.9",          1.0,    1000, PRECISION_AUTO}, // Quase tudo escapa em poucas iterações
+    {"dd",       "-1.7497219297423385", "0",      1e-13,  2000, PRECISION_DD}, // Além do f64: o kernel double-double
+};
+
+static const char *const BenchKernels[] = {"scalar", "sse2", "avx2", "avx512", "fma"};
+
+typedef struct {
+    i32 width;
+    i32 height;
+} BenchSize;
+
+typedef struct {
+    const char *output_path;
+    const char *revision;
+    b32 json;
+    i32 runs;
+    i32 warmup;
+    BenchSize sizes[BENCH_MAX_LIST];
+    i32 size_count;
+    i32 threads[BENCH_MAX_LIST];
+    i32 thread_count;
+    const char *kernels;
+    const char *views;
+} BenchOptions;
+
+typedef struct {
+    const char *kernel;
+    const char *view;
+    i32 width;
+    i32 height;
+    i32 threads;
+    i32 max_iterations;
+    i64 iterations;
+    i64 saved_iterations;
+    f64 p50_seconds;
+    f64 p99_seconds;
+    f64 mean_seconds;
+    f64 efficiency;
+} BenchResult;
+
+static f64 BenchGetSeconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (f64)counter.QuadPart / (f64)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1000000000.0;
+#endif
+}
+
+static int BenchCompareF64(const void *a, const void *b)
+{
+    f64 x = *(const f64 *)a, y = *(const f64 *)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil pelo posto mais próximo; com poucas execuções o p99 é o pior frame
+static f64 BenchPercentile(const f64 *sorted, i32 count, f64 q)
+{
+    i32 rank = (i32)(q * count + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+// Vírgula separa os itens; NULL ou vazio aceita todos
+static b32 BenchListContains(const char *list, const char *name)
+{
+    if (!list || !*list) return 1;
+    size_t length = strlen(name);
+    for (const char *p = list; p; p = strchr(p, ',')) {
+        if (*p == ',') ++p;
+        if (strncmp(p, name, length) == 0 && (p[length] == ',' || p[length] == 0)) return 1;
+    }
+    return 0;
+}
+
+static b32 BenchParseSizes(const char *text, BenchOptions *options)
+{
+    options->size_count = 0;
+    for (const char *p = text; p && *p; ) {
+        int w, h;
+        if (sscanf(p, "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0) return 0;
+        if (options->size_count == BENCH_MAX_LIST) return 0;
+        options->sizes[options->size_count++] = (BenchSize){w, h};
+        p = strchr(p, ',');
+        if (p) ++p;
+    }
+    return options->size_count > 0;
+}
+
+static b32 BenchParseThreads(const char *text, BenchOptions *options)
+{
+    options->thread_count = 0;
+    for (const char *p = text; p && *p; ) {
+        int threads = atoi(p);
+        if (threads <= 0 || options->thread_count == BENCH_MAX_LIST) return 0;
+        options->threads[options->thread_count++] = threads;
+        p = strchr(p, ',');
+        if (p) ++p;
+    }
+    return options->thread_count > 0;
+}
+
+// 1, 2, 4, ... até o número de processadores, que entra mesmo sem ser potência de 2
+static void BenchDefaultThreads(BenchOptions *options)
+{
+    int processors = omp_get_num_procs();
+    options->thread_count = 0;
+    for (int threads = 1; threads < processors && options->thread_count < BENCH_MAX_LIST - 1; threads *= 2) {
+        options->threads[options->thread_count++] = threads;
+    }
+    options->threads[options->thread_count++] = processors;
+}
+
+static void BenchPrintUsage(const char *program)
+{
+    fprintf(stderr,
+            "Uso: %s [opções]\n"
+            "  -o, --output <arq>     Arquivo de saída (padrão: saída padrão)\n"
+            "      --json             Grava JSON em vez de CSV\n"
+            "      --revision <r>     Identificação gravada em cada linha (ex.: o commit)\n"
+            "  -r, --runs <n>         Frames medidos por combinação (padrão 10)\n"
+            "  -w, --warmup <n>       Frames descartados antes de medir (padrão 2)\n"
+            "  -s, --sizes <lista>    Resoluções, ex.: 640x360,1920x1080\n"
+            "  -t, --threads <lista>  Quantidades de threads, ex.: 1,2,4 (padrão: potências de 2 até os núcleos)\n"
+            "  -k, --kernels <lista>  Kernels a medir (padrão: todos os suportados)\n"
+            "  -v, --views <lista>    full, seahorse, interior, escaped, dd (padrão: todas)\n"
+            "      --quick            Uma resolução pequena e 3 frames, para conferir se a suíte roda\n",
+            program);
+}
+
+static b32 BenchParseOptions(int argc, char **argv, BenchOptions *options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--help") == 0) return 0;
+        if (strcmp(arg, "--json") == 0) {
+            options->json = 1;
+            continue;
+        }
+        if (strcmp(arg, "--quick") == 0) {
+            options->runs = 3;
+            options->warmup = 1;
+            BenchParseSizes("320x180", options);
+            continue;
+        }
+        if (!value) {
+            fprintf(stderr, "Opção sem valor: %s\n", arg);
+            return 0;
+        }
+
+        if (strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) options->output_path = value;
+        else if (strcmp(arg, "--revision") == 0) options->revision = value;
+        else if (strcmp(arg, "-r") == 0 || strcmp(arg, "--runs") == 0) options->runs = atoi(value);
+        else if (strcmp(arg, "-w") == 0 || strcmp(arg, "--warmup") == 0) options->warmup = atoi(value);
+        else if (strcmp(arg, "-k") == 0 || strcmp(arg, "--kernels") == 0) options->kernels = value;
+        else if (strcmp(arg, "-v") == 0 || strcmp(arg, "--views") == 0) options->views = value;
+        else if (strcmp(arg, "-s") == 0 || strcmp(arg, "--sizes") == 0) {
+            if (!BenchParseSizes(value, options)) {
+                fprintf(stderr, "Lista de resoluções inválida: %s\n", value);
+                return 0;
+            }
+        }
+        else if (strcmp(arg, "-t") == 0 || strcmp(arg, "--threads") == 0) {
+            if (!BenchParseThreads(value, options)) {
+                fprintf(stderr, "Lista de threads inválida: %s\n", value);
+                return 0;
+            }
+        }
+        else {
+            fprintf(stderr, "Opção desconhecida: %s\n", arg);
+            return 0;
+        }
+        ++i;
+    }
+
+    if (options->runs <= 0 || options->warmup < 0) {
+        fprintf(stderr, "Execuções precisam ser positivas e o aquecimento não pode ser negativo\n");
+        return 0;
+    }
+    return 1;
+}
+
+// Mede uma combinação; o kernel e as threads já estão escolhidos
+static b32 BenchRun(const BenchView *view, i32 width, i32 height, const BenchOptions *options, BenchResult *result)
+{
+    OffscreenBuffer buffer = {0};
+    buffer.width = width;
+    buffer.height = height;
+    buffer.bytes_per_pixel = 4;
+    buffer.pitch = width * 4;
+    buffer.memory = calloc((size_t)width * height, 4);
+    f64 *times = malloc(sizeof(f64) * options->runs);
+    if (!buffer.memory || !times) {
+        free(buffer.memory);
+        free(times);
+        return 0;
+    }
+
+    HPReal center_x, center_y;
+    HPFromString(&center_x, view->center_x);
+    HPFromString(&center_y, view->center_y);
+    f64 zoom = view->extent / width;
+
+    f64 total = 0.0;
+    for (int run = -options->warmup; run < options->runs; ++run) {
+        f64 start = BenchGetSeconds();
+        RenderMandelbrot(&buffer, &center_x, &center_y, zoom, view->iterations, view->precision);
+        f64 elapsed = BenchGetSeconds() - start;
+        if (run < 0) continue;
+        times[run] = elapsed;
+        total += elapsed;
+    }
+
+    qsort(times, options->runs, sizeof(f64), BenchCompareF64);
+    result->view = view->name;
+    result->width = width;
+    result->height = height;
+    result->max_iterations = view->iterations;
+    result->iterations = GetFrameIterationCount();
+    result->saved_iterations = GetSavedIterations();
+    result->p50_seconds = BenchPercentile(times, options->runs, 0.50);
+    result->p99_seconds = BenchPercentile(times, options->runs, 0.99);
+    result->mean_seconds = total / options->runs;
+
+    free(buffer.memory);
+    free(times);
+    return 1;
+}
+
+static void BenchWriteCSVHeader(FILE *f)
+{
+    fprintf(f, "revision,kernel,view,width,height,threads,runs,max_iterations,iterations,saved_iterations,"
+               "mpixel_per_s,giter_per_s,p50_ms,p99_ms,mean_ms,scaling_efficiency\n");
+}
+
+static void BenchWriteResult(FILE *f, const BenchOptions *options, const BenchResult *r, b32 is_first)
+{
+    f64 mpixels = (f64)r->width * r->height / 1000000.0;
+    f64 mpixel_per_s = mpixels / r->p50_seconds;
+    // Só as iterações executadas: as que o cardioide, os bulbos e a periodicidade pularam não custam nada
+    f64 giter_per_s = (f64)(r->iterations - r->saved_iterations) / 1000000000.0 / r->p50_seconds;
+
+    if (options->json) {
+        fprintf(f, "%s    {\"revision\": \"%s\", \"kernel\": \"%s\", \"view\": \"%s\", \"width\": %d, \"height\": %d, "
+                   "\"threads\": %d, \"runs\": %d, \"max_iterations\": %d, \"iterations\": %lld, "
+                   "\"saved_iterations\": %lld, \"mpixel_per_s\": %.3f, \"giter_per_s\": %.4f, \"p50_ms\": %.4f, "
+                   "\"p99_ms\": %.4f, \"mean_ms\": %.4f, \"scaling_efficiency\": %.4f}",
+                is_first ? "" : ",\n", options->revision, r->kernel, r->view, r->width, r->height, r->threads,
+                options->runs, r->max_iterations, (long long)r->iterations, (long long)r->saved_iterations,
+                mpixel_per_s, giter_per_s, r->p50_seconds * 1000.0, r->p99_seconds * 1000.0,
+                r->mean_seconds * 1000.0, r->efficiency);
+    } else {
+        fprintf(f, "%s,%s,%s,%d,%d,%d,%d,%d,%lld,%lld,%.3f,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+                options->revision, r->kernel, r->view, r->width, r->height, r->threads, options->runs,
+                r->max_iterations, (long long)r->iterations, (long long)r->saved_iterations, mpixel_per_s,
+                giter_per_s, r->p50_seconds * 1000.0, r->p99_seconds * 1000.0, r->mean_seconds * 1000.0,
+                r->efficiency);
+    }
+    fflush(f);
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options = {0};
+    options.revision = "unknown";
+    options.runs = 10;
+    options.warmup = 2;
+    BenchParseSizes("640x360,1280x720,1920x1080", &options);
+    BenchDefaultThreads(&options);
+
+    if (!BenchParseOptions(argc, argv, &options)) {
+        BenchPrintUsage(argv[0]);
+        return 1;
+    }
+
+    FILE *f = stdout;
+    if (options.output_path) {
+        f = fopen(options.output_path, "w");
+        if (!f) {
+            fprintf(stderr, "Falha ao abrir %s\n", options.output_path);
+            return 1;
+        }
+    }
+
+    InitColorPalette();
+    if (options.json) fprintf(f, "[\n");
+    else BenchWriteCSVHeader(f);
+
+    b32 is_first = 1;
+    for (size_t k = 0; k < sizeof(BenchKernels) / sizeof(BenchKernels[0]); ++k) {
+        const char *kernel = BenchKernels[k];
+        if (!BenchListContains(options.kernels, kernel)) continue;
+        if (!SelectIterationKernel(kernel)) {
+            fprintf(stderr, "bench: kernel %s não suportado por esta CPU, pulando\n", kernel);
+            continue;
+        }
+
+        for (size_t v = 0; v < sizeof(BenchViews) / sizeof(BenchViews[0]); ++v) {
+            const BenchView *view = &BenchViews[v];
+            if (!BenchListContains(options.views, view->name)) continue;
+
+            for (int s = 0; s < options.size_count; ++s) {
+                // A eficiência compara cada contagem de threads com a primeira da lista
+                f64 base_cost = 0.0;
+                for (int t = 0; t < options.thread_count; ++t) {
+                    i32 threads = options.threads[t];
+                    omp_set_num_threads(threads);
+
+                    BenchResult result = {0};
+                    result.kernel = kernel;
+                    result.threads = threads;
+                    if (!BenchRun(view, options.sizes[s].width, options.sizes[s].height, &options, &result)) {
+                        fprintf(stderr, "bench: sem memória para %dx%d\n", options.sizes[s].width, options.sizes[s].height);
+                        continue;
+                    }
+
+                    f64 cost = result.p50_seconds * threads;
+                    if (t == 0) base_cost = cost;
+                    result.efficiency = base_cost / cost;
+
+                    fprintf(stderr, "bench: %s %s %dx%d %d threads: p50 %.3f ms\n", kernel, view->name,
+                            result.width, result.height, threads, result.p50_seconds * 1000.0);
+                    BenchWriteResult(f, &options, &result, is_first);
+                    is_first = 0;
+                }
+            }
+        }
+    }
+
+    if (options.json) fprintf(f, "\n]\n");
+    if (f != stdout) fclose(f);
+    return 0;
+}
@@ -0,0 +1,643 @@
+#define _POSIX_C_SOURCE 200809L // getaddrinfo, nanosleep, setenv e MSG_NOSIGNAL
+
+#include "platform.h"
+#include "mandelbrot.h"
+#include "distributed.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <omp.h>
+
+/*
+Protocolo: mensagens binárias com os inteiros em little-endian, seja qual for a
+máquina, para coordenador e workers poderem rodar em hosts diferentes.
+
+  pedido:   "MBJ1", id do bloco, x0, y0, x1, y1, largura, altura, limite de
+            iterações, precisão, bits do zoom (8 bytes) e os dois centros, cada um
+            com o sinal e os HP_MAX_LIMBS limbs
+  resposta: "MBR1", id do bloco, tamanho comprimido e as iterações comprimidas
+
+O coordenador fecha a conexão quando a imagem termina, e é assim que o worker sabe
+que acabou. Não há mensagem de erro: um worker com problema fecha a conexão e os
+seus blocos voltam para a fila como os de um worker que caiu.
+*/
+#define JOB_MESSAGE_BYTES (4 + 4 * 9 + 8 + 2 * 4 * (1 + HP_MAX_LIMBS))
+#define RESULT_HEADER_BYTES 12
+
+// Pior caso da compressão: um valor que não repete ocupa no máximo 5 bytes
+#define COMPRESSED_BOUND(count) ((size_t)(count) * 5)
+
+static void PutU32LE(u8 *out, u32 value)
+{
+    out[0] = (u8)value;
+    out[1] = (u8)(value >> 8);
+    out[2] = (u8)(value >> 16);
+    out[3] = (u8)(value >> 24);
+}
+
+static u32 GetU32LE(const u8 *in)
+{
+    return (u32)in[0] | ((u32)in[1] << 8) | ((u32)in[2] << 16) | ((u32)in[3] << 24);
+}
+
+static void PutHPReal(u8 *out, const HPReal *value)
+{
+    PutU32LE(out, value->negative ? 1 : 0);
+    for (int i = 0; i < HP_MAX_LIMBS; ++i) PutU32LE(out + 4 + 4 * i, value->limbs[i]);
+}
+
+static void GetHPReal(const u8 *in, HPReal *value)
+{
+    value->negative = GetU32LE(in) != 0;
+    for (int i = 0; i < HP_MAX_LIMBS; ++i) value->limbs[i] = GetU32LE(in + 4 + 4 * i);
+}
+
+static void PackJob(u8 *out, u32 id, const DistributedView *view, i32 x0, i32 y0, i32 x1, i32 y1)
+{
+    u64 zoom_bits;
+    memcpy(&zoom_bits, &view->zoom, sizeof(zoom_bits));
+
+    memcpy(out, "MBJ1", 4);
+    const u32 fields[9] = {id, (u32)x0, (u32)y0, (u32)x1, (u32)y1, (u32)view->width, (u32)view->height,
+                           (u32)view->max_iterations, (u32)view->precision};
+    for (int i = 0; i < 9; ++i) PutU32LE(out + 4 + 4 * i, fields[i]);
+    PutU32LE(out + 40, (u32)zoom_bits);
+    PutU32LE(out + 44, (u32)(zoom_bits >> 32));
+    PutHPReal(out + 48, &view->center_x);
+    PutHPReal(out + 48 + 4 * (1 + HP_MAX_LIMBS), &view->center_y);
+}
+
+// Confere o que o worker vai usar como índice: um pedido fora da vista seria escrita fora do buffer
+static b32 UnpackJob(const u8 *in, u32 *id, DistributedView *view, i32 rect[4])
+{
+    if (memcmp(in, "MBJ1", 4) != 0) return 0;
+
+    *id = GetU32LE(in + 4);
+    for (int i = 0; i < 4; ++i) rect[i] = (i32)GetU32LE(in + 8 + 4 * i);
+    view->width = (i32)GetU32LE(in + 24);
+    view->height = (i32)GetU32LE(in + 28);
+    view->max_iterations = (i32)GetU32LE(in + 32);
+    u32 precision = GetU32LE(in + 36);
+    u64 zoom_bits = GetU32LE(in + 40) | ((u64)GetU32LE(in + 44) << 32);
+    memcpy(&view->zoom, &zoom_bits, sizeof(zoom_bits));
+    GetHPReal(in + 48, &view->center_x);
+    GetHPReal(in + 48 + 4 * (1 + HP_MAX_LIMBS), &view->center_y);
+
+    if (precision < PRECISION_F32 || precision > PRECISION_DEEP) return 0;
+    view->precision = (RenderPrecision)precision;
+    return view->width > 0 && view->height > 0 && view->max_iterations > 0 && view->zoom > 0.0 &&
+           rect[0] >= 0 && rect[1] >= 0 && rect[0] < rect[2] && rect[1] < rect[3] &&
+           rect[2] <= view->width && rect[3] <= view->height &&
+           (i64)(rect[2] - rect[0]) * (rect[3] - rect[1]) <= (i64)DISTRIBUTED_TILE_SIZE * DISTRIBUTED_TILE_SIZE;
+}
+
+// ---------------------------------------------------------------------------
+// Compressão das iterações
+// ---------------------------------------------------------------------------
+
+/*
+Pixels vizinhos costumam ter contagens próximas ou iguais (o interior inteiro fica
+no limite), então cada valor vira a diferença para o anterior, em zigzag e varint,
+e uma diferença zero leva junto quantos valores seguintes também se repetem. Um
+bloco de 256x256 de 256 KB costuma virar poucas dezenas de KB.
+*/
+static u8 *PutVarint(u8 *out, u32 value)
+{
+    while (value >= 0x80) {
+        *out++ = (u8)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (u8)value;
+    return out;
+}
+
+static const u8 *GetVarint(const u8 *in, const u8 *end, u32 *value)
+{
+    u32 result = 0;
+    for (int shift = 0; shift < 35 && in < end; shift += 7) {
+        u8 byte = *in++;
+        result |= (u32)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return in;
+        }
+    }
+    return NULL;
+}
+
+static size_t CompressIterations(const i32 *values, i32 count, u8 *out)
+{
+    u8 *cursor = out;
+    u32 previous = 0;
+    for (i32 i = 0; i < count;) {
+        u32 delta = (u32)values[i] - previous;
+        cursor = PutVarint(cursor, (delta << 1) ^ (0u - (delta >> 31)));
+        previous = (u32)values[i++];
+        if (delta == 0) {
+            u32 run = 0;
+            while (i < count && (u32)values[i] == previous) {
+                ++run;
+                ++i;
+            }
+            cursor = PutVarint(cursor, run);
+        }
+    }
+    return (size_t)(cursor - out);
+}
+
+static b32 DecompressIterations(const u8 *in, size_t size, i32 *values, i32 count)
+{
+    const u8 *end = in + size;
+    u32 previous = 0;
+    for (i32 i = 0; i < count;) {
+        u32 zigzag;
+        if (!(in = GetVarint(in, end, &zigzag))) return 0;
+        previous += (zigzag >> 1) ^ (0u - (zigzag & 1));
+        values[i++] = (i32)previous;
+        if (zigzag == 0) {
+            u32 run;
+            if (!(in = GetVarint(in, end, &run)) || run > (u32)(count - i)) return 0;
+            for (; run > 0; --run) values[i++] = (i32)previous;
+        }
+    }
+    return in == end;
+}
+
+// ---------------------------------------------------------------------------
+// Sockets
+// ---------------------------------------------------------------------------
+
+/*
+"unix:<caminho>" é um socket local; o resto é TCP, "tcp:<host>:<porta>" ou só
+"<host>:<porta>". Escutando, um host vazio aceita de qualquer interface; na conexão,
+vira localhost.
+*/
+static int OpenSocket(const char *address, b32 is_listening)
+{
+    if (strncmp(address, "unix:", 5) == 0) {
+        struct sockaddr_un local;
+        memset(&local, 0, sizeof(local));
+        local.sun_family = AF_UNIX;
+        if (strlen(address + 5) >= sizeof(local.sun_path)) return -1;
+        strcpy(local.sun_path, address + 5);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (is_listening) unlink(local.sun_path); // Sobra de um coordenador que não terminou
+        b32 is_open = is_listening
+            ? bind(fd, (struct sockaddr *)&local, sizeof(local)) == 0 && listen(fd, SOMAXCONN) == 0
+            : connect(fd, (struct sockaddr *)&local, sizeof(local)) == 0;
+        if (!is_open) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    if (strncmp(address, "tcp:", 4) == 0) address += 4;
+    const char *colon = strrchr(address, ':');
+    if (!colon || !colon[1]) return -1;
+    char host[256];
+    size_t host_length = (size_t)(colon - address);
+    if (host_length >= sizeof(host)) return -1;
+    memcpy(host, address, host_length);
+    host[host_length] = 0;
+
+    struct addrinfo hints, *results;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = is_listening ? AI_PASSIVE : 0;
+    const char *node = host_length ? host : (is_listening ? NULL : "localhost");
+    if (getaddrinfo(node, colon + 1, &hints, &results) != 0) return -1;
+
+    int fd = -1;
+    for (struct addrinfo *info = results; info && fd < 0; info = info->ai_next) {
+        fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        b32 is_open;
+        if (is_listening) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            is_open = bind(fd, info->ai_addr, info->ai_addrlen) == 0 && listen(fd, SOMAXCONN) == 0;
+        } else {
+            is_open = connect(fd, info->ai_addr, info->ai_addrlen) == 0;
+            // Os pedidos são pequenos e cada um já é a mensagem inteira
+            if (is_open) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        if (!is_open) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(results);
+    return fd;
+}
+
+static b32 SendAll(int fd, const void *data, size_t size)
+{
+    const u8 *bytes = data;
+    while (size > 0) {
+        ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return 0;
+        bytes += sent;
+        size -= (size_t)sent;
+    }
+    return 1;
+}
+
+static b32 ReceiveAll(int fd, void *data, size_t size)
+{
+    u8 *bytes = data;
+    while (size > 0) {
+        ssize_t received = recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return 0;
+        bytes += received;
+        size -= (size_t)received;
+    }
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Worker
+// ---------------------------------------------------------------------------
+
+int DistributedWorker(const char *address)
+{
+    int fd = -1;
+    for (int attempt = 0; attempt < DISTRIBUTED_CONNECT_SECONDS * 10 && fd < 0; ++attempt) {
+        fd = OpenSocket(address, 0);
+        if (fd < 0) {
+            struct timespec pause = {0, 100 * 1000 * 1000};
+            nanosleep(&pause, NULL);
+        }
+    }
+    if (fd < 0) {
+        fprintf(stderr, "worker: não consegui conectar em %s\n", address);
+        return 1;
+    }
+
+    i32 *tile = malloc(sizeof(i32) * DISTRIBUTED_TILE_SIZE * DISTRIBUTED_TILE_SIZE);
+    u8 *packed = malloc(RESULT_HEADER_BYTES + COMPRESSED_BOUND(DISTRIBUTED_TILE_SIZE * DISTRIBUTED_TILE_SIZE));
+    if (!tile || !packed) {
+        fprintf(stderr, "worker: sem memória para os blocos\n");
+        free(tile);
+        free(packed);
+        close(fd);
+        return 1;
+    }
+
+    int exit_code = 0;
+    u8 message[JOB_MESSAGE_BYTES];
+    while (ReceiveAll(fd, message, sizeof(message))) {
+        u32 id;
+        DistributedView view;
+        i32 rect[4];
+        if (!UnpackJob(message, &id, &view, rect)) {
+            fprintf(stderr, "worker: pedido inválido\n");
+            exit_code = 1;
+            break;
+        }
+
+        // Cada bloco é calculado com a vista inteira, como na renderização local, e sai com as mesmas contagens
+        FrameSetup frame;
+        if (!FrameSetupInit(&frame, &view.center_x, &view.center_y, view.zoom, view.width, view.height,
+                            view.max_iterations, view.precision)) {
+            fprintf(stderr, "worker: não consegui preparar a vista\n");
+            exit_code = 1;
+            break;
+        }
+        FrameIterateRegion(&frame, tile, rect[0], rect[1], rect[2], rect[3]);
+
+        i32 count = (rect[2] - rect[0]) * (rect[3] - rect[1]);
+        size_t size = CompressIterations(tile, count, packed + RESULT_HEADER_BYTES);
+        memcpy(packed, "MBR1", 4);
+        PutU32LE(packed + 4, id);
+        PutU32LE(packed + 8, (u32)size);
+        if (!SendAll(fd, packed, RESULT_HEADER_BYTES + size)) break;
+    }
+
+    free(tile);
+    free(packed);
+    close(fd);
+    return exit_code;
+}
+
+// ---------------------------------------------------------------------------
+// Coordenador
+// ---------------------------------------------------------------------------
+
+typedef enum {
+    TILE_QUEUED,
+    TILE_SENT,
+    TILE_DONE
+} DistributedTileState;
+
+typedef struct {
+    u8 state;
+    i32 worker; // Conexão que está com o bloco, quando enviado
+} DistributedTile;
+
+typedef struct {
+    int fd; // -1 se a vaga está livre
+    i32 pending;
+    u8 *inbox;
+    size_t inbox_used;
+    size_t inbox_capacity;
+} WorkerConnection;
+
+typedef struct {
+    const DistributedView *view;
+    i32 *iterations;
+    i32 tiles_x;
+    i32 tile_count;
+    i32 done;
+    i32 first_queued; // Nenhum bloco antes deste está na fila
+    DistributedTile *tiles;
+    WorkerConnection workers[DISTRIBUTED_MAX_WORKERS];
+    i32 *scratch;
+    DistributedStats *stats;
+} Coordinator;
+
+static void TileRect(const Coordinator *coordinator, i32 tile, i32 rect[4])
+{
+    rect[0] = (tile % coordinator->tiles_x) * DISTRIBUTED_TILE_SIZE;
+    rect[1] = (tile / coordinator->tiles_x) * DISTRIBUTED_TILE_SIZE;
+    rect[2] = rect[0] + DISTRIBUTED_TILE_SIZE < coordinator->view->width ? rect[0] + DISTRIBUTED_TILE_SIZE
+                                                                          : coordinator->view->width;
+    rect[3] = rect[1] + DISTRIBUTED_TILE_SIZE < coordinator->view->height ? rect[1] + DISTRIBUTED_TILE_SIZE
+                                                                           : coordinator->view->height;
+}
+
+// A conexão fechou ou mandou algo sem sentido: os blocos que estavam com ela voltam para a fila
+static void DropWorker(Coordinator *coordinator, i32 index)
+{
+    WorkerConnection *worker = &coordinator->workers[index];
+    for (i32 tile = 0; tile < coordinator->tile_count; ++tile) {
+        DistributedTile *state = &coordinator->tiles[tile];
+        if (state->state != TILE_SENT || state->worker != index) continue;
+        state->state = TILE_QUEUED;
+        if (tile < coordinator->first_queued) coordinator->first_queued = tile;
+        ++coordinator->stats->reassigned_tiles;
+    }
+    if (worker->pending > 0) {
+        fprintf(stderr, "\rdistribuído: worker perdido com %d blocos pendentes, que voltam para a fila\n",
+                worker->pending);
+    }
+    ++coordinator->stats->lost_workers;
+
+    close(worker->fd);
+    free(worker->inbox);
+    memset(worker, 0, sizeof(*worker));
+    worker->fd = -1;
+}
+
+static b32 SendJobs(Coordinator *coordinator, i32 index)
+{
+    WorkerConnection *worker = &coordinator->workers[index];
+    while (worker->pending < DISTRIBUTED_JOBS_PER_WORKER) {
+        i32 tile = coordinator->first_queued;
+        while (tile < coordinator->tile_count && coordinator->tiles[tile].state != TILE_QUEUED) ++tile;
+        coordinator->first_queued = tile;
+        if (tile >= coordinator->tile_count) return 1;
+
+        i32 rect[4];
+        TileRect(coordinator, tile, rect);
+        u8 message[JOB_MESSAGE_BYTES];
+        PackJob(message, (u32)tile, coordinator->view, rect[0], rect[1], rect[2], rect[3]);
+        if (!SendAll(worker->fd, message, sizeof(message))) return 0;
+
+        coordinator->tiles[tile].state = TILE_SENT;
+        coordinator->tiles[tile].worker = index;
+        ++worker->pending;
+    }
+    return 1;
+}
+
+// Consome as respostas completas da caixa de entrada; retorna 0 se o worker mandou algo inválido
+static b32 ReceiveResults(Coordinator *coordinator, i32 index)
+{
+    WorkerConnection *worker = &coordinator->workers[index];
+    size_t offset = 0;
+    while (worker->inbox_used - offset >= RESULT_HEADER_BYTES) {
+        const u8 *header = worker->inbox + offset;
+        if (memcmp(header, "MBR1", 4) != 0) return 0;
+        u32 tile = GetU32LE(header + 4);
+        u32 size = GetU32LE(header + 8);
+        if (tile >= (u32)coordinator->tile_count || size > COMPRESSED_BOUND(DISTRIBUTED_TILE_SIZE * DISTRIBUTED_TILE_SIZE)) {
+            return 0;
+        }
+        if (worker->inbox_used - offset < RESULT_HEADER_BYTES + size) break;
+
+        DistributedTile *state = &coordinator->tiles[tile];
+        if (state->state != TILE_SENT || state->worker != index) return 0;
+
+        i32 rect[4];
+        TileRect(coordinator, (i32)tile, rect);
+        i32 tile_width = rect[2] - rect[0];
+        i32 count = tile_width * (rect[3] - rect[1]);
+        if (!DecompressIterations(header + RESULT_HEADER_BYTES, size, coordinator->scratch, count)) return 0;
+        for (i32 y = rect[1]; y < rect[3]; ++y) {
+            memcpy(coordinator->iterations + (size_t)y * coordinator->view->width + rect[0],
+                   coordinator->scratch + (size_t)(y - rect[1]) * tile_width, sizeof(i32) * tile_width);
+        }
+
+        state->state = TILE_DONE;
+        --worker->pending;
+        ++coordinator->done;
+        coordinator->stats->raw_bytes += (i64)count * (i64)sizeof(i32);
+        coordinator->stats->compressed_bytes += size;
+        offset += RESULT_HEADER_BYTES + size;
+    }
+    memmove(worker->inbox, worker->inbox + offset, worker->inbox_used - offset);
+    worker->inbox_used -= offset;
+    return 1;
+}
+
+static b32 ReadFromWorker(Coordinator *coordinator, i32 index)
+{
+    WorkerConnection *worker = &coordinator->workers[index];
+    if (worker->inbox_capacity - worker->inbox_used < 65536) {
+        size_t capacity = worker->inbox_capacity ? 2 * worker->inbox_capacity : 262144;
+        u8 *inbox = realloc(worker->inbox, capacity);
+        if (!inbox) return 0;
+        worker->inbox = inbox;
+        worker->inbox_capacity = capacity;
+    }
+    ssize_t received = recv(worker->fd, worker->inbox + worker->inbox_used,
+                            worker->inbox_capacity - worker->inbox_used, 0);
+    if (received < 0 && errno == EINTR) return 1;
+    if (received <= 0) return 0;
+    worker->inbox_used += (size_t)received;
+    return ReceiveResults(coordinator, index);
+}
+
+// Workers locais são este mesmo executável com --worker, dividindo os núcleos entre si
+static i32 SpawnWorkers(const char *address, i32 count, pid_t *pids)
+{
+    if (count <= 0) return 0;
+
+    b32 is_thread_count_set = getenv("OMP_NUM_THREADS") != NULL;
+    if (!is_thread_count_set) {
+        char threads[16];
+        i32 per_worker = omp_get_num_procs() / count;
+        snprintf(threads, sizeof(threads), "%d", per_worker > 0 ? per_worker : 1);
+        setenv("OMP_NUM_THREADS", threads, 1);
+    }
+
+    i32 spawned = 0;
+    for (i32 i = 0; i < count; ++i) {
+        fflush(NULL);
+        pid_t pid = fork();
+        if (pid == 0) {
+            execl("/proc/self/exe", "mandelbrot-worker", "--worker", address, (char *)NULL);
+            _exit(127);
+        }
+        if (pid > 0) pids[spawned++] = pid;
+    }
+
+    if (!is_thread_count_set) unsetenv("OMP_NUM_THREADS");
+    return spawned;
+}
+
+b32 DistributedRender(const char *address, const DistributedView *view, i32 spawn_workers, i32 *iterations,
+                      DistributedStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (spawn_workers > DISTRIBUTED_MAX_WORKERS) spawn_workers = DISTRIBUTED_MAX_WORKERS;
+
+    int listen_fd = OpenSocket(address, 1);
+    if (listen_fd < 0) {
+        fprintf(stderr, "Não consegui escutar em %s\n", address);
+        return 0;
+    }
+
+    Coordinator coordinator;
+    memset(&coordinator, 0, sizeof(coordinator));
+    coordinator.view = view;
+    coordinator.iterations = iterations;
+    coordinator.tiles_x = (view->width + DISTRIBUTED_TILE_SIZE - 1) / DISTRIBUTED_TILE_SIZE;
+    coordinator.tile_count = coordinator.tiles_x * ((view->height + DISTRIBUTED_TILE_SIZE - 1) / DISTRIBUTED_TILE_SIZE);
+    coordinator.tiles = calloc((size_t)coordinator.tile_count, sizeof(DistributedTile));
+    coordinator.scratch = malloc(sizeof(i32) * DISTRIBUTED_TILE_SIZE * DISTRIBUTED_TILE_SIZE);
+    coordinator.stats = stats;
+    for (i32 i = 0; i < DISTRIBUTED_MAX_WORKERS; ++i) coordinator.workers[i].fd = -1;
+    stats->tiles = coordinator.tile_count;
+
+    b32 is_ok = coordinator.tiles && coordinator.scratch;
+    pid_t pids[DISTRIBUTED_MAX_WORKERS];
+    i32 spawned = is_ok ? SpawnWorkers(address, spawn_workers, pids) : 0;
+    b32 is_waiting_reported = 0;
+
+    while (is_ok && coordinator.done < coordinator.tile_count) {
+        struct pollfd fds[1 + DISTRIBUTED_MAX_WORKERS];
+        i32 owners[1 + DISTRIBUTED_MAX_WORKERS];
+        i32 fd_count = 0;
+        fds[fd_count].fd = listen_fd;
+        fds[fd_count].events = POLLIN;
+        owners[fd_count++] = -1;
+        for (i32 i = 0; i < DISTRIBUTED_MAX_WORKERS; ++i) {
+            if (coordinator.workers[i].fd < 0) continue;
+            fds[fd_count].fd = coordinator.workers[i].fd;
+            fds[fd_count].events = POLLIN;
+            owners[fd_count++] = i;
+        }
+
+        // Sem ninguém conectado por um segundo, avisa onde está esperando
+        int ready = poll(fds, (nfds_t)fd_count, 1000);
+        if (ready < 0 && errno != EINTR) {
+            is_ok = 0;
+            break;
+        }
+        if (ready == 0 && fd_count == 1 && !is_waiting_reported) {
+            fprintf(stderr, "distribuído: nenhum worker conectado; esperando em %s\n", address);
+            is_waiting_reported = 1;
+        }
+        if (ready <= 0) continue;
+
+        for (i32 f = 1; f < fd_count; ++f) {
+            if (!fds[f].revents) continue;
+            if (!ReadFromWorker(&coordinator, owners[f])) DropWorker(&coordinator, owners[f]);
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listen_fd, NULL, NULL);
+            i32 slot = 0;
+            while (slot < DISTRIBUTED_MAX_WORKERS && coordinator.workers[slot].fd >= 0) ++slot;
+            if (fd >= 0 && slot < DISTRIBUTED_MAX_WORKERS) {
+                // Um host que some sem fechar a conexão só é percebido pelo keepalive
+                int one = 1;
+                setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                coordinator.workers[slot].fd = fd;
+                ++stats->workers;
+                is_waiting_reported = 0;
+            } else if (fd >= 0) {
+                close(fd);
+            }
+        }
+
+        i32 connected = 0;
+        for (i32 i = 0; i < DISTRIBUTED_MAX_WORKERS; ++i) {
+            if (coordinator.workers[i].fd < 0) continue;
+            if (!SendJobs(&coordinator, i)) {
+                DropWorker(&coordinator, i);
+                continue;
+            }
+            ++connected;
+        }
+        fprintf(stderr, "\rdistribuído: %d/%d blocos, %d workers ", coordinator.done, coordinator.tile_count,
+                connected);
+    }
+    fprintf(stderr, "\n");
+
+    // Fechar as conexões é o sinal para os workers terminarem
+    for (i32 i = 0; i < DISTRIBUTED_MAX_WORKERS; ++i) {
+        if (coordinator.workers[i].fd < 0) continue;
+        close(coordinator.workers[i].fd);
+        free(coordinator.workers[i].inbox);
+    }
+    close(listen_fd);
+    if (strncmp(address, "unix:", 5) == 0) unlink(address + 5);
+    for (i32 i = 0; i < spawned; ++i) waitpid(pids[i], NULL, 0);
+
+    free(coordinator.tiles);
+    free(coordinator.scratch);
+    return is_ok;
+}
+
+#else
+
+b32 DistributedRender(const char *address, const DistributedView *view, i32 spawn_workers, i32 *iterations,
+                      DistributedStats *stats)
+{
+    (void)address, (void)view, (void)spawn_workers, (void)iterations;
+    memset(stats, 0, sizeof(*stats));
+    fprintf(stderr, "A renderização distribuída só existe nos sistemas POSIX\n");
+    return 0;
+}
+
+int DistributedWorker(const char *address)
+{
+    (void)address;
+    fprintf(stderr, "A renderização distribuída só existe nos sistemas POSIX\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,1194 @@
+#define _POSIX_C_SOURCE 200112L // clock_gettime e fseeko
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <time.h>
+#endif
+
+#include "platform.h"
+#include "mandelbrot.h"
+#include "profiler.h"
+#include "distributed.h"
+#include "tile_server.h"
+
+typedef enum {
+    IMAGE_FORMAT_PPM,
+    IMAGE_FORMAT_PNG,
+    IMAGE_FORMAT_RAW
+} ImageFormat;
+
+typedef struct {
+    HPReal center_x;
+    HPReal center_y;
+    f64 zoom;
+    i32 width;
+    i32 height;
+    i32 iterations;
+    i32 repeat;
+    i32 pan;
+    f32 scale;
+    i32 poster_tile;
+    i32 tile_cache_megabytes;
+    i32 spawn_workers;
+    i32 movie_frames;
+    f64 movie_octaves;
+    b32 progressive;
+    b32 subdivide;
+    b32 double_double;
+    b32 pin_threads;
+    b32 no_refill;
+    b32 histogram;
+    b32 adaptive;
+    b32 overlay;
+    i32 palette_length;
+    i32 cycle;
+    i32 recolor;
+    const char *output_path;
+    const char *trace_path;
+    const char *coordinator_address;
+    const char *worker_address;
+    const char *serve_address;
+    ImageFormat format;
+    RenderPrecision precision;
+} HeadlessOptions;
+
+static f64 HeadlessGetSeconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (f64)counter.QuadPart / (f64)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1000000000.0;
+#endif
+}
+
+FileData PlatformFileRead(const char *path)
+{
+    FileData result = {0};
+    if (!path) return result;
+
+    FILE *f = fopen(path, "rb");
+    if (!f) return result;
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    if (size > 0) {
+        result.data = malloc(size);
+        if (result.data) {
+            size_t read = fread(result.data, 1, size, f);
+            result.size = read;
+            if (read != (size_t)size) {
+                free(result.data);
+                result.data = NULL;
+                result.size = 0;
+            }
+        }
+    }
+
+    fclose(f);
+    return result;
+}
+
+void PlatformFileFree(FileData *fd)
+{
+    if (fd && fd->data) {
+        free(fd->data);
+        fd->data = NULL;
+        fd->size = 0;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Escrita de imagens
+// ---------------------------------------------------------------------------
+
+static b32 HeadlessWritePPM(FILE *f, OffscreenBuffer *buffer)
+{
+    fprintf(f, "P6\n%d %d\n255\n", buffer->width, buffer->height);
+
+    u8 *row_rgb = malloc((size_t)buffer->width * 3);
+    if (!row_rgb) return 0;
+
+    for (int y = 0; y < buffer->height; ++y) {
+        u32 *row = (u32 *)((u8 *)buffer->memory + (size_t)y * buffer->pitch);
+        for (int x = 0; x < buffer->width; ++x) {
+            row_rgb[x * 3 + 0] = (u8)(row[x] >> 16);
+            row_rgb[x * 3 + 1] = (u8)(row[x] >> 8);
+            row_rgb[x * 3 + 2] = (u8)(row[x]);
+        }
+        fwrite(row_rgb, 1, (size_t)buffer->width * 3, f);
+    }
+
+    free(row_rgb);
+    return !ferror(f);
+}
+
+// Bytes do backbuffer exatamente como estão na memória (BGRA, 32 bits por pixel)
+static b32 HeadlessWriteRaw(FILE *f, OffscreenBuffer *buffer)
+{
+    for (int y = 0; y < buffer->height; ++y) {
+        u8 *row = (u8 *)buffer->memory + (size_t)y * buffer->pitch;
+        fwrite(row, 1, (size_t)buffer->width * buffer->bytes_per_pixel, f);
+    }
+    return !ferror(f);
+}
+
+static u32 Crc32Table[256];
+
+static void HeadlessInitCrc32(void)
+{
+    for (u32 n = 0; n < 256; ++n) {
+        u32 c = n;
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+        Crc32Table[n] = c;
+    }
+}
+
+static u32 HeadlessCrc32Update(u32 crc, const u8 *data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) crc = Crc32Table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static void HeadlessPutU32BE(u8 *out, u32 value)
+{
+    out[0] = (u8)(value >> 24);
+    out[1] = (u8)(value >> 16);
+    out[2] = (u8)(value >> 8);
+    out[3] = (u8)(value);
+}
+
+static void HeadlessWritePNGChunk(FILE *f, const char *type, const u8 *data, u32 size)
+{
+    u8 header[8];
+    HeadlessPutU32BE(header, size);
+    memcpy(header + 4, type, 4);
+    fwrite(header, 1, 8, f);
+    if (size) fwrite(data, 1, size, f);
+
+    u32 crc = HeadlessCrc32Update(0xFFFFFFFFu, (const u8 *)type, 4);
+    crc = HeadlessCrc32Update(crc, data, size) ^ 0xFFFFFFFFu;
+    u8 footer[4];
+    HeadlessPutU32BE(footer, crc);
+    fwrite(footer, 1, 4, f);
+}
+
+// Tamanho máximo de cada IDAT: o fluxo zlib é escrito em pedaços, sem nunca existir inteiro na memória
+#define PNG_IDAT_CHUNK_SIZE (1 << 20)
+
+typedef struct {
+    FILE *f;
+    u8 *chunk;
+    size_t chunk_size;
+    size_t block_left; // Bytes que faltam no bloco "stored" atual
+    size_t raw_left;   // Bytes do fluxo descomprimido que ainda não foram escritos
+    u32 adler_a;
+    u32 adler_b;
+} PngStream;
+
+static void HeadlessPngPut(PngStream *stream, const u8 *data, size_t size)
+{
+    while (size > 0) {
+        size_t count = PNG_IDAT_CHUNK_SIZE - stream->chunk_size;
+        if (count > size) count = size;
+        memcpy(stream->chunk + stream->chunk_size, data, count);
+        stream->chunk_size += count;
+        data += count;
+        size -= count;
+
+        if (stream->chunk_size == PNG_IDAT_CHUNK_SIZE) {
+            HeadlessWritePNGChunk(stream->f, "IDAT", stream->chunk, (u32)stream->chunk_size);
+            stream->chunk_size = 0;
+        }
+    }
+}
+
+// Divide os dados descomprimidos em blocos "stored" de até 65535 bytes e atualiza o Adler-32
+static void HeadlessPngDeflate(PngStream *stream, const u8 *data, size_t size)
+{
+    // 5552 é o maior trecho em que as somas cabem em 32 bits antes de reduzir
+    for (size_t offset = 0; offset < size; offset += 5552) {
+        size_t end = size - offset > 5552 ? offset + 5552 : size;
+        for (size_t i = offset; i < end; ++i) {
+            stream->adler_a += data[i];
+            stream->adler_b += stream->adler_a;
+        }
+        stream->adler_a %= 65521;
+        stream->adler_b %= 65521;
+    }
+
+    while (size > 0) {
+        if (stream->block_left == 0) {
+            size_t block = stream->raw_left > 65535 ? 65535 : stream->raw_left;
+            u8 header[5];
+            header[0] = (u8)(block == stream->raw_left ? 1 : 0);
+            header[1] = (u8)(block & 0xFF);
+            header[2] = (u8)(block >> 8);
+            header[3] = (u8)(~block & 0xFF);
+            header[4] = (u8)((~block >> 8) & 0xFF);
+            HeadlessPngPut(stream, header, sizeof(header));
+            stream->block_left = block;
+        }
+
+        size_t count = size < stream->block_left ? size : stream->block_left;
+        HeadlessPngPut(stream, data, count);
+        stream->block_left -= count;
+        stream->raw_left -= count;
+        data += count;
+        size -= count;
+    }
+}
+
+/*
+PNG sem dependências: o fluxo zlib usa apenas blocos "stored" (sem compressão).
+O arquivo fica do tamanho de um PPM, mas qualquer visualizador consegue abrir.
+*/
+static b32 HeadlessWritePNG(FILE *f, OffscreenBuffer *buffer)
+{
+    // Cada linha recebe um byte de filtro (0 = nenhum) seguido dos pixels RGB
+    if (buffer->width <= 0 || buffer->height <= 0) return 0;
+    if ((size_t)buffer->width > (SIZE_MAX - 1) / 3) return 0;
+    size_t row_size = (size_t)buffer->width * 3 + 1;
+    if ((size_t)buffer->height > SIZE_MAX / row_size) return 0;
+
+    PngStream stream = {f, malloc(PNG_IDAT_CHUNK_SIZE), 0, 0, row_size * buffer->height, 1, 0};
+    u8 *raw = malloc(row_size);
+    if (!stream.chunk || !raw) {
+        free(stream.chunk);
+        free(raw);
+        return 0;
+    }
+
+    static const u8 signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(signature, 1, 8, f);
+    HeadlessInitCrc32();
+
+    u8 ihdr[13];
+    HeadlessPutU32BE(ihdr + 0, (u32)buffer->width);
+    HeadlessPutU32BE(ihdr + 4, (u32)buffer->height);
+    ihdr[8] = 8;   // Bits por canal
+    ihdr[9] = 2;   // RGB
+    ihdr[10] = 0;  // Deflate
+    ihdr[11] = 0;  // Filtro adaptativo
+    ihdr[12] = 0;  // Sem entrelaçamento
+    HeadlessWritePNGChunk(f, "IHDR", ihdr, sizeof(ihdr));
+
+    static const u8 zlib_header[2] = {0x78, 0x01};
+    HeadlessPngPut(&stream, zlib_header, sizeof(zlib_header));
+
+    for (int y = 0; y < buffer->height; ++y) {
+        u32 *row = (u32 *)((u8 *)buffer->memory + (size_t)y * buffer->pitch);
+        u8 *out = raw;
+        *out++ = 0;
+        for (int x = 0; x < buffer->width; ++x) {
+            *out++ = (u8)(row[x] >> 16);
+            *out++ = (u8)(row[x] >> 8);
+            *out++ = (u8)(row[x]);
+        }
+        HeadlessPngDeflate(&stream, raw, row_size);
+        if (ferror(f)) break;
+    }
+
+    u8 adler[4];
+    HeadlessPutU32BE(adler, (stream.adler_b << 16) | stream.adler_a);
+    HeadlessPngPut(&stream, adler, sizeof(adler));
+    if (stream.chunk_size) HeadlessWritePNGChunk(f, "IDAT", stream.chunk, (u32)stream.chunk_size);
+    HeadlessWritePNGChunk(f, "IEND", NULL, 0);
+
+    free(stream.chunk);
+    free(raw);
+    return !ferror(f);
+}
+
+static b32 HeadlessWriteImage(const char *path, ImageFormat format, OffscreenBuffer *buffer)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) return 0;
+
+    b32 ok = 0;
+    switch (format) {
+        case IMAGE_FORMAT_PPM: ok = HeadlessWritePPM(f, buffer); break;
+        case IMAGE_FORMAT_PNG: ok = HeadlessWritePNG(f, buffer); break;
+        case IMAGE_FORMAT_RAW: ok = HeadlessWriteRaw(f, buffer); break;
+    }
+
+    if (fclose(f) != 0) ok = 0;
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Linha de comando
+// ---------------------------------------------------------------------------
+
+static void HeadlessPrintUsage(const char *program)
+{
+    fprintf(stderr,
+            "Uso: %s [opções]\n"
+            "  -x, --center-x <f>     Centro real da vista, com quantos dígitos precisar (padrão -0.75)\n"
+            "  -y, --center-y <f>     Centro imaginário da vista (padrão 0)\n"
+            "  -z, --zoom <f>         Tamanho de um pixel no plano complexo (padrão 0.004)\n"
+            "  -W, --width <n>        Largura da imagem (padrão 800)\n"
+            "  -H, --height <n>       Altura da imagem (padrão 600)\n"
+            "  -i, --iterations <n>   Limite de iterações (padrão %d)\n"
+            "      --adaptive         A cada repetição, ajusta o limite pelo zoom e pelo frame anterior\n"
+            "  -r, --repeat <n>       Quantas vezes renderizar para medir (padrão 1)\n"
+            "      --pan <px>         A cada repetição, desloca a vista <px> pixels na horizontal\n"
+            "                         e usa o renderizador incremental, como as setinhas\n"
+            "      --scale <f>        Calcula numa grade com <f> da resolução (0.25 a 1) e amplia,\n"
+            "                         como a resolução dinâmica da janela durante a interação\n"
+            "      --poster <n>       Pôster maior que a memória: renderiza blocos de <n>x<n> direto\n"
+            "                         no PPM de saída, retomando de <saída>.checkpoint se existir\n"
+            "      --movie <n>        Filme de <n> frames do zoom -z até --octaves oitavas para dentro,\n"
+            "                         tirados de um quadro-chave a cada 2x de zoom; -o com %%05d grava\n"
+            "                         frames numerados e -o - manda todos em sequência pela saída padrão\n"
+            "      --octaves <f>      Quantas vezes o zoom do filme dobra (padrão 10)\n"
+            "      --tile-cache <MB>  Monta cada repetição com o cache de blocos, limitado a <MB>;\n"
+            "                         sem --pan, da segunda em diante todos os blocos já estão lá\n"
+            "      --coordinator <e>  Distribui blocos de %dx%d entre os workers que se conectarem em <e>\n"
+            "                         (unix:<caminho> ou [tcp:]<host>:<porta>) e monta a imagem\n"
+            "      --workers <n>      Com --coordinator, inicia <n> workers locais\n"
+            "      --worker <e>       Calcula os blocos do coordenador em <e> até ele terminar\n"
+            "      --serve <[h:]p>    Servidor HTTP de blocos PNG /<z>/<x>/<y>.png na porta <p>\n"
+            "                         (padrão 127.0.0.1), com -i como limite e --tile-cache como cache\n"
+            "      --progressive      Renderiza em passadas com orçamento de 1/60 s por chamada\n"
+            "                         e mede a latência de cada uma (ignora --repeat)\n"
+            "      --subdivide        Usa a subdivisão de Mariani-Silver (também nas faixas do --pan)\n"
+            "      --dd               Com -p auto, usa o double-double entre o f64 e a perturbação\n"
+            "  -t, --tile <LxA>       Tamanho dos blocos do escalonador (padrão %dx%d)\n"
+            "      --pin              Prende cada thread do escalonador a um núcleo\n"
+            "      --no-refill        Itera os blocos linha a linha, sem recarga de lanes (para comparar)\n"
+            "      --histogram        Colore com equalização por histograma\n"
+            "      --cycle <n>        Desloca a paleta em <n> cores\n"
+            "      --palette <n>      Quantas cores a paleta tem antes de se repetir (padrão %d)\n"
+            "      --recolor <n>      Depois de renderizar, recolore <n> vezes girando a paleta e mede o custo\n"
+            "      --trace <arq>      Mede cada repetição (ou chamada do progressivo) e grava o trace do Chrome\n"
+            "      --overlay          Desenha o painel de instrumentação na imagem de saída\n"
+            "  -o, --output <arq>     Arquivo de saída (sem ele nada é gravado)\n"
+            "  -f, --format <fmt>     ppm, png ou raw (padrão: extensão do arquivo, senão ppm)\n"
+            "  -p, --precision <p>    auto, f32, f64, dd ou deep (padrão auto)\n"
+            "  -k, --kernel <k>       auto, scalar, sse2, avx2, avx512 ou fma (padrão: MANDELBROT_KERNEL, senão o melhor da CPU)\n",
+            program, DEFAULT_MAX_ITERATIONS, DISTRIBUTED_TILE_SIZE, DISTRIBUTED_TILE_SIZE,
+            TILE_DEFAULT_WIDTH, TILE_DEFAULT_HEIGHT, PALETTE_DEFAULT_LENGTH);
+}
+
+static ImageFormat HeadlessFormatFromPath(const char *path)
+{
+    const char *dot = path ? strrchr(path, '.') : NULL;
+    if (dot && strcmp(dot, ".png") == 0) return IMAGE_FORMAT_PNG;
+    if (dot && strcmp(dot, ".raw") == 0) return IMAGE_FORMAT_RAW;
+    return IMAGE_FORMAT_PPM;
+}
+
+static b32 HeadlessParseFormat(const char *name, ImageFormat *format)
+{
+    if (strcmp(name, "ppm") == 0) *format = IMAGE_FORMAT_PPM;
+    else if (strcmp(name, "png") == 0) *format = IMAGE_FORMAT_PNG;
+    else if (strcmp(name, "raw") == 0) *format = IMAGE_FORMAT_RAW;
+    else return 0;
+    return 1;
+}
+
+static b32 HeadlessParsePrecision(const char *name, RenderPrecision *precision)
+{
+    if (strcmp(name, "auto") == 0) *precision = PRECISION_AUTO;
+    else if (strcmp(name, "f32") == 0) *precision = PRECISION_F32;
+    else if (strcmp(name, "f64") == 0) *precision = PRECISION_F64;
+    else if (strcmp(name, "dd") == 0) *precision = PRECISION_DD;
+    else if (strcmp(name, "deep") == 0) *precision = PRECISION_DEEP;
+    else return 0;
+    return 1;
+}
+
+static const char *HeadlessPrecisionName(RenderPrecision precision)
+{
+    switch (precision) {
+        case PRECISION_F32: return "f32";
+        case PRECISION_F64: return "f64";
+        case PRECISION_DD: return "dd";
+        case PRECISION_DEEP: return "deep";
+        default: return "auto";
+    }
+}
+
+static b32 HeadlessParseCoordinate(const char *text, HPReal *value)
+{
+    if (HPFromString(value, text)) return 1;
+    fprintf(stderr, "Coordenada inválida: %s\n", text);
+    return 0;
+}
+
+static b32 HeadlessParseOptions(int argc, char **argv, HeadlessOptions *options)
+{
+    b32 has_format = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--help") == 0) return 0;
+        if (strcmp(arg, "--progressive") == 0) {
+            options->progressive = 1;
+            continue;
+        }
+        if (strcmp(arg, "--subdivide") == 0) {
+            options->subdivide = 1;
+            continue;
+        }
+        if (strcmp(arg, "--dd") == 0) {
+            options->double_double = 1;
+            continue;
+        }
+        if (strcmp(arg, "--pin") == 0) {
+            options->pin_threads = 1;
+            continue;
+        }
+        if (strcmp(arg, "--no-refill") == 0) {
+            options->no_refill = 1;
+            continue;
+        }
+        if (strcmp(arg, "--histogram") == 0) {
+            options->histogram = 1;
+            continue;
+        }
+        if (strcmp(arg, "--adaptive") == 0) {
+            options->adaptive = 1;
+            continue;
+        }
+        if (strcmp(arg, "--overlay") == 0) {
+            options->overlay = 1;
+            continue;
+        }
+        if (!value) {
+            fprintf(stderr, "Opção sem valor: %s\n", arg);
+            return 0;
+        }
+
+        if (strcmp(arg, "-x") == 0 || strcmp(arg, "--center-x") == 0) {
+            if (!HeadlessParseCoordinate(value, &options->center_x)) return 0;
+        }
+        else if (strcmp(arg, "-y") == 0 || strcmp(arg, "--center-y") == 0) {
+            if (!HeadlessParseCoordinate(value, &options->center_y)) return 0;
+        }
+        else if (strcmp(arg, "-z") == 0 || strcmp(arg, "--zoom") == 0) options->zoom = strtod(value, NULL);
+        else if (strcmp(arg, "-W") == 0 || strcmp(arg, "--width") == 0) options->width = atoi(value);
+        else if (strcmp(arg, "-H") == 0 || strcmp(arg, "--height") == 0) options->height = atoi(value);
+        else if (strcmp(arg, "-i") == 0 || strcmp(arg, "--iterations") == 0) options->iterations = atoi(value);
+        else if (strcmp(arg, "-r") == 0 || strcmp(arg, "--repeat") == 0) options->repeat = atoi(value);
+        else if (strcmp(arg, "--pan") == 0) options->pan = atoi(value);
+        else if (strcmp(arg, "--scale") == 0) options->scale = (f32)strtod(value, NULL);
+        else if (strcmp(arg, "--poster") == 0) options->poster_tile = atoi(value);
+        else if (strcmp(arg, "--movie") == 0) {
+            // Zero frames desligaria o filme em silêncio e renderizaria um frame comum
+            options->movie_frames = atoi(value);
+            if (options->movie_frames <= 0) {
+                fprintf(stderr, "O número de frames e de oitavas do filme precisam ser positivos\n");
+                return 0;
+            }
+        }
+        else if (strcmp(arg, "--octaves") == 0) options->movie_octaves = strtod(value, NULL);
+        else if (strcmp(arg, "--tile-cache") == 0) options->tile_cache_megabytes = atoi(value);
+        else if (strcmp(arg, "--coordinator") == 0) options->coordinator_address = value;
+        else if (strcmp(arg, "--workers") == 0) options->spawn_workers = atoi(value);
+        else if (strcmp(arg, "--worker") == 0) options->worker_address = value;
+        else if (strcmp(arg, "--serve") == 0) options->serve_address = value;
+        else if (strcmp(arg, "--cycle") == 0) options->cycle = atoi(value);
+        else if (strcmp(arg, "--palette") == 0) options->palette_length = atoi(value);
+        else if (strcmp(arg, "--recolor") == 0) options->recolor = atoi(value);
+        else if (strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) options->output_path = value;
+        else if (strcmp(arg, "--trace") == 0) options->trace_path = value;
+        else if (strcmp(arg, "-p") == 0 || strcmp(arg, "--precision") == 0) {
+            if (!HeadlessParsePrecision(value, &options->precision)) {
+                fprintf(stderr, "Precisão desconhecida: %s\n", value);
+                return 0;
+            }
+        }
+        else if (strcmp(arg, "-f") == 0 || strcmp(arg, "--format") == 0) {
+            if (!HeadlessParseFormat(value, &options->format)) {
+                fprintf(stderr, "Formato desconhecido: %s\n", value);
+                return 0;
+            }
+            has_format = 1;
+        }
+        else if (strcmp(arg, "-t") == 0 || strcmp(arg, "--tile") == 0) {
+            int tile_w = 0, tile_h = 0;
+            if (sscanf(value, "%dx%d", &tile_w, &tile_h) != 2 || tile_w <= 0 || tile_h <= 0) {
+                fprintf(stderr, "Tamanho de bloco inválido: %s\n", value);
+                return 0;
+            }
+            SetTileSize(tile_w, tile_h);
+        }
+        else if (strcmp(arg, "-k") == 0 || strcmp(arg, "--kernel") == 0) {
+            if (!SelectIterationKernel(value)) {
+                fprintf(stderr, "Kernel desconhecido ou não suportado por esta CPU: %s\n", value);
+                return 0;
+            }
+        }
+        else {
+            fprintf(stderr, "Opção desconhecida: %s\n", arg);
+            return 0;
+        }
+        ++i;
+    }
+
+    if (!has_format) options->format = HeadlessFormatFromPath(options->output_path);
+
+    if (options->width <= 0 || options->height <= 0 || options->zoom <= 0.0 || options->repeat <= 0 ||
+        options->scale <= 0.0f) {
+        fprintf(stderr, "Largura, altura, zoom, escala e repetições precisam ser positivos\n");
+        return 0;
+    }
+    if (options->iterations < 1) {
+        fprintf(stderr, "O limite de iterações precisa ser positivo\n");
+        return 0;
+    }
+    if (options->poster_tile < 0) {
+        fprintf(stderr, "O bloco do pôster precisa ser positivo\n");
+        return 0;
+    }
+    if (options->poster_tile && (!options->output_path || options->format != IMAGE_FORMAT_PPM)) {
+        fprintf(stderr, "O pôster é gravado direto no arquivo e precisa de uma saída .ppm\n");
+        return 0;
+    }
+    if (options->poster_tile && options->histogram) {
+        fprintf(stderr, "A equalização precisa do histograma da imagem inteira e não funciona no pôster\n");
+        return 0;
+    }
+    if (options->spawn_workers < 0 || (options->spawn_workers && !options->coordinator_address)) {
+        fprintf(stderr, "--workers precisa de um número positivo e de --coordinator\n");
+        return 0;
+    }
+    if (options->coordinator_address && options->poster_tile) {
+        fprintf(stderr, "O pôster e a renderização distribuída não funcionam juntos\n");
+        return 0;
+    }
+    if (options->movie_octaves <= 0.0) {
+        fprintf(stderr, "O número de frames e de oitavas do filme precisam ser positivos\n");
+        return 0;
+    }
+    if (options->movie_frames && (options->poster_tile || options->coordinator_address || options->histogram)) {
+        fprintf(stderr, "O filme não funciona com o pôster, a renderização distribuída nem a equalização\n");
+        return 0;
+    }
+    if (options->movie_frames && (!options->output_path ||
+                                  (strcmp(options->output_path, "-") != 0 && !strchr(options->output_path, '%')))) {
+        fprintf(stderr, "O filme precisa de -o com %%d (ou %%05d) no nome dos frames, ou de -o -\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Pôster em blocos
+// ---------------------------------------------------------------------------
+
+/*
+Imagens que não cabem na memória (64k x 64k são 16 GB de backbuffer) são
+calculadas bloco a bloco. Cada bloco é uma renderização comum num buffer de
+poster_tile pixels de lado, com o centro deslocado para a sua grade de pixels
+coincidir com a do pôster, e as suas linhas vão direto para a posição final num
+PPM que já nasce com o tamanho completo. A memória só depende do bloco.
+
+<saída>.checkpoint guarda os parâmetros e, uma linha por bloco, os blocos cujas
+linhas já foram gravadas. Uma execução com os mesmos parâmetros pula esses blocos;
+o checkpoint é apagado quando o pôster termina.
+*/
+static b32 HeadlessSeek(FILE *f, i64 offset)
+{
+#ifdef _WIN32
+    return _fseeki64(f, offset, SEEK_SET) == 0;
+#else
+    return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+// Tudo o que muda os pixels; um checkpoint de outros parâmetros descreveria outra imagem
+static void HeadlessPosterSignature(char *out, size_t size, const HeadlessOptions *options, RenderPrecision precision)
+{
+    int length = snprintf(out, size, "mandelbrot-poster %d %d %d %d %s %d %d %a", options->width, options->height,
+                          options->poster_tile, options->iterations, HeadlessPrecisionName(precision),
+                          options->palette_length, options->cycle, options->zoom);
+    const HPReal *centers[2] = {&options->center_x, &options->center_y};
+    for (int c = 0; c < 2; ++c) {
+        length += snprintf(out + length, size - length, " %c", centers[c]->negative ? '-' : '+');
+        for (int i = HP_MAX_LIMBS - 1; i >= 0; --i) {
+            length += snprintf(out + length, size - length, "%08x", centers[c]->limbs[i]);
+        }
+    }
+    snprintf(out + length, size - length, "\n");
+}
+
+static void HeadlessReportPoster(i32 done, i32 total, i64 pixels, f64 seconds, i64 remaining_pixels)
+{
+    f64 rate = seconds > 0.0 ? pixels / seconds : 0.0;
+    i64 eta = rate > 0.0 ? (i64)(remaining_pixels / rate + 0.5) : 0;
+    fprintf(stderr, "\rpôster: %d/%d blocos (%.1f%%), %.2f Mpixel/s, faltam %lld:%02d:%02d ",
+            done, total, 100.0 * done / total, rate / 1000000.0,
+            (long long)(eta / 3600), (int)(eta / 60 % 60), (int)(eta % 60));
+}
+
+static int HeadlessRenderPoster(HeadlessOptions *options)
+{
+    i32 width = options->width;
+    i32 height = options->height;
+    i32 tile = options->poster_tile;
+    i32 tiles_x = (width + tile - 1) / tile;
+    i32 tiles_y = (height + tile - 1) / tile;
+    i32 tile_count = tiles_x * tiles_y;
+
+    // A precisão é escolhida pelo pôster inteiro para todos os blocos usarem o mesmo kernel
+    RenderPrecision precision = options->precision;
+    if (precision == PRECISION_AUTO) {
+        precision = ChooseRenderPrecision(HPToF64(&options->center_x), HPToF64(&options->center_y), options->zoom,
+                                          width, height);
+    }
+
+    char header[64];
+    int header_size = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+    i64 file_size = header_size + (i64)width * height * 3;
+
+    char signature[1024];
+    HeadlessPosterSignature(signature, sizeof(signature), options, precision);
+
+    size_t path_length = strlen(options->output_path);
+    char *checkpoint_path = malloc(path_length + sizeof(".checkpoint"));
+    u8 *is_done = calloc(tile_count, 1);
+    u8 *row_rgb = malloc((size_t)tile * 3);
+    OffscreenBuffer buffer = {0};
+    buffer.bytes_per_pixel = 4;
+    buffer.memory = malloc(sizeof(u32) * (size_t)tile * tile);
+    // Todas as saídas passam pela limpeza do fim, com ok = 0 em qualquer falha
+    b32 ok = checkpoint_path && is_done && row_rgb && buffer.memory;
+    if (!ok) fprintf(stderr, "Sem memória para um bloco de %dx%d\n", tile, tile);
+
+    // Só linhas inteiras contam: um processo morto no meio de um fprintf deixa a última pela metade
+    i32 done_count = 0;
+    FILE *output = NULL;
+    FILE *checkpoint = NULL;
+    if (ok) {
+        memcpy(checkpoint_path, options->output_path, path_length);
+        memcpy(checkpoint_path + path_length, ".checkpoint", sizeof(".checkpoint"));
+        checkpoint = fopen(checkpoint_path, "r");
+    }
+    if (checkpoint) {
+        char line[1024];
+        if (fgets(line, sizeof(line), checkpoint) && strcmp(line, signature) == 0) {
+            while (fgets(line, sizeof(line), checkpoint)) {
+                int index = -1;
+                if (!strchr(line, '\n') || sscanf(line, "%d", &index) != 1) break;
+                if (index >= 0 && index < tile_count && !is_done[index]) {
+                    is_done[index] = 1;
+                    ++done_count;
+                }
+            }
+            output = fopen(options->output_path, "r+b");
+        } else {
+            fprintf(stderr, "%s é de outros parâmetros; recomeçando o pôster\n", checkpoint_path);
+        }
+        fclose(checkpoint);
+        checkpoint = NULL;
+    }
+
+    if (ok && !output) {
+        memset(is_done, 0, tile_count);
+        done_count = 0;
+        // O último byte estende o arquivo até o tamanho final (esparso, onde o sistema deixar)
+        output = fopen(options->output_path, "wb");
+        if (output) {
+            fwrite(header, 1, header_size, output);
+            if (!HeadlessSeek(output, file_size - 1) || fputc(0, output) == EOF) {
+                fclose(output);
+                output = NULL;
+            }
+        }
+    }
+
+    // Reescrito do zero para descartar uma última linha incompleta
+    if (ok) {
+        checkpoint = output ? fopen(checkpoint_path, "w") : NULL;
+        if (!output || !checkpoint) {
+            fprintf(stderr, "Falha ao abrir %s\n", output ? checkpoint_path : options->output_path);
+            ok = 0;
+        }
+    }
+    if (ok) {
+        fputs(signature, checkpoint);
+        for (i32 index = 0; index < tile_count; ++index) {
+            if (is_done[index]) fprintf(checkpoint, "%d\n", index);
+        }
+        fflush(checkpoint);
+    }
+
+    i64 remaining_pixels = 0;
+    for (i32 index = 0; index < tile_count && ok; ++index) {
+        if (is_done[index]) continue;
+        i32 tile_x = index % tiles_x, tile_y = index / tiles_x;
+        i32 tile_width = width - tile_x * tile < tile ? width - tile_x * tile : tile;
+        i32 tile_height = height - tile_y * tile < tile ? height - tile_y * tile : tile;
+        remaining_pixels += (i64)tile_width * tile_height;
+    }
+    if (done_count) {
+        printf("retomando: %d de %d blocos já gravados\n", done_count, tile_count);
+        fflush(stdout);
+    }
+
+    f64 start = HeadlessGetSeconds();
+    f64 last_report = start;
+    i64 session_pixels = 0;
+    for (i32 index = 0; index < tile_count && ok; ++index) {
+        if (is_done[index]) continue;
+
+        i32 x0 = (index % tiles_x) * tile;
+        i32 y0 = (index / tiles_x) * tile;
+        buffer.width = width - x0 < tile ? width - x0 : tile;
+        buffer.height = height - y0 < tile ? height - y0 : tile;
+        buffer.pitch = buffer.width * buffer.bytes_per_pixel;
+
+        // O centro do bloco fica a (x0 + largura/2 - W/2) pixels do centro do pôster
+        HPReal center_x = options->center_x;
+        HPReal center_y = options->center_y;
+        HPAddF64(&center_x, (x0 + buffer.width / 2.0 - width / 2.0) * options->zoom);
+        HPAddF64(&center_y, (y0 + buffer.height / 2.0 - height / 2.0) * options->zoom);
+        RenderMandelbrot(&buffer, &center_x, &center_y, options->zoom, options->iterations, precision);
+
+        for (int y = 0; y < buffer.height && ok; ++y) {
+            u32 *row = (u32 *)((u8 *)buffer.memory + (size_t)y * buffer.pitch);
+            for (int x = 0; x < buffer.width; ++x) {
+                row_rgb[x * 3 + 0] = (u8)(row[x] >> 16);
+                row_rgb[x * 3 + 1] = (u8)(row[x] >> 8);
+                row_rgb[x * 3 + 2] = (u8)(row[x]);
+            }
+            ok = HeadlessSeek(output, header_size + ((i64)(y0 + y) * width + x0) * 3) &&
+                 fwrite(row_rgb, 1, (size_t)buffer.width * 3, output) == (size_t)buffer.width * 3;
+        }
+
+        // O bloco só entra no checkpoint depois que as suas linhas saíram do buffer do stdio
+        if (!ok || fflush(output) != 0) {
+            ok = 0;
+            break;
+        }
+        fprintf(checkpoint, "%d\n", index);
+        fflush(checkpoint);
+
+        ++done_count;
+        i64 pixels = (i64)buffer.width * buffer.height;
+        session_pixels += pixels;
+        remaining_pixels -= pixels;
+        f64 now = HeadlessGetSeconds();
+        if (now - last_report >= 1.0 || done_count == tile_count) {
+            HeadlessReportPoster(done_count, tile_count, session_pixels, now - start, remaining_pixels);
+            last_report = now;
+        }
+    }
+    f64 seconds = HeadlessGetSeconds() - start;
+    if (session_pixels) fprintf(stderr, "\n");
+
+    if (output && fclose(output) != 0) ok = 0;
+    if (checkpoint) fclose(checkpoint);
+    if (ok) {
+        remove(checkpoint_path);
+        printf("pôster %dx%d em %d blocos de %d px, %s, kernel %s: %.3f s, %.2f Mpixel/s\n",
+               width, height, tile_count, tile, HeadlessPrecisionName(precision), GetIterationKernelName(),
+               seconds, seconds > 0.0 ? session_pixels / seconds / 1000000.0 : 0.0);
+    } else if (checkpoint) {
+        fprintf(stderr, "Falha ao gravar %s; os blocos prontos continuam em %s\n", options->output_path,
+                checkpoint_path);
+    }
+
+    free(buffer.memory);
+    free(row_rgb);
+    free(is_done);
+    free(checkpoint_path);
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Filme de zoom
+// ---------------------------------------------------------------------------
+
+// Troca o primeiro %d (ou %0<n>d) do padrão pelo número do frame; 0 se o padrão não tem um
+static b32 HeadlessFramePath(char *out, size_t size, const char *pattern, i32 frame)
+{
+    const char *percent = strchr(pattern, '%');
+    if (!percent) return 0;
+    const char *end = percent + 1;
+    int digits = 0;
+    while (*end >= '0' && *end <= '9') digits = digits * 10 + (*end++ - '0');
+    if (*end != 'd' || digits > 20) return 0;
+
+    int length = snprintf(out, size, "%.*s%0*d%s", (int)(percent - pattern), pattern, digits, frame, end + 1);
+    return length > 0 && (size_t)length < size;
+}
+
+/*
+Os frames saem em ordem, cada um num arquivo numerado ou todos em sequência pela
+saída padrão, para um codificador ler direto do cano (com -f ppm, por exemplo,
+ffmpeg -f image2pipe -i -; com -f raw, -f rawvideo -pixel_format bgra). O zoom
+de cada frame cai numa progressão geométrica, que é o zoom de velocidade constante.
+*/
+static int HeadlessRenderMovie(HeadlessOptions *options)
+{
+    b32 is_piped = strcmp(options->output_path, "-") == 0;
+    // Com o filme na saída padrão, o resumo vai para a de erro
+    FILE *report = is_piped ? stderr : stdout;
+    char frame_path[4096];
+    if (!is_piped && !HeadlessFramePath(frame_path, sizeof(frame_path), options->output_path, 0)) {
+        fprintf(stderr, "%s precisa de um %%d (ou %%0<n>d) para o número do frame\n", options->output_path);
+        return 1;
+    }
+
+    OffscreenBuffer buffer = {0};
+    buffer.width = options->width;
+    buffer.height = options->height;
+    buffer.bytes_per_pixel = 4;
+    buffer.pitch = buffer.width * buffer.bytes_per_pixel;
+    buffer.memory = malloc((size_t)buffer.pitch * buffer.height);
+    if (!buffer.memory || !ZoomMovieBegin(&options->center_x, &options->center_y, options->zoom, options->movie_octaves,
+                                          options->movie_frames, buffer.width, buffer.height, options->iterations,
+                                          options->precision)) {
+        fprintf(stderr, "Sem memória para os quadros-chave de um filme de %dx%d\n", buffer.width, buffer.height);
+        free(buffer.memory);
+        return 1;
+    }
+#ifdef _WIN32
+    if (is_piped) _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    f64 start = HeadlessGetSeconds();
+    f64 last_report = start;
+    b32 ok = 1;
+    for (i32 frame = 0; frame < options->movie_frames && ok; ++frame) {
+        if (!ZoomMovieFrame(frame, &buffer)) {
+            fprintf(stderr, "\nFalha ao calcular os quadros-chave do frame %d\n", frame);
+            ok = 0;
+            break;
+        }
+
+        if (is_piped) {
+            switch (options->format) {
+                case IMAGE_FORMAT_PPM: ok = HeadlessWritePPM(stdout, &buffer); break;
+                case IMAGE_FORMAT_PNG: ok = HeadlessWritePNG(stdout, &buffer); break;
+                case IMAGE_FORMAT_RAW: ok = HeadlessWriteRaw(stdout, &buffer); break;
+            }
+        } else {
+            HeadlessFramePath(frame_path, sizeof(frame_path), options->output_path, frame);
+            ok = HeadlessWriteImage(frame_path, options->format, &buffer);
+        }
+        if (!ok) {
+            fprintf(stderr, "\nFalha ao gravar o frame %d em %s\n", frame, is_piped ? "stdout" : frame_path);
+            break;
+        }
+
+        f64 now = HeadlessGetSeconds();
+        if (now - last_report >= 1.0 || frame + 1 == options->movie_frames) {
+            ZoomMovieStats stats = GetZoomMovieStats();
+            fprintf(stderr, "\rfilme: %d/%d frames, %d quadros-chave, %.1f frames/s ", frame + 1,
+                    options->movie_frames, stats.keyframes, (frame + 1) / (now - start));
+            last_report = now;
+        }
+    }
+    if (is_piped && fflush(stdout) != 0) ok = 0;
+    f64 seconds = HeadlessGetSeconds() - start;
+    fprintf(stderr, "\n");
+
+    // O custo de iteração comparado com calcular cada frame inteiro
+    ZoomMovieStats stats = GetZoomMovieStats();
+    f64 frame_pixels = (f64)buffer.width * buffer.height;
+    f64 equivalent_frames = stats.computed_pixels / frame_pixels;
+    fprintf(report, "filme %dx%d, %d frames em %g oitavas, %d iterações, kernel %s: %.3f s, %.1f frames/s\n",
+            buffer.width, buffer.height, stats.frames, options->movie_octaves, options->iterations,
+            GetIterationKernelName(), seconds, seconds > 0.0 ? stats.frames / seconds : 0.0);
+    fprintf(report, "quadros-chave: %d, %.1f frames inteiros de pixels iterados (%.1fx menos que frame a frame); "
+            "cálculo %.3f s, reamostragem %.3f s\n",
+            stats.keyframes, equivalent_frames, equivalent_frames > 0.0 ? stats.frames / equivalent_frames : 0.0,
+            stats.keyframe_seconds, stats.resample_seconds);
+
+    ZoomMovieEnd();
+    free(buffer.memory);
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Renderização distribuída
+// ---------------------------------------------------------------------------
+
+/*
+Os workers devolvem só as iterações; a coloração (com a equalização, se pedida) e
+a gravação ficam aqui, como depois de uma renderização local.
+*/
+static int HeadlessRenderDistributed(HeadlessOptions *options, OffscreenBuffer *buffer)
+{
+    DistributedView view;
+    view.center_x = options->center_x;
+    view.center_y = options->center_y;
+    view.zoom = options->zoom;
+    view.width = buffer->width;
+    view.height = buffer->height;
+    view.max_iterations = options->iterations;
+    view.precision = options->precision;
+    if (view.precision == PRECISION_AUTO) {
+        view.precision = ChooseRenderPrecision(HPToF64(&view.center_x), HPToF64(&view.center_y), view.zoom,
+                                               view.width, view.height);
+    }
+
+    i32 *iterations = malloc(sizeof(i32) * (size_t)view.width * view.height);
+    if (!iterations) {
+        fprintf(stderr, "Sem memória para as iterações de %dx%d\n", view.width, view.height);
+        return 1;
+    }
+
+    DistributedStats stats;
+    f64 start = HeadlessGetSeconds();
+    b32 is_rendered = DistributedRender(options->coordinator_address, &view, options->spawn_workers, iterations, &stats);
+    f64 elapsed = HeadlessGetSeconds() - start;
+    if (!is_rendered) {
+        free(iterations);
+        return 1;
+    }
+
+    ColorizeFrame(buffer, iterations, view.width, view.max_iterations);
+    free(iterations);
+
+    printf("%dx%d, %d iterações, %s, distribuído: %.3f ms, %.2f Mpixel/s\n", view.width, view.height,
+           view.max_iterations, HeadlessPrecisionName(view.precision), elapsed * 1000.0,
+           (f64)view.width * view.height / 1000000.0 / elapsed);
+    printf("distribuído: %d blocos de %dx%d, %d workers, %d perdidos, %d blocos reatribuídos; "
+           "%.1f MB de iterações em %.1f MB (%.1f%%)\n",
+           stats.tiles, DISTRIBUTED_TILE_SIZE, DISTRIBUTED_TILE_SIZE, stats.workers, stats.lost_workers,
+           stats.reassigned_tiles, stats.raw_bytes / (1024.0 * 1024.0), stats.compressed_bytes / (1024.0 * 1024.0),
+           stats.raw_bytes ? 100.0 * stats.compressed_bytes / stats.raw_bytes : 0.0);
+
+    if (options->output_path && !HeadlessWriteImage(options->output_path, options->format, buffer)) {
+        fprintf(stderr, "Falha ao gravar %s\n", options->output_path);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    HeadlessOptions options = {0};
+    HPFromF64(&options.center_x, -0.75);
+    HPFromF64(&options.center_y, 0.0);
+    options.zoom = 0.004;
+    options.width = 800;
+    options.height = 600;
+    options.iterations = DEFAULT_MAX_ITERATIONS;
+    options.palette_length = PALETTE_DEFAULT_LENGTH;
+    options.repeat = 1;
+    options.scale = 1.0f;
+    options.precision = PRECISION_AUTO;
+    options.movie_octaves = 10.0;
+
+    if (!HeadlessParseOptions(argc, argv, &options)) {
+        HeadlessPrintUsage(argv[0]);
+        return 1;
+    }
+
+    // A paleta é criada fora da medição para não poluir o primeiro frame
+    SetPaletteLength(options.palette_length);
+    InitColorPalette();
+    SetSubdivisionEnabled(options.subdivide);
+    SetDoubleDoubleEnabled(options.double_double);
+    SetThreadPinning(options.pin_threads);
+    SetLaneRefill(!options.no_refill);
+    SetHistogramEqualization(options.histogram);
+    SetPaletteCycle(options.cycle);
+    if (options.tile_cache_megabytes > 0) SetTileCacheLimit((i64)options.tile_cache_megabytes << 20);
+
+    if (options.worker_address) return DistributedWorker(options.worker_address);
+    if (options.serve_address) {
+        TileServerOptions server = {options.serve_address, options.iterations, HeadlessWritePNG};
+        return TileServerRun(&server);
+    }
+    if (options.poster_tile) return HeadlessRenderPoster(&options);
+    if (options.movie_frames) return HeadlessRenderMovie(&options);
+
+    OffscreenBuffer buffer = {0};
+    buffer.width = options.width;
+    buffer.height = options.height;
+    buffer.bytes_per_pixel = 4;
+    buffer.pitch = buffer.width * buffer.bytes_per_pixel;
+    buffer.memory = calloc((size_t)buffer.width * buffer.height, buffer.bytes_per_pixel);
+    if (!buffer.memory) {
+        fprintf(stderr, "Sem memória para um buffer de %dx%d\n", buffer.width, buffer.height);
+        return 1;
+    }
+
+    if (options.coordinator_address) {
+        int exit_code = HeadlessRenderDistributed(&options, &buffer);
+        free(buffer.memory);
+        return exit_code;
+    }
+
+    // Sem janela não há eventos nem apresentação: cada frame medido é só a renderização
+    SetProfilingEnabled(options.trace_path || options.overlay);
+
+    if (options.progressive) {
+        f64 first_seconds = 0.0, worst_seconds = 0.0, total = 0.0;
+        f32 time_delta = 0.0f;
+        int calls = 0;
+        b32 is_complete = 0;
+        while (!is_complete) {
+            ProfileFrameBegin();
+            ProfileZone zone = ProfileBeginPhase(PROFILE_PHASE_RENDER);
+            f64 start = HeadlessGetSeconds();
+            is_complete = RenderMandelbrotProgressive(&buffer, &options.center_x, &options.center_y, options.zoom,
+                                                      options.iterations, options.precision, time_delta);
+            f64 elapsed = HeadlessGetSeconds() - start;
+            ProfileEnd(&zone);
+            ProfileFrameEnd();
+            time_delta = (f32)elapsed;
+
+            if (calls == 0) first_seconds = elapsed;
+            if (elapsed > worst_seconds) worst_seconds = elapsed;
+            total += elapsed;
+            ++calls;
+        }
+        printf("%dx%d, %d iterações, progressivo: %d chamadas, primeira %.3f ms, pior %.3f ms, total %.3f ms\n",
+               buffer.width, buffer.height, options.iterations, calls,
+               first_seconds * 1000.0, worst_seconds * 1000.0, total * 1000.0);
+        options.repeat = 0;
+    }
+
+    f64 total_seconds = 0.0;
+    f64 best_seconds = 0.0;
+    RenderPrecision used_precision = options.precision;
+    for (int run = 0; run < options.repeat; ++run) {
+        if (options.adaptive) options.iterations = ChooseAdaptiveIterations(options.iterations, options.zoom);
+        ProfileFrameBegin();
+        ProfileZone zone = ProfileBeginPhase(PROFILE_PHASE_RENDER);
+        f64 start = HeadlessGetSeconds();
+        if (options.tile_cache_megabytes > 0) {
+            if (run > 0) HPAddF64(&options.center_x, options.pan * options.zoom);
+            used_precision = RenderMandelbrotCached(&buffer, &options.center_x, &options.center_y, options.zoom,
+                                                    options.iterations, options.precision);
+        } else if (options.pan || options.scale < 1.0f) {
+            if (run > 0) HPAddF64(&options.center_x, options.pan * options.zoom);
+            used_precision = RenderMandelbrotScaled(&buffer, &options.center_x, &options.center_y, options.zoom,
+                                                    options.iterations, options.precision, options.scale);
+        } else if (options.subdivide) {
+            used_precision = RenderMandelbrotSubdivided(&buffer, &options.center_x, &options.center_y, options.zoom,
+                                                        options.iterations, options.precision);
+        } else {
+            used_precision = RenderMandelbrot(&buffer, &options.center_x, &options.center_y, options.zoom,
+                                              options.iterations, options.precision);
+        }
+        f64 elapsed = HeadlessGetSeconds() - start;
+        ProfileEnd(&zone);
+        ProfileFrameEnd();
+
+        total_seconds += elapsed;
+        if (run == 0 || elapsed < best_seconds) best_seconds = elapsed;
+    }
+
+    f64 mpixels = (f64)buffer.width * buffer.height / 1000000.0;
+    f64 mean_seconds = options.repeat ? total_seconds / options.repeat : 0.0;
+    if (options.repeat) printf("%dx%d, %d iterações, %s, kernel %s, %d execuções: média %.3f ms, melhor %.3f ms, %.2f Mpixel/s\n",
+           buffer.width, buffer.height, options.iterations, HeadlessPrecisionName(used_precision),
+           GetIterationKernelName(), options.repeat,
+           mean_seconds * 1000.0, best_seconds * 1000.0, mpixels / best_seconds);
+
+    IterationLimitStats limit_stats;
+    if (options.repeat && GetIterationLimitStats(&limit_stats) && limit_stats.sampled_pixels) {
+        printf("limite: %.3f%% dos pixels no limite, %.3f%% escaparam na metade de cima, maior contagem %d%s\n",
+               100.0 * limit_stats.limit_pixels / limit_stats.sampled_pixels,
+               100.0 * limit_stats.late_pixels / limit_stats.sampled_pixels, limit_stats.max_escaped,
+               options.adaptive ? " (adaptativo)" : "");
+    }
+
+    if (options.pan) {
+        IncrementalStats stats = GetIncrementalStats();
+        printf("incremental: último frame calculou %lld pixels e reaproveitou %lld (%.1f%%)\n",
+               (long long)stats.computed_pixels, (long long)stats.reused_pixels,
+               100.0 * stats.reused_pixels / ((f64)buffer.width * buffer.height));
+    }
+
+    if (options.tile_cache_megabytes > 0 && options.repeat) {
+        TileCacheStats stats = GetTileCacheStats();
+        printf("cache de blocos: último frame com %lld acertos e %lld faltas; %d blocos de %d px guardados (%.1f MB)\n",
+               (long long)stats.hits, (long long)stats.misses, stats.tiles, TILE_CACHE_SIZE,
+               stats.bytes / (1024.0 * 1024.0));
+    }
+
+    if (options.repeat) {
+        printf("saídas antecipadas: último frame economizou %lld iterações\n", (long long)GetSavedIterations());
+    }
+
+    TileStats tile_stats = GetTileStats();
+    if (options.repeat && tile_stats.tiles) {
+        f64 imbalance = tile_stats.mean_busy_seconds > 0.0 ? tile_stats.max_busy_seconds / tile_stats.mean_busy_seconds : 1.0;
+        printf("blocos: %lld de %dx%d em %d threads, %lld roubos; ocupação máxima %.3f ms, média %.3f ms "
+               "(desequilíbrio %.2f)\n",
+               (long long)tile_stats.tiles, tile_stats.tile_width, tile_stats.tile_height, tile_stats.threads,
+               (long long)tile_stats.steals, tile_stats.max_busy_seconds * 1000.0,
+               tile_stats.mean_busy_seconds * 1000.0, imbalance);
+    }
+
+    if (options.subdivide && options.repeat) {
+        SubdivisionStats stats = GetSubdivisionStats();
+        printf("subdivisão: último frame iterou %lld pixels e preencheu %lld sem iterar\n",
+               (long long)stats.computed_pixels, (long long)stats.filled_pixels);
+    }
+
+    if (used_precision == PRECISION_DEEP) {
+        PerturbationStats stats = GetPerturbationStats();
+        printf("deep: referência com %d pontos (%d limbs, %s), série pulou %d iterações, desvios em %s\n",
+               stats.reference_length, stats.reference_limbs, stats.reference_reused ? "reaproveitada" : "nova",
+               stats.series_skip, HeadlessPrecisionName(stats.lanes));
+    }
+
+    // O fractal não é recalculado: só a tabela de cores muda e o buffer de iterações é relido
+    if (options.recolor > 0) {
+        f64 recolor_seconds = 0.0;
+        for (int run = 0; run < options.recolor; ++run) {
+            SetPaletteCycle(GetPaletteCycle() + 1);
+            f64 start = HeadlessGetSeconds();
+            RecolorMandelbrot(&buffer);
+            recolor_seconds += HeadlessGetSeconds() - start;
+        }
+        printf("recoloração: %d passadas, média %.3f ms\n", options.recolor, recolor_seconds * 1000.0 / options.recolor);
+    }
+
+    int exit_code = 0;
+    ProfileSummary summary;
+    if (IsProfilingEnabled && GetProfileSummary(&summary)) {
+        const ProfilePhaseSummary *render = &summary.phases[PROFILE_PHASE_RENDER];
+        printf("instrumentação: %d frames, render p50 %.3f ms, p99 %.3f ms, máximo %.3f ms; "
+               "último frame %lld pixels, %lld iterações\n",
+               summary.frames, render->p50_ms, render->p99_ms, render->max_ms,
+               (long long)summary.pixels, (long long)summary.iterations);
+    }
+    if (options.trace_path) {
+        if (ProfileWriteChromeTrace(options.trace_path)) {
+            printf("trace gravado em %s\n", options.trace_path);
+        } else {
+            fprintf(stderr, "Falha ao gravar %s\n", options.trace_path);
+            exit_code = 1;
+        }
+    }
+    if (options.overlay) ProfileDrawOverlay(&buffer);
+
+    if (options.output_path) {
+        if (!HeadlessWriteImage(options.output_path, options.format, &buffer)) {
+            fprintf(stderr, "Falha ao gravar %s\n", options.output_path);
+            exit_code = 1;
+        }
+    }
+
+    free(buffer.memory);
+    return exit_code;
+}
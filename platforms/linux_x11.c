@@ -1,229 +1,631 @@
-#include <X11/Xlib.h>
-#include <X11/Xutil.h>
-#include <X11/keysym.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stdio.h>
-#include <time.h>
-
-#include "platform.h"
-
-static b32 global_running = 1;
-static OffscreenBuffer global_backbuffer;
-static XImage *global_ximage = NULL;
-
-static void LinuxResizeBuffer(Display *display, int width, int height)
-{
-    if (global_ximage) {
-        XDestroyImage(global_ximage);
-        global_ximage = NULL;
-    }
-
-    if (global_backbuffer.memory) {
-        free(global_backbuffer.memory);
-        global_backbuffer.memory = NULL;
-    }
-
-    global_backbuffer.width = width;
-    global_backbuffer.height = height;
-    global_backbuffer.bytes_per_pixel = 4;
-    global_backbuffer.pitch = width * global_backbuffer.bytes_per_pixel;
-
-    int size = width * height * global_backbuffer.bytes_per_pixel;
-    global_backbuffer.memory = malloc(size);
-    if (global_backbuffer.memory) memset(global_backbuffer.memory, 0, size);
-
-    int screen = DefaultScreen(display);
-    int depth = DefaultDepth(display, screen);
-
-    global_ximage = XCreateImage(display, DefaultVisual(display, screen), depth, ZPixmap, 0,
-                                    (char *)global_backbuffer.memory, width, height, 32, 0);
-}
-
-static void LinuxProcessKeyboard(ButtonState *new_state, b32 is_down)
-{
-    if (new_state->is_ended_down != is_down) {
-        new_state->is_ended_down = is_down;
-        new_state->half_transition_count++;
-    }
-}
-
-static KeyId LinuxKeysymToKeyCode(KeySym keysym)
-{
-    switch (keysym) {
-        case XK_Up:    return KEY_UP;
-        case XK_Down:  return KEY_DOWN;
-        case XK_Left:  return KEY_LEFT;
-        case XK_Right: return KEY_RIGHT;
-        case XK_a: case XK_A: return KEY_A;
-        case XK_b: case XK_B: return KEY_B;
-        case XK_c: case XK_C: return KEY_C;
-        case XK_d: case XK_D: return KEY_D;
-        case XK_e: case XK_E: return KEY_E;
-        case XK_f: case XK_F: return KEY_F;
-        case XK_g: case XK_G: return KEY_G;
-        case XK_h: case XK_H: return KEY_H;
-        case XK_i: case XK_I: return KEY_I;
-        case XK_j: case XK_J: return KEY_J;
-        case XK_k: case XK_K: return KEY_K;
-        case XK_l: case XK_L: return KEY_L;
-        case XK_m: case XK_M: return KEY_M;
-        case XK_n: case XK_N: return KEY_N;
-        case XK_o: case XK_O: return KEY_O;
-        case XK_p: case XK_P: return KEY_P;
-        case XK_q: case XK_Q: return KEY_Q;
-        case XK_r: case XK_R: return KEY_R;
-        case XK_s: case XK_S: return KEY_S;
-        case XK_t: case XK_T: return KEY_T;
-        case XK_u: case XK_U: return KEY_U;
-        case XK_v: case XK_V: return KEY_V;
-        case XK_w: case XK_W: return KEY_W;
-        case XK_x: case XK_X: return KEY_X;
-        case XK_y: case XK_Y: return KEY_Y;
-        case XK_z: case XK_Z: return KEY_Z;
-        case XK_0: return KEY_0;
-        case XK_1: return KEY_1;
-        case XK_2: return KEY_2;
-        case XK_3: return KEY_3;
-        case XK_4: return KEY_4;
-        case XK_5: return KEY_5;
-        case XK_6: return KEY_6;
-        case XK_7: return KEY_7;
-        case XK_8: return KEY_8;
-        case XK_9: return KEY_9;
-        case XK_space:  return KEY_SPACE;
-        case XK_Return: return KEY_ENTER;
-        case XK_Escape: return KEY_ESC;
-        case XK_Shift_L: case XK_Shift_R: return KEY_SHIFT;
-        case XK_Control_L: case XK_Control_R: return KEY_CTRL;
-        case XK_Alt_L: case XK_Alt_R: return KEY_ALT;
-        case XK_Tab: return KEY_TAB;
-        case XK_plus: case XK_equal: return KEY_PLUS;
-        case XK_minus: case XK_underscore: return KEY_MINUS;
-        default: return KEY_COUNT;
-    }
-}
-
-FileData PlatformFileRead(const char *path)
-{
-    FileData result = {0};
-    if (!path) return result;
-
-    FILE *f = fopen(path, "rb");
-    if (!f) return result;
-
-    fseek(f, 0, SEEK_END);
-    long size = ftell(f);
-    fseek(f, 0, SEEK_SET);
-
-    if (size > 0) {
-        result.data = malloc(size);
-        if (result.data) {
-            size_t read = fread(result.data, 1, size, f);
-            result.size = read;
-            if (read != (size_t)size) {
-                free(result.data);
-                result.data = NULL;
-                result.size = 0;
-            }
-        }
-    }
-
-    fclose(f);
-    return result;
-}
-
-void PlatformFileFree(FileData *fd)
-{
-    if (fd && fd->data) {
-        free(fd->data);
-        fd->data = NULL;
-        fd->size = 0;
-    }
-}
-
-int main(void)
-{
-    Display *display = XOpenDisplay(NULL);
-    if (!display) return 1;
-
-    int screen = DefaultScreen(display);
-    Window window = XCreateSimpleWindow(display, RootWindow(display, screen),
-                                        10, 10, 800, 600, 1,
-                                        BlackPixel(display, screen), WhitePixel(display, screen));
-
-    XSelectInput(display, window, ExposureMask | KeyPressMask | KeyReleaseMask | StructureNotifyMask
-                 | ButtonPressMask | ButtonReleaseMask | PointerMotionMask);
-    XMapWindow(display, window);
-
-    Atom wm_delete_window = XInternAtom(display, "WM_DELETE_WINDOW", False);
-    XSetWMProtocols(display, window, &wm_delete_window, 1);
-
-    Input input = {0};
-    input.mouse_wheel = 0.0f;
-    LinuxResizeBuffer(display, 800, 600);
-
-    struct timespec prev_time;
-    clock_gettime(CLOCK_MONOTONIC, &prev_time);
-
-    while (global_running) {
-        input.mouse_wheel = 0.0f;
-        while (XPending(display) > 0) {
-            XEvent event;
-            XNextEvent(display, &event);
-
-            if (event.type == ClientMessage)
-            {
-                if ((Atom)event.xclient.data.l[0] == wm_delete_window) global_running = 0;
-            }
-            else if (event.type == ConfigureNotify)
-            {
-                XConfigureEvent ce = event.xconfigure;
-                if (ce.width != global_backbuffer.width || ce.height != global_backbuffer.height) {
-                    LinuxResizeBuffer(display, ce.width, ce.height);
-                }
-            }
-            else if (event.type == KeyPress || event.type == KeyRelease)
-            {
-                KeySym keysym = XLookupKeysym(&event.xkey, 0);
-                b32 is_down = (event.type == KeyPress);
-                KeyCode kc = LinuxKeysymToKeyCode(keysym);
-                if (kc != KEY_COUNT) LinuxProcessKeyboard(&input.keys[kc], is_down);
-            }
-            else if (event.type == MotionNotify)
-            {
-                XMotionEvent *me = &event.xmotion;
-                input.mouse_x = me->x;
-                input.mouse_y = me->y;
-            } else if (event.type == ButtonPress || event.type == ButtonRelease)
-            {
-                XButtonEvent *be = &event.xbutton;
-                input.mouse_x = be->x;
-                input.mouse_y = be->y;
-                b32 pressed = (event.type == ButtonPress);
-                if (be->button == Button1) LinuxProcessKeyboard(&input.mouse_buttons[0], pressed);
-                else if (be->button == Button2) LinuxProcessKeyboard(&input.mouse_buttons[1], pressed);
-                else if (be->button == Button3) LinuxProcessKeyboard(&input.mouse_buttons[2], pressed);
-                else if (be->button == Button4 && pressed) input.mouse_wheel += 1.0f;
-                else if (be->button == Button5 && pressed) input.mouse_wheel -= 1.0f;
-            }
-        }
-
-        struct timespec current_time;
-        clock_gettime(CLOCK_MONOTONIC, &current_time);
-        long dt_ns = (current_time.tv_sec - prev_time.tv_sec) * 1000000000LL +
-                     (current_time.tv_nsec - prev_time.tv_nsec);
-        input.time_delta = (float)dt_ns / 1000000000.0f;
-        prev_time = current_time;
-
-        UpdateAndRender(&input, &global_backbuffer);
-
-        if (global_ximage) {
-            XPutImage(display, window, DefaultGC(display, screen), global_ximage,
-                        0, 0, 0, 0, global_backbuffer.width, global_backbuffer.height);
-        }
-    }
-
-    XCloseDisplay(display);
-    return 0;
-}
\ No newline at end of file
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE // MAP_HUGETLB, MADV_HUGEPAGE e SHM_HUGETLB
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <X11/XKBlib.h>
+#include <X11/extensions/XShm.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/mman.h>
+
+#include "platform.h"
+#include "profiler.h"
+
+/*
+Buffer triplo entre a thread da janela e a de renderização. A renderização sempre
+tem um buffer só seu para desenhar; ao terminar um frame, troca-o pelo "pronto".
+A janela, quando há frame novo, troca o seu buffer de exibição pelo pronto e o
+apresenta. Nenhuma das duas espera a outra: a janela continua tratando eventos
+enquanto um frame demora, e o frame pronto é exibido sem esperar o próximo.
+
+Só a thread da janela chama o Xlib; as XImage de cada buffer são feitas por ela
+na hora de exibir, porque a renderização pode ter realocado o buffer.
+
+Com a extensão MIT-SHM os buffers são segmentos de memória compartilhada com o
+servidor X: a renderização desenha direto neles e exibir não copia a imagem pelo
+socket (a 4K seriam 33 MB por frame). O servidor lê o segmento depois que
+XShmPutImage retorna, então o buffer exibido só volta para a renderização depois
+do evento de conclusão. Sem a extensão (ou com o servidor em outra máquina, que
+não consegue anexar o segmento) tudo volta para XPutImage.
+*/
+#define PRESENT_BUFFER_COUNT 3
+
+/*
+Memória dos buffers. Arrastar a borda da janela manda dezenas de ConfigureNotify por
+segundo; cada buffer guarda a capacidade alocada e só troca de memória quando o frame
+novo não cabe nela ou usa menos de 1/FRAMEBUFFER_SHRINK_RATIO dela. Ao crescer sobra
+uma folga, para os próximos passos do arrasto caberem no mesmo bloco.
+
+Cada linha começa alinhada a 64 bytes (pitch arredondado), então a coloração grava
+linhas inteiras com stores alinhados. Frames grandes pedem páginas enormes: de
+hugetlbfs se houver páginas reservadas, senão as transparentes do kernel.
+*/
+#define FRAMEBUFFER_ROW_ALIGNMENT 64
+#define FRAMEBUFFER_GROWTH_PERCENT 25
+#define FRAMEBUFFER_SHRINK_RATIO 4
+#define FRAMEBUFFER_PAGE_BYTES ((size_t)4096)
+#define FRAMEBUFFER_HUGE_PAGE_BYTES ((size_t)2 << 20)
+#define FRAMEBUFFER_HUGE_MIN_BYTES ((size_t)8 << 20) // A partir de ~1440p
+
+typedef struct {
+    OffscreenBuffer buffer;
+    size_t capacity;           // Bytes alocados em buffer.memory, que pode ser maior que pitch * height
+    int shm_id;                // Segmento da memória do buffer, ou -1 se veio de mmap
+    XImage *image;
+    XShmSegmentInfo shm_info;  // Segmento anexado ao servidor para 'image'; shmaddr NULL se nenhum
+} PresentBuffer;
+
+typedef struct {
+    pthread_mutex_t lock;
+    PresentBuffer buffers[PRESENT_BUFFER_COUNT];
+    i32 render_index;  // Da thread de renderização
+    i32 ready_index;   // Último frame completo
+    i32 front_index;   // Da thread da janela
+    b32 is_ready_new;
+    Input input;       // Estado do teclado e do mouse, acumulado pela janela
+    b32 is_input_new;  // Algo mudou desde a última cópia; acorda a renderização parada
+    pthread_cond_t input_changed;
+    i32 width;         // Tamanho pedido pela janela
+    i32 height;
+    b32 is_running;
+    b32 use_shm;       // Buffers novos em memória compartilhada; a janela desliga se o servidor recusar
+    int wake_pipe[2];  // A renderização escreve um byte a cada frame pronto, para acordar a janela
+} FrameExchange;
+
+static b32 global_running = 1;
+static FrameExchange global_exchange;
+static b32 global_shm_error = 0;
+
+static void LinuxFreeBuffer(PresentBuffer *present)
+{
+    OffscreenBuffer *buffer = &present->buffer;
+    if (!buffer->memory) return;
+
+    if (present->shm_id >= 0) {
+        // Se o servidor ainda tem o segmento anexado, ele só some quando a janela o soltar
+        shmdt(buffer->memory);
+        shmctl(present->shm_id, IPC_RMID, NULL);
+        present->shm_id = -1;
+    } else {
+        munmap(buffer->memory, present->capacity);
+    }
+    buffer->memory = NULL;
+    present->capacity = 0;
+}
+
+static size_t LinuxRoundUp(size_t value, size_t multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// Memória nova vem zerada, mas sem páginas; retorna NULL se nem a alocação comum der certo
+static void *LinuxAllocateBuffer(PresentBuffer *present, size_t capacity, b32 use_shm)
+{
+    b32 is_huge = capacity >= FRAMEBUFFER_HUGE_MIN_BYTES;
+
+    if (use_shm) {
+#ifdef SHM_HUGETLB
+        present->shm_id = is_huge ? shmget(IPC_PRIVATE, capacity, IPC_CREAT | SHM_HUGETLB | 0600) : -1;
+#else
+        present->shm_id = -1;
+#endif
+        if (present->shm_id < 0) present->shm_id = shmget(IPC_PRIVATE, capacity, IPC_CREAT | 0600);
+        if (present->shm_id >= 0) {
+            void *memory = shmat(present->shm_id, NULL, 0);
+            if (memory != (void *)-1) return memory;
+            shmctl(present->shm_id, IPC_RMID, NULL);
+            present->shm_id = -1;
+        }
+    }
+
+    void *memory = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    // Sem páginas reservadas em /proc/sys/vm/nr_hugepages isto falha na hora
+    if (is_huge) memory = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (memory == MAP_FAILED) {
+        memory = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) return NULL;
+#ifdef MADV_HUGEPAGE
+        if (is_huge) madvise(memory, capacity, MADV_HUGEPAGE);
+#endif
+    }
+    return memory;
+}
+
+static void LinuxResizeBuffer(PresentBuffer *present, int width, int height, b32 use_shm)
+{
+    OffscreenBuffer *buffer = &present->buffer;
+    buffer->width = width;
+    buffer->height = height;
+    buffer->bytes_per_pixel = 4;
+    buffer->pitch = (int)LinuxRoundUp((size_t)width * buffer->bytes_per_pixel, FRAMEBUFFER_ROW_ALIGNMENT);
+
+    // Cabe na memória atual sem desperdiçar demais: só o tamanho muda, o próximo frame cobre tudo
+    size_t size = (size_t)buffer->pitch * height;
+    b32 is_kind_kept = present->shm_id < 0 || use_shm;
+    if (buffer->memory && is_kind_kept && size <= present->capacity &&
+        size * FRAMEBUFFER_SHRINK_RATIO >= present->capacity) {
+        return;
+    }
+
+    LinuxFreeBuffer(present);
+    size_t capacity = size + size * FRAMEBUFFER_GROWTH_PERCENT / 100;
+    capacity = LinuxRoundUp(capacity > 0 ? capacity : 1,
+                            capacity >= FRAMEBUFFER_HUGE_MIN_BYTES ? FRAMEBUFFER_HUGE_PAGE_BYTES : FRAMEBUFFER_PAGE_BYTES);
+    u8 *memory = LinuxAllocateBuffer(present, capacity, use_shm);
+    if (!memory) return;
+    buffer->memory = memory;
+    present->capacity = capacity;
+
+    // Primeiro toque pelas threads que vão colorir cada linha, na mesma divisão estática da
+    // coloração: numa máquina NUMA as páginas ficam no nó de quem escreve nelas
+    int pitch = buffer->pitch;
+    #pragma omp parallel for schedule(static)
+    for (int y = 0; y < height; ++y) {
+        memset(memory + (size_t)y * pitch, 0, (size_t)pitch);
+    }
+}
+
+static int LinuxShmErrorHandler(Display *display, XErrorEvent *error)
+{
+    (void)display;
+    (void)error;
+    global_shm_error = 1;
+    return 0;
+}
+
+// Anexa o segmento ao servidor; um servidor remoto responde com erro, que precisa ser esperado com XSync
+static b32 LinuxShmAttach(Display *display, XShmSegmentInfo *info)
+{
+    global_shm_error = 0;
+    XErrorHandler previous = XSetErrorHandler(LinuxShmErrorHandler);
+    XShmAttach(display, info);
+    XSync(display, False);
+    XSetErrorHandler(previous);
+    if (global_shm_error) return 0;
+
+    // Marcado para remoção: o segmento some quando os dois lados soltarem, mesmo se o programa cair
+    shmctl(info->shmid, IPC_RMID, NULL);
+    return 1;
+}
+
+// Só a estrutura da XImage; o segmento continua anexado ao servidor
+static void LinuxFreeImage(PresentBuffer *present)
+{
+    if (!present->image) return;
+    // A memória é do buffer; XDestroyImage a liberaria junto
+    present->image->data = NULL;
+    XDestroyImage(present->image);
+    present->image = NULL;
+}
+
+static void LinuxDestroyImage(Display *display, PresentBuffer *present)
+{
+    LinuxFreeImage(present);
+    if (present->shm_info.shmaddr) {
+        XShmDetach(display, &present->shm_info);
+        present->shm_info.shmaddr = NULL;
+    }
+}
+
+// Retorna true se a imagem foi por memória compartilhada e o buffer ainda está sendo lido pelo servidor
+static b32 LinuxPresentBuffer(Display *display, Window window, PresentBuffer *present, b32 *use_shm)
+{
+    OffscreenBuffer *buffer = &present->buffer;
+    if (!buffer->memory) return 0;
+
+    // As imagens têm a largura do pitch, para as linhas caírem no alinhamento do buffer; só buffer->width é exibido
+    int screen = DefaultScreen(display);
+    int image_width = buffer->pitch / buffer->bytes_per_pixel;
+    XImage *image = present->image;
+    if (!image || image->data != (char *)buffer->memory || image->width != image_width ||
+        image->height != buffer->height || (present->shm_info.shmaddr && present->shm_info.shmid != present->shm_id)) {
+        // Um segmento novo pode ser mapeado no mesmo endereço do antigo; o id diz se é outro.
+        // Sendo o mesmo (o buffer só mudou de tamanho dentro da capacidade), o anexo é reaproveitado
+        b32 is_attached = present->shm_info.shmaddr == (char *)buffer->memory &&
+                          present->shm_info.shmid == present->shm_id && *use_shm;
+        if (is_attached) LinuxFreeImage(present);
+        else LinuxDestroyImage(display, present);
+        image = NULL;
+
+        if (present->shm_id >= 0 && *use_shm) {
+            image = XShmCreateImage(display, DefaultVisual(display, screen), DefaultDepth(display, screen),
+                                    ZPixmap, NULL, &present->shm_info, image_width, buffer->height);
+            if (image && is_attached) {
+                image->data = (char *)buffer->memory;
+            } else if (image) {
+                present->shm_info.shmid = present->shm_id;
+                present->shm_info.shmaddr = image->data = (char *)buffer->memory;
+                present->shm_info.readOnly = False;
+                if (!LinuxShmAttach(display, &present->shm_info)) {
+                    fprintf(stderr, "O servidor X não anexou a memória compartilhada; usando XPutImage\n");
+                    present->shm_info.shmaddr = NULL;
+                    image->data = NULL;
+                    XDestroyImage(image);
+                    image = NULL;
+                    *use_shm = 0;
+                }
+            }
+        }
+        if (!image) {
+            image = XCreateImage(display, DefaultVisual(display, screen), DefaultDepth(display, screen),
+                                 ZPixmap, 0, (char *)buffer->memory, image_width, buffer->height, 32, buffer->pitch);
+        }
+        present->image = image;
+        if (!image) return 0;
+    }
+
+    if (present->shm_info.shmaddr) {
+        XShmPutImage(display, window, DefaultGC(display, screen), image,
+                     0, 0, 0, 0, buffer->width, buffer->height, True);
+        return 1;
+    }
+    XPutImage(display, window, DefaultGC(display, screen), image, 0, 0, 0, 0, buffer->width, buffer->height);
+    return 0;
+}
+
+static void *LinuxRenderThread(void *parameter)
+{
+    FrameExchange *exchange = parameter;
+    Input input = {0};
+
+    struct timespec prev_time;
+    clock_gettime(CLOCK_MONOTONIC, &prev_time);
+
+    for (;;) {
+        pthread_mutex_lock(&exchange->lock);
+        if (!exchange->is_running) {
+            pthread_mutex_unlock(&exchange->lock);
+            break;
+        }
+        OffscreenBuffer *buffer = &exchange->buffers[exchange->render_index].buffer;
+        PresentBuffer *present = &exchange->buffers[exchange->render_index];
+        i32 width = exchange->width, height = exchange->height;
+        b32 use_shm = exchange->use_shm;
+        pthread_mutex_unlock(&exchange->lock);
+
+        if (buffer->width != width || buffer->height != height || !buffer->memory ||
+            (present->shm_id >= 0 && !use_shm)) {
+            LinuxResizeBuffer(present, width, height, use_shm);
+        }
+
+        // Sem memória para o frame: a entrada fica acumulada na troca e a alocação é tentada de novo
+        // quando chegar entrada nova (um redimensionamento, por exemplo)
+        if (!buffer->memory) {
+            pthread_mutex_lock(&exchange->lock);
+            exchange->is_input_new = 0;
+            while (!exchange->is_input_new && exchange->is_running) {
+                pthread_cond_wait(&exchange->input_changed, &exchange->lock);
+            }
+            pthread_mutex_unlock(&exchange->lock);
+            clock_gettime(CLOCK_MONOTONIC, &prev_time);
+            continue;
+        }
+
+        // Copia a entrada e zera o que é acumulado entre frames; o estado das teclas continua
+        pthread_mutex_lock(&exchange->lock);
+        input = exchange->input;
+        exchange->is_input_new = 0;
+        exchange->input.mouse_wheel = 0.0f;
+        for (int k = 0; k < KEY_COUNT; ++k) exchange->input.keys[k].half_transition_count = 0;
+        for (int b = 0; b < 3; ++b) exchange->input.mouse_buttons[b].half_transition_count = 0;
+        pthread_mutex_unlock(&exchange->lock);
+
+        struct timespec current_time;
+        clock_gettime(CLOCK_MONOTONIC, &current_time);
+        long dt_ns = (current_time.tv_sec - prev_time.tv_sec) * 1000000000LL +
+                     (current_time.tv_nsec - prev_time.tv_nsec);
+        input.time_delta = (float)dt_ns / 1000000000.0f;
+        prev_time = current_time;
+
+        // Frame medido pela instrumentação (tecla O ou T); desligada, cada marca é só um teste
+        ProfileFrameBegin();
+        ProfileZone render_zone = ProfileBeginPhase(PROFILE_PHASE_RENDER);
+        b32 is_drawn = UpdateAndRender(&input, buffer);
+        ProfileEnd(&render_zone);
+        ProfileFrameEnd();
+
+        // Nada mudou: em vez de girar em falso, dorme até a janela trazer entrada nova (ou pedir para sair)
+        if (!is_drawn) {
+            pthread_mutex_lock(&exchange->lock);
+            while (!exchange->is_input_new && exchange->is_running) {
+                pthread_cond_wait(&exchange->input_changed, &exchange->lock);
+            }
+            pthread_mutex_unlock(&exchange->lock);
+            // O tempo parado não é tempo de frame
+            clock_gettime(CLOCK_MONOTONIC, &prev_time);
+            continue;
+        }
+
+        // Interrompido porque a vista mudou: o buffer está pela metade e o próximo frame já vem com a entrada nova
+        if (IsRenderCancelled()) continue;
+
+        pthread_mutex_lock(&exchange->lock);
+        i32 finished = exchange->render_index;
+        exchange->render_index = exchange->ready_index;
+        exchange->ready_index = finished;
+        exchange->is_ready_new = 1;
+        pthread_mutex_unlock(&exchange->lock);
+
+        char wake = 1;
+        if (write(exchange->wake_pipe[1], &wake, 1) < 0) {
+            // Cano cheio: a janela ainda vai acordar pelos bytes que já estão lá
+        }
+    }
+    return NULL;
+}
+
+static void LinuxProcessKeyboard(ButtonState *new_state, b32 is_down)
+{
+    if (new_state->is_ended_down != is_down) {
+        new_state->is_ended_down = is_down;
+        new_state->half_transition_count++;
+    }
+}
+
+static KeyId LinuxKeysymToKeyCode(KeySym keysym)
+{
+    switch (keysym) {
+        case XK_Up:    return KEY_UP;
+        case XK_Down:  return KEY_DOWN;
+        case XK_Left:  return KEY_LEFT;
+        case XK_Right: return KEY_RIGHT;
+        case XK_a: case XK_A: return KEY_A;
+        case XK_b: case XK_B: return KEY_B;
+        case XK_c: case XK_C: return KEY_C;
+        case XK_d: case XK_D: return KEY_D;
+        case XK_e: case XK_E: return KEY_E;
+        case XK_f: case XK_F: return KEY_F;
+        case XK_g: case XK_G: return KEY_G;
+        case XK_h: case XK_H: return KEY_H;
+        case XK_i: case XK_I: return KEY_I;
+        case XK_j: case XK_J: return KEY_J;
+        case XK_k: case XK_K: return KEY_K;
+        case XK_l: case XK_L: return KEY_L;
+        case XK_m: case XK_M: return KEY_M;
+        case XK_n: case XK_N: return KEY_N;
+        case XK_o: case XK_O: return KEY_O;
+        case XK_p: case XK_P: return KEY_P;
+        case XK_q: case XK_Q: return KEY_Q;
+        case XK_r: case XK_R: return KEY_R;
+        case XK_s: case XK_S: return KEY_S;
+        case XK_t: case XK_T: return KEY_T;
+        case XK_u: case XK_U: return KEY_U;
+        case XK_v: case XK_V: return KEY_V;
+        case XK_w: case XK_W: return KEY_W;
+        case XK_x: case XK_X: return KEY_X;
+        case XK_y: case XK_Y: return KEY_Y;
+        case XK_z: case XK_Z: return KEY_Z;
+        case XK_0: return KEY_0;
+        case XK_1: return KEY_1;
+        case XK_2: return KEY_2;
+        case XK_3: return KEY_3;
+        case XK_4: return KEY_4;
+        case XK_5: return KEY_5;
+        case XK_6: return KEY_6;
+        case XK_7: return KEY_7;
+        case XK_8: return KEY_8;
+        case XK_9: return KEY_9;
+        case XK_space:  return KEY_SPACE;
+        case XK_Return: return KEY_ENTER;
+        case XK_Escape: return KEY_ESC;
+        case XK_Shift_L: case XK_Shift_R: return KEY_SHIFT;
+        case XK_Control_L: case XK_Control_R: return KEY_CTRL;
+        case XK_Alt_L: case XK_Alt_R: return KEY_ALT;
+        case XK_Tab: return KEY_TAB;
+        case XK_plus: case XK_equal: return KEY_PLUS;
+        case XK_minus: case XK_underscore: return KEY_MINUS;
+        default: return KEY_COUNT;
+    }
+}
+
+FileData PlatformFileRead(const char *path)
+{
+    FileData result = {0};
+    if (!path) return result;
+
+    FILE *f = fopen(path, "rb");
+    if (!f) return result;
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    if (size > 0) {
+        result.data = malloc(size);
+        if (result.data) {
+            size_t read = fread(result.data, 1, size, f);
+            result.size = read;
+            if (read != (size_t)size) {
+                free(result.data);
+                result.data = NULL;
+                result.size = 0;
+            }
+        }
+    }
+
+    fclose(f);
+    return result;
+}
+
+void PlatformFileFree(FileData *fd)
+{
+    if (fd && fd->data) {
+        free(fd->data);
+        fd->data = NULL;
+        fd->size = 0;
+    }
+}
+
+int main(void)
+{
+    Display *display = XOpenDisplay(NULL);
+    if (!display) return 1;
+
+    int screen = DefaultScreen(display);
+    Window window = XCreateSimpleWindow(display, RootWindow(display, screen),
+                                        10, 10, 800, 600, 1,
+                                        BlackPixel(display, screen), WhitePixel(display, screen));
+
+    XSelectInput(display, window, ExposureMask | KeyPressMask | KeyReleaseMask | StructureNotifyMask
+                 | ButtonPressMask | ButtonReleaseMask | PointerMotionMask);
+    XMapWindow(display, window);
+
+    Atom wm_delete_window = XInternAtom(display, "WM_DELETE_WINDOW", False);
+    XSetWMProtocols(display, window, &wm_delete_window, 1);
+
+    // Tecla segura gera só KeyPress repetidos, sem o KeyRelease de cada repetição que cancelaria o frame
+    XkbSetDetectableAutoRepeat(display, True, NULL);
+
+    FrameExchange *exchange = &global_exchange;
+    if (pipe(exchange->wake_pipe) != 0) return 1;
+    fcntl(exchange->wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(exchange->wake_pipe[1], F_SETFL, O_NONBLOCK);
+    pthread_mutex_init(&exchange->lock, NULL);
+    pthread_cond_init(&exchange->input_changed, NULL);
+    exchange->render_index = 0;
+    exchange->ready_index = 1;
+    exchange->front_index = 2;
+    exchange->width = 800;
+    exchange->height = 600;
+    exchange->is_running = 1;
+    for (int i = 0; i < PRESENT_BUFFER_COUNT; ++i) exchange->buffers[i].shm_id = -1;
+
+    int shm_completion = -1;
+    if (XShmQueryExtension(display)) {
+        exchange->use_shm = 1;
+        shm_completion = XShmGetEventBase(display) + ShmCompletion;
+    }
+    b32 is_present_pending = 0;
+
+    pthread_t render_thread;
+    if (pthread_create(&render_thread, NULL, LinuxRenderThread, exchange) != 0) return 1;
+
+    while (global_running) {
+        b32 needs_present = 0;
+
+        ProfileZone events_zone = ProfileBeginPhase(PROFILE_PHASE_EVENTS);
+        pthread_mutex_lock(&exchange->lock);
+        Input *input = &exchange->input;
+        while (XPending(display) > 0) {
+            XEvent event;
+            XNextEvent(display, &event);
+
+            if (event.type == shm_completion)
+            {
+                is_present_pending = 0;
+            }
+            else if (event.type == ClientMessage)
+            {
+                if ((Atom)event.xclient.data.l[0] == wm_delete_window) global_running = 0;
+            }
+            else if (event.type == Expose)
+            {
+                needs_present = 1;
+            }
+            else if (event.type == ConfigureNotify)
+            {
+                XConfigureEvent ce = event.xconfigure;
+                if (ce.width != exchange->width || ce.height != exchange->height) {
+                    exchange->width = ce.width;
+                    exchange->height = ce.height;
+                    exchange->is_input_new = 1;
+                    CancelRender();
+                }
+            }
+            else if (event.type == KeyPress || event.type == KeyRelease)
+            {
+                KeySym keysym = XLookupKeysym(&event.xkey, 0);
+                b32 is_down = (event.type == KeyPress);
+                KeyCode kc = LinuxKeysymToKeyCode(keysym);
+                if (kc != KEY_COUNT) {
+                    // Tecla que mudou de estado muda a vista (ou as cores): o frame em andamento já está velho
+                    if (input->keys[kc].is_ended_down != is_down) {
+                        exchange->is_input_new = 1;
+                        CancelRender();
+                    }
+                    LinuxProcessKeyboard(&input->keys[kc], is_down);
+                }
+            }
+            else if (event.type == MotionNotify)
+            {
+                XMotionEvent *me = &event.xmotion;
+                input->mouse_x = me->x;
+                input->mouse_y = me->y;
+            } else if (event.type == ButtonPress || event.type == ButtonRelease)
+            {
+                XButtonEvent *be = &event.xbutton;
+                input->mouse_x = be->x;
+                input->mouse_y = be->y;
+                b32 pressed = (event.type == ButtonPress);
+                if (be->button == Button1) LinuxProcessKeyboard(&input->mouse_buttons[0], pressed);
+                else if (be->button == Button2) LinuxProcessKeyboard(&input->mouse_buttons[1], pressed);
+                else if (be->button == Button3) LinuxProcessKeyboard(&input->mouse_buttons[2], pressed);
+                else if (be->button == Button4 && pressed) input->mouse_wheel += 1.0f;
+                else if (be->button == Button5 && pressed) input->mouse_wheel -= 1.0f;
+            }
+        }
+
+        // O buffer da tela só é devolvido depois que o servidor terminou de lê-lo
+        if (exchange->is_input_new) pthread_cond_signal(&exchange->input_changed);
+        if (exchange->is_ready_new && !is_present_pending) {
+            i32 ready = exchange->ready_index;
+            exchange->ready_index = exchange->front_index;
+            exchange->front_index = ready;
+            exchange->is_ready_new = 0;
+            needs_present = 1;
+        }
+        b32 use_shm = exchange->use_shm;
+        pthread_mutex_unlock(&exchange->lock);
+        ProfileEnd(&events_zone);
+
+        if (needs_present) {
+            ProfileZone present_zone = ProfileBeginPhase(PROFILE_PHASE_PRESENT);
+            is_present_pending = LinuxPresentBuffer(display, window, &exchange->buffers[exchange->front_index], &use_shm);
+            ProfileEnd(&present_zone);
+            if (!use_shm) {
+                pthread_mutex_lock(&exchange->lock);
+                exchange->use_shm = 0;
+                pthread_mutex_unlock(&exchange->lock);
+            }
+        }
+
+        // Dorme até chegar evento do X ou frame novo da renderização
+        XFlush(display);
+        if (!global_running || XPending(display) > 0) continue;
+        struct pollfd fds[2] = {
+            {ConnectionNumber(display), POLLIN, 0},
+            {exchange->wake_pipe[0], POLLIN, 0},
+        };
+        poll(fds, 2, -1);
+        char drain[64];
+        while (read(exchange->wake_pipe[0], drain, sizeof(drain)) > 0) {}
+    }
+
+    pthread_mutex_lock(&exchange->lock);
+    exchange->is_running = 0;
+    pthread_cond_signal(&exchange->input_changed);
+    pthread_mutex_unlock(&exchange->lock);
+    CancelRender();
+    pthread_join(render_thread, NULL);
+
+    XSync(display, False);
+    for (int i = 0; i < PRESENT_BUFFER_COUNT; ++i) {
+        LinuxDestroyImage(display, &exchange->buffers[i]);
+        LinuxFreeBuffer(&exchange->buffers[i]);
+    }
+
+    XCloseDisplay(display);
+    return 0;
+}
@@ -0,0 +1,521 @@
+#define _POSIX_C_SOURCE 200809L // getaddrinfo, clock_gettime, open_memstream e MSG_NOSIGNAL
+
+#include "platform.h"
+#include "mandelbrot.h"
+#include "tile_server.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#define CACHE_TILES_PER_SIDE (TILE_SERVER_TILE_SIZE / TILE_CACHE_SIZE)
+#define CACHE_TILES_PER_REQUEST (CACHE_TILES_PER_SIDE * CACHE_TILES_PER_SIDE)
+
+typedef enum {
+    REQUEST_NONE,
+    REQUEST_TILE,
+    REQUEST_STATS
+} RequestKind;
+
+typedef struct {
+    int fd; // -1 se a vaga está livre
+    char inbox[TILE_SERVER_REQUEST_BYTES];
+    size_t inbox_used;
+
+    // Pedido já lido e ainda não respondido; cada conexão tem no máximo um por vez
+    RequestKind kind;
+    b32 is_closing;     // O cliente pediu Connection: close (ou falou HTTP/1.0)
+    f64 received_at;
+    TileCacheKey keys[CACHE_TILES_PER_REQUEST];
+    i32 *tiles[CACHE_TILES_PER_REQUEST];
+} ServerConnection;
+
+typedef struct {
+    i64 requests;
+    i64 served;
+    i64 cancelled;
+    i64 errors;
+    i64 batches;
+    i64 cache_hits;
+    i64 cache_misses;
+    f64 latencies[TILE_SERVER_LATENCY_SAMPLES]; // Anel com as mais recentes, em segundos
+    i64 latency_count;
+} ServerStats;
+
+typedef struct {
+    f64 p50;
+    f64 p90;
+    f64 p99;
+    f64 max;
+    i32 samples;
+} LatencySummary;
+
+static ServerConnection Connections[TILE_SERVER_MAX_CONNECTIONS];
+static ServerStats Stats;
+
+static f64 ServerGetSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1e9;
+}
+
+static int CompareF64(const void *a, const void *b)
+{
+    f64 x = *(const f64 *)a, y = *(const f64 *)b;
+    return (x > y) - (x < y);
+}
+
+static LatencySummary SummarizeLatencies(void)
+{
+    static f64 sorted[TILE_SERVER_LATENCY_SAMPLES];
+    LatencySummary summary = {0};
+    i32 count = Stats.latency_count < TILE_SERVER_LATENCY_SAMPLES ? (i32)Stats.latency_count
+                                                                   : TILE_SERVER_LATENCY_SAMPLES;
+    if (count == 0) return summary;
+
+    memcpy(sorted, Stats.latencies, sizeof(f64) * count);
+    qsort(sorted, count, sizeof(f64), CompareF64);
+    summary.p50 = sorted[(count - 1) * 50 / 100];
+    summary.p90 = sorted[(count - 1) * 90 / 100];
+    summary.p99 = sorted[(count - 1) * 99 / 100];
+    summary.max = sorted[count - 1];
+    summary.samples = count;
+    return summary;
+}
+
+static int FormatStats(char *out, size_t size)
+{
+    LatencySummary latency = SummarizeLatencies();
+    TileCacheStats cache = GetTileCacheStats();
+    return snprintf(out, size,
+                    "pedidos: %lld, servidos %lld, cancelados %lld, com erro %lld\n"
+                    "lotes: %lld, média de %.2f pedidos por lote\n"
+                    "cache: %lld acertos, %lld faltas; %d blocos de %d px (%.1f MB)\n"
+                    "latência (últimos %d): p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, máximo %.3f ms\n",
+                    (long long)Stats.requests, (long long)Stats.served, (long long)Stats.cancelled,
+                    (long long)Stats.errors, (long long)Stats.batches,
+                    Stats.batches ? (f64)Stats.served / Stats.batches : 0.0,
+                    (long long)Stats.cache_hits, (long long)Stats.cache_misses, cache.tiles, TILE_CACHE_SIZE,
+                    cache.bytes / (1024.0 * 1024.0), latency.samples, latency.p50 * 1000.0, latency.p90 * 1000.0,
+                    latency.p99 * 1000.0, latency.max * 1000.0);
+}
+
+// ---------------------------------------------------------------------------
+// Conexões
+// ---------------------------------------------------------------------------
+
+static int ListenOn(const char *address)
+{
+    const char *colon = strrchr(address, ':');
+    char host[256] = "127.0.0.1";
+    const char *port = address;
+    if (colon) {
+        size_t host_length = (size_t)(colon - address);
+        if (host_length >= sizeof(host)) return -1;
+        if (host_length) {
+            memcpy(host, address, host_length);
+            host[host_length] = 0;
+        }
+        port = colon + 1;
+    }
+
+    struct addrinfo hints, *results;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(host, port, &hints, &results) != 0) return -1;
+
+    int fd = -1;
+    for (struct addrinfo *info = results; info && fd < 0; info = info->ai_next) {
+        fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, info->ai_addr, info->ai_addrlen) != 0 || listen(fd, SOMAXCONN) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(results);
+    return fd;
+}
+
+static void CloseConnection(ServerConnection *connection)
+{
+    close(connection->fd);
+    connection->fd = -1;
+    connection->inbox_used = 0;
+    connection->kind = REQUEST_NONE;
+}
+
+static b32 SendAll(int fd, const void *data, size_t size)
+{
+    const u8 *bytes = data;
+    while (size > 0) {
+        ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return 0;
+        bytes += sent;
+        size -= (size_t)sent;
+    }
+    return 1;
+}
+
+// Um cliente que não lê a resposta (ou que sumiu no meio dela) perde a conexão
+static void SendResponse(ServerConnection *connection, const char *status, const char *type,
+                         const void *body, size_t size)
+{
+    char header[512];
+    int header_size = snprintf(header, sizeof(header),
+                               "HTTP/1.1 %s\r\n"
+                               "Content-Type: %s\r\n"
+                               "Content-Length: %zu\r\n"
+                               "Access-Control-Allow-Origin: *\r\n"
+                               "Connection: %s\r\n"
+                               "\r\n",
+                               status, type, size, connection->is_closing ? "close" : "keep-alive");
+    b32 is_sent = SendAll(connection->fd, header, (size_t)header_size) && SendAll(connection->fd, body, size);
+    connection->kind = REQUEST_NONE;
+    if (!is_sent || connection->is_closing) CloseConnection(connection);
+}
+
+static void SendError(ServerConnection *connection, const char *status, const char *message)
+{
+    ++Stats.errors;
+    SendResponse(connection, status, "text/plain; charset=utf-8", message, strlen(message));
+}
+
+static b32 HasToken(const char *text, size_t length, const char *token)
+{
+    size_t token_length = strlen(token);
+    for (size_t i = 0; i + token_length <= length; ++i) {
+        size_t j = 0;
+        while (j < token_length && (text[i + j] | 0x20) == (token[j] | 0x20)) ++j;
+        if (j == token_length) return 1;
+    }
+    return 0;
+}
+
+/*
+O bloco (x, y) do nível z tem pixels de TILE_SERVER_WORLD_SIZE / (2^z * lado) e,
+com o mundo centrado na origem, começa no pixel global x * lado - 2^z * lado / 2:
+um múltiplo de TILE_CACHE_SIZE, então cabe certinho na grade absoluta do cache.
+*/
+static const char *PrepareTileRequest(ServerConnection *connection, i32 z, i64 x, i64 y, i32 max_iterations)
+{
+    if (z < 0 || z > TILE_SERVER_MAX_LEVEL) return "nível fora do intervalo";
+    i64 tiles_per_side = (i64)1 << z;
+    if (x < 0 || y < 0 || x >= tiles_per_side || y >= tiles_per_side) return "bloco fora do nível";
+    if (max_iterations < 1 || max_iterations > ADAPTIVE_MAX_ITERATIONS) return "limite de iterações inválido";
+
+    f64 zoom = TILE_SERVER_WORLD_SIZE / ((f64)tiles_per_side * TILE_SERVER_TILE_SIZE);
+    f64 center_x = ((f64)x + 0.5) * TILE_SERVER_TILE_SIZE * zoom - TILE_SERVER_WORLD_SIZE / 2;
+    f64 center_y = ((f64)y + 0.5) * TILE_SERVER_TILE_SIZE * zoom - TILE_SERVER_WORLD_SIZE / 2;
+    RenderPrecision precision = ChooseRenderPrecision(center_x, center_y, zoom, TILE_SERVER_TILE_SIZE,
+                                                      TILE_SERVER_TILE_SIZE);
+    if (precision != PRECISION_F32 && precision != PRECISION_F64) return "nível além da precisão do f64";
+
+    i64 first_x = x * CACHE_TILES_PER_SIDE - tiles_per_side * CACHE_TILES_PER_SIDE / 2;
+    i64 first_y = y * CACHE_TILES_PER_SIDE - tiles_per_side * CACHE_TILES_PER_SIDE / 2;
+    for (i32 i = 0; i < CACHE_TILES_PER_REQUEST; ++i) {
+        TileCacheKey *key = &connection->keys[i];
+        key->zoom = zoom;
+        key->tile_x = first_x + i % CACHE_TILES_PER_SIDE;
+        key->tile_y = first_y + i / CACHE_TILES_PER_SIDE;
+        key->max_iterations = max_iterations;
+        key->precision = precision;
+    }
+    return NULL;
+}
+
+// Tira da caixa de entrada o próximo pedido completo, se houver; retorna 0 se a conexão foi fechada
+static b32 ParseRequest(ServerConnection *connection, i32 default_iterations)
+{
+    if (connection->kind != REQUEST_NONE || connection->fd < 0) return 1;
+
+    char *head = connection->inbox;
+    char *end = NULL;
+    for (size_t i = 0; i + 4 <= connection->inbox_used; ++i) {
+        if (memcmp(head + i, "\r\n\r\n", 4) == 0) {
+            end = head + i;
+            break;
+        }
+    }
+    if (!end) {
+        if (connection->inbox_used == sizeof(connection->inbox)) {
+            connection->is_closing = 1;
+            SendError(connection, "431 Request Header Fields Too Large", "cabeçalho grande demais\n");
+            return connection->fd >= 0;
+        }
+        return 1;
+    }
+
+    size_t head_length = (size_t)(end - head) + 4;
+    char line[256];
+    size_t line_length = strcspn(head, "\r");
+    if (line_length >= sizeof(line)) line_length = sizeof(line) - 1;
+    memcpy(line, head, line_length);
+    line[line_length] = 0;
+
+    connection->is_closing = HasToken(head, head_length, "connection: close") || strstr(line, "HTTP/1.0") != NULL;
+    connection->received_at = ServerGetSeconds();
+    memmove(head, head + head_length, connection->inbox_used - head_length);
+    connection->inbox_used -= head_length;
+    ++Stats.requests;
+
+    char path[200];
+    if (sscanf(line, "GET %199s HTTP/", path) != 1) {
+        connection->is_closing = 1;
+        SendError(connection, "400 Bad Request", "só GET é aceito\n");
+        return connection->fd >= 0;
+    }
+
+    if (strcmp(path, "/stats") == 0) {
+        connection->kind = REQUEST_STATS;
+        return 1;
+    }
+
+    i32 z = 0, iterations = default_iterations, consumed = 0;
+    long long x = 0, y = 0;
+    if (sscanf(path, "/%d/%lld/%lld.png%n", &z, &x, &y, &consumed) != 3 || consumed <= 0 ||
+        (path[consumed] && sscanf(path + consumed, "?i=%d", &iterations) != 1)) {
+        SendError(connection, "404 Not Found", "use /<z>/<x>/<y>.png[?i=<iterações>] ou /stats\n");
+        return connection->fd >= 0;
+    }
+    const char *error = PrepareTileRequest(connection, z, x, y, iterations);
+    if (error) {
+        char message[128];
+        snprintf(message, sizeof(message), "%s\n", error);
+        SendError(connection, "404 Not Found", message);
+        return connection->fd >= 0;
+    }
+    connection->kind = REQUEST_TILE;
+    return 1;
+}
+
+// Lê o que chegou; um 0 do recv é o cliente fechando, e um pedido pendente dele vira cancelado
+static void ReadConnection(ServerConnection *connection, i32 default_iterations)
+{
+    size_t space = sizeof(connection->inbox) - connection->inbox_used;
+    if (space == 0) return;
+    ssize_t received = recv(connection->fd, connection->inbox + connection->inbox_used, space, 0);
+    if (received < 0 && errno == EINTR) return;
+    if (received <= 0) {
+        if (connection->kind == REQUEST_TILE) ++Stats.cancelled;
+        CloseConnection(connection);
+        return;
+    }
+    connection->inbox_used += (size_t)received;
+    ParseRequest(connection, default_iterations);
+}
+
+// ---------------------------------------------------------------------------
+// Lotes
+// ---------------------------------------------------------------------------
+
+static TileCacheKey BatchKeys[TILE_SERVER_MAX_CONNECTIONS * CACHE_TILES_PER_REQUEST];
+static i32 *BatchTiles[TILE_SERVER_MAX_CONNECTIONS * CACHE_TILES_PER_REQUEST];
+static b32 IsInBatch[TILE_SERVER_MAX_CONNECTIONS];
+
+/*
+Um lote: reserva no cache os blocos que faltam a todos os pedidos pendentes (dois
+pedidos do mesmo bloco dividem a entrada), calcula todos numa passada só e responde
+cada pedido montando, colorindo e codificando o seu bloco. Se o cache encher, os
+pedidos que sobraram ficam para o próximo lote.
+*/
+static void ServeBatch(const TileServerOptions *options, OffscreenBuffer *image, i32 *iterations)
+{
+    TileCacheBeginFrame();
+    i32 missing_count = 0;
+    b32 is_cache_full = 0;
+    for (i32 c = 0; c < TILE_SERVER_MAX_CONNECTIONS; ++c) {
+        ServerConnection *connection = &Connections[c];
+        IsInBatch[c] = 0;
+        if (connection->fd < 0 || connection->kind != REQUEST_TILE || is_cache_full) continue;
+
+        for (i32 i = 0; i < CACHE_TILES_PER_REQUEST && !is_cache_full; ++i) {
+            connection->tiles[i] = TileCacheFind(&connection->keys[i]);
+            if (connection->tiles[i]) continue;
+            connection->tiles[i] = TileCacheInsert(&connection->keys[i]);
+            if (!connection->tiles[i]) {
+                is_cache_full = 1;
+                break;
+            }
+            BatchKeys[missing_count] = connection->keys[i];
+            BatchTiles[missing_count++] = connection->tiles[i];
+        }
+        IsInBatch[c] = !is_cache_full;
+    }
+
+    TileCacheStats cache = GetTileCacheStats();
+    Stats.cache_hits += cache.hits;
+    Stats.cache_misses += cache.misses;
+    RenderCacheTiles(BatchKeys, BatchTiles, missing_count);
+    ++Stats.batches;
+
+    for (i32 c = 0; c < TILE_SERVER_MAX_CONNECTIONS; ++c) {
+        if (!IsInBatch[c]) continue;
+        ServerConnection *connection = &Connections[c];
+
+        for (i32 i = 0; i < CACHE_TILES_PER_REQUEST; ++i) {
+            i32 x0 = (i % CACHE_TILES_PER_SIDE) * TILE_CACHE_SIZE;
+            i32 y0 = (i / CACHE_TILES_PER_SIDE) * TILE_CACHE_SIZE;
+            for (i32 y = 0; y < TILE_CACHE_SIZE; ++y) {
+                memcpy(iterations + (size_t)(y0 + y) * TILE_SERVER_TILE_SIZE + x0,
+                       connection->tiles[i] + (size_t)y * TILE_CACHE_SIZE, sizeof(i32) * TILE_CACHE_SIZE);
+            }
+        }
+        ColorizeFrame(image, iterations, TILE_SERVER_TILE_SIZE, connection->keys[0].max_iterations);
+
+        char *png = NULL;
+        size_t png_size = 0;
+        FILE *stream = open_memstream(&png, &png_size);
+        b32 is_encoded = stream && options->encode(stream, image);
+        if (stream) fclose(stream);
+        if (is_encoded) {
+            SendResponse(connection, "200 OK", "image/png", png, png_size);
+            ++Stats.served;
+            Stats.latencies[Stats.latency_count++ % TILE_SERVER_LATENCY_SAMPLES] =
+                ServerGetSeconds() - connection->received_at;
+        } else {
+            SendError(connection, "500 Internal Server Error", "falha ao codificar o bloco\n");
+        }
+        free(png);
+
+        // O cliente pode ter mandado o próximo pedido junto com este
+        ParseRequest(connection, options->max_iterations);
+    }
+}
+
+int TileServerRun(const TileServerOptions *options)
+{
+    int listen_fd = ListenOn(options->address);
+    if (listen_fd < 0) {
+        fprintf(stderr, "Não consegui escutar em %s\n", options->address);
+        return 1;
+    }
+
+    OffscreenBuffer image = {0};
+    image.width = TILE_SERVER_TILE_SIZE;
+    image.height = TILE_SERVER_TILE_SIZE;
+    image.bytes_per_pixel = 4;
+    image.pitch = image.width * image.bytes_per_pixel;
+    image.memory = malloc((size_t)image.pitch * image.height);
+    i32 *iterations = malloc(sizeof(i32) * TILE_SERVER_TILE_SIZE * TILE_SERVER_TILE_SIZE);
+    if (!image.memory || !iterations) {
+        fprintf(stderr, "Sem memória para o bloco\n");
+        free(image.memory);
+        free(iterations);
+        close(listen_fd);
+        return 1;
+    }
+
+    for (i32 c = 0; c < TILE_SERVER_MAX_CONNECTIONS; ++c) Connections[c].fd = -1;
+    fprintf(stderr, "servidor de blocos em %s: GET /<z>/<x>/<y>.png ou /stats\n", options->address);
+
+    f64 last_report = ServerGetSeconds();
+    i64 reported_requests = 0;
+    for (;;) {
+        struct pollfd fds[1 + TILE_SERVER_MAX_CONNECTIONS];
+        i32 owners[1 + TILE_SERVER_MAX_CONNECTIONS];
+        i32 fd_count = 0;
+        fds[fd_count].fd = listen_fd;
+        fds[fd_count].events = POLLIN;
+        owners[fd_count++] = -1;
+
+        // O pedido pendente mais antigo define quando o lote sai
+        f64 oldest = 0.0;
+        for (i32 c = 0; c < TILE_SERVER_MAX_CONNECTIONS; ++c) {
+            ServerConnection *connection = &Connections[c];
+            if (connection->fd < 0) continue;
+            if (connection->kind == REQUEST_TILE && (oldest == 0.0 || connection->received_at < oldest)) {
+                oldest = connection->received_at;
+            }
+            fds[fd_count].fd = connection->fd;
+            fds[fd_count].events = POLLIN;
+            owners[fd_count++] = c;
+        }
+
+        f64 now = ServerGetSeconds();
+        int timeout_ms = 1000;
+        if (oldest > 0.0) {
+            f64 remaining = oldest + TILE_SERVER_BATCH_SECONDS - now;
+            timeout_ms = remaining > 0.0 ? (int)(remaining * 1000.0) + 1 : 0;
+        }
+
+        int ready = poll(fds, (nfds_t)fd_count, timeout_ms);
+        if (ready < 0 && errno != EINTR) break;
+
+        for (i32 f = 1; ready > 0 && f < fd_count; ++f) {
+            if (fds[f].revents) ReadConnection(&Connections[owners[f]], options->max_iterations);
+        }
+
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            int fd = accept(listen_fd, NULL, NULL);
+            i32 slot = 0;
+            while (slot < TILE_SERVER_MAX_CONNECTIONS && Connections[slot].fd >= 0) ++slot;
+            if (fd >= 0 && slot < TILE_SERVER_MAX_CONNECTIONS) {
+                int one = 1;
+                struct timeval send_timeout = {TILE_SERVER_SEND_TIMEOUT_SECONDS, 0};
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+                memset(&Connections[slot], 0, sizeof(Connections[slot]));
+                Connections[slot].fd = fd;
+            } else if (fd >= 0) {
+                close(fd);
+            }
+        }
+
+        // As estatísticas não esperam pelo lote
+        for (i32 c = 0; c < TILE_SERVER_MAX_CONNECTIONS; ++c) {
+            ServerConnection *connection = &Connections[c];
+            if (connection->fd < 0 || connection->kind != REQUEST_STATS) continue;
+            char text[1024];
+            int size = FormatStats(text, sizeof(text));
+            SendResponse(connection, "200 OK", "text/plain; charset=utf-8", text, (size_t)size);
+            ParseRequest(connection, options->max_iterations);
+        }
+
+        now = ServerGetSeconds();
+        if (oldest > 0.0 && now - oldest >= TILE_SERVER_BATCH_SECONDS) ServeBatch(options, &image, iterations);
+
+        if (now - last_report >= TILE_SERVER_REPORT_SECONDS) {
+            if (Stats.requests != reported_requests) {
+                char text[1024];
+                FormatStats(text, sizeof(text));
+                fprintf(stderr, "%s", text);
+                reported_requests = Stats.requests;
+            }
+            last_report = now;
+        }
+    }
+
+    free(image.memory);
+    free(iterations);
+    close(listen_fd);
+    return 1;
+}
+
+#else
+
+int TileServerRun(const TileServerOptions *options)
+{
+    fprintf(stderr, "O servidor de blocos (%s) só existe nos sistemas POSIX\n", options->address);
+    return 1;
+}
+
+#endif
@@ -0,0 +1,196 @@
+#include "platform.h"
+#include "mandelbrot.h"
+#include "kernels.h"
+#include "profiler.h"
+
+#include <stdlib.h>
+#include <omp.h>
+
+/*
+Etapa de coloração, separada da iteração. Os renderizadores guardam as contagens
+num buffer persistente e só depois as convertem em cores por uma tabela com uma
+cor por contagem possível (0 .. max_iterations). Ciclo da paleta e equalização por
+histograma só mudam a tabela, então trocar as cores de um frame pronto custa uma
+passada sobre o buffer de iterações, sem iterar nenhum pixel.
+
+A paleta é gerada para qualquer comprimento e se repete a cada PaletteLength
+contagens, então funciona com qualquer limite de iterações.
+*/
+
+// Os pontos do conjunto são pretos
+#define SET_COLOR 0xFF000000
+
+// Memória das cópias do histograma, uma por thread; com limites muito altos usam-se menos threads
+#define HISTOGRAM_THREAD_BUDGET_BYTES ((size_t)64 << 20)
+
+static u32 *ColorPalette;
+static i32 PaletteLength = PALETTE_DEFAULT_LENGTH;
+static b32 IsPaletteInitialized = 0;
+
+static u32 *ColorLookup;
+static i32 ColorLookupCapacity;
+static i32 PaletteCycle;
+static b32 IsHistogramEnabled = 0;
+
+void InitColorPalette(void)
+{
+    if (IsPaletteInitialized) return;
+
+    free(ColorPalette);
+    ColorPalette = malloc(sizeof(u32) * (size_t)PaletteLength);
+    if (!ColorPalette) return;
+
+    for (int i = 0; i < PaletteLength; ++i)
+    {
+        // Truque matemático para criar um gradiente suave
+        float t = (float)i / (float)PaletteLength;
+
+        // Usando ondas senoidais para gerar RGB baseados na iteração
+        u8 r = (u8)(9 * (1 - t) * t * t * 255);
+        u8 g = (u8)(15 * (1 - t) * (1 - t) * t * 255);
+        u8 b = (u8)(8.5 * (1 - t) * (1 - t) * (1 - t) * 255);
+        ColorPalette[i] = ((u32)0xFF << 24) | ((u32)r << 16) | ((u32)g << 8) | (u32)b;
+    }
+
+    IsPaletteInitialized = 1;
+}
+
+void SetPaletteLength(i32 length)
+{
+    if (length < 2) length = 2;
+    if (length == PaletteLength) return;
+    PaletteLength = length;
+    IsPaletteInitialized = 0;
+    SetPaletteCycle(PaletteCycle);
+}
+
+i32 GetPaletteLength(void)
+{
+    return PaletteLength;
+}
+
+void SetPaletteCycle(i32 offset)
+{
+    offset %= PaletteLength;
+    PaletteCycle = offset < 0 ? offset + PaletteLength : offset;
+}
+
+i32 GetPaletteCycle(void)
+{
+    return PaletteCycle;
+}
+
+void SetHistogramEqualization(b32 enabled)
+{
+    IsHistogramEnabled = enabled;
+}
+
+b32 IsHistogramEqualizationEnabled(void)
+{
+    return IsHistogramEnabled;
+}
+
+/*
+Equalização: cada contagem recebe a posição da paleta proporcional à fração dos
+pixels que escaparam até ela. As faixas ocupadas por muitos pixels ficam com mais
+cores e as quase vazias com poucas, o que mantém o contraste em qualquer zoom.
+*/
+static b32 BuildHistogramLookup(const i32 *iterations, i32 stride, i32 width, i32 height, i32 max_iterations)
+{
+    // Cada thread conta num histograma próprio no heap (uma cópia na pilha estoura com limites
+    // de milhões) e as cópias são somadas por faixa de contagens depois
+    size_t bins = (size_t)max_iterations + 1;
+    size_t thread_bytes = bins * sizeof(u32);
+    int threads = omp_get_max_threads();
+    if ((size_t)threads * thread_bytes > HISTOGRAM_THREAD_BUDGET_BYTES) {
+        threads = (int)(HISTOGRAM_THREAD_BUDGET_BYTES / thread_bytes);
+        if (threads < 1) threads = 1;
+    }
+
+    i64 *histogram = malloc(sizeof(i64) * bins);
+    u32 *partial = calloc((size_t)threads * bins, sizeof(u32));
+    if (!histogram || !partial) {
+        free(histogram);
+        free(partial);
+        return 0;
+    }
+
+    #pragma omp parallel num_threads(threads)
+    {
+        u32 *counts = partial + (size_t)omp_get_thread_num() * bins;
+        #pragma omp for schedule(static)
+        for (int y = 0; y < height; ++y) {
+            const i32 *row = iterations + (size_t)y * stride;
+            for (int x = 0; x < width; ++x) {
+                i32 iteration = row[x];
+                ++counts[iteration < max_iterations ? iteration : max_iterations];
+            }
+        }
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < bins; ++i) {
+        i64 sum = 0;
+        for (int t = 0; t < threads; ++t) sum += partial[(size_t)t * bins + i];
+        histogram[i] = sum;
+    }
+    free(partial);
+
+    i64 escaped = 0;
+    for (int i = 0; i < max_iterations; ++i) escaped += histogram[i];
+    if (escaped == 0) {
+        free(histogram);
+        return 0;
+    }
+
+    i64 cumulative = 0;
+    for (int i = 0; i < max_iterations; ++i) {
+        cumulative += histogram[i];
+        i32 index = (i32)((f64)cumulative / (f64)escaped * (PaletteLength - 1));
+        ColorLookup[i] = ColorPalette[(index + PaletteCycle) % PaletteLength];
+    }
+
+    free(histogram);
+    return 1;
+}
+
+void PrepareColorLookup(const i32 *iterations, i32 stride, i32 width, i32 height, i32 max_iterations)
+{
+    if (!IsPaletteInitialized) InitColorPalette();
+    if (!IsPaletteInitialized) return;
+
+    if (ColorLookupCapacity < max_iterations + 1) {
+        free(ColorLookup);
+        ColorLookup = malloc(sizeof(u32) * ((size_t)max_iterations + 1));
+        ColorLookupCapacity = ColorLookup ? max_iterations + 1 : 0;
+        if (!ColorLookup) return;
+    }
+
+    if (!IsHistogramEnabled || !iterations ||
+        !BuildHistogramLookup(iterations, stride, width, height, max_iterations)) {
+        for (int i = 0; i < max_iterations; ++i) ColorLookup[i] = ColorPalette[(i + PaletteCycle) % PaletteLength];
+    }
+    ColorLookup[max_iterations] = SET_COLOR;
+}
+
+void ColorizeRow(u32 *row_pixel, const i32 *iterations, i32 count, i32 max_iterations)
+{
+    if (max_iterations >= ColorLookupCapacity) return;
+    GetIterationKernel()->colorize(row_pixel, iterations, count, ColorLookup, max_iterations);
+}
+
+void ColorizeFrame(OffscreenBuffer *buffer, const i32 *iterations, i32 stride, i32 max_iterations)
+{
+    int width = buffer->width;
+    int height = buffer->height;
+    u32 *pixels = (u32 *)buffer->memory;
+
+    ProfileZone zone = ProfileBegin("colorize");
+    PrepareColorLookup(iterations, stride, width, height, max_iterations);
+
+    #pragma omp parallel for schedule(static)
+    for (int y = 0; y < height; ++y) {
+        ColorizeRow(pixels + (size_t)y * (buffer->pitch / 4), iterations + (size_t)y * stride, width, max_iterations);
+    }
+    ProfileEnd(&zone);
+}
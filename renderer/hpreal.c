@@ -0,0 +1,232 @@
+#include "hpreal.h"
+
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define HP_LIMB_SCALE 4294967296.0
+
+void HPZero(HPReal *r)
+{
+    memset(r, 0, sizeof(*r));
+}
+
+// A conversão é exata: multiplicar por 2^32 e tirar a parte inteira não perde bits
+void HPFromF64(HPReal *r, f64 value)
+{
+    HPZero(r);
+    r->negative = (value < 0.0);
+
+    f64 v = fabs(value);
+    f64 digit = floor(v);
+    r->limbs[HP_MAX_LIMBS - 1] = (u32)digit;
+    v -= digit;
+
+    for (int k = HP_MAX_LIMBS - 2; k >= 0 && v != 0.0; --k) {
+        v *= HP_LIMB_SCALE;
+        digit = floor(v);
+        r->limbs[k] = (u32)digit;
+        v -= digit;
+    }
+}
+
+f64 HPToF64(const HPReal *a)
+{
+    f64 result = 0.0;
+    f64 scale = 1.0;
+    int significant = 0;
+
+    // Três limbs a partir do primeiro não nulo já cobrem os 53 bits da mantissa
+    for (int k = HP_MAX_LIMBS - 1; k >= 0 && significant < 3; --k) {
+        if (a->limbs[k] || significant) {
+            result += (f64)a->limbs[k] * scale;
+            ++significant;
+        }
+        scale *= 1.0 / HP_LIMB_SCALE;
+    }
+
+    return a->negative ? -result : result;
+}
+
+static b32 HPIsZero(const HPReal *a, int base)
+{
+    for (int k = base; k < HP_MAX_LIMBS; ++k) {
+        if (a->limbs[k]) return 0;
+    }
+    return 1;
+}
+
+static int HPCompareMagnitude(const HPReal *a, const HPReal *b, int base)
+{
+    for (int k = HP_MAX_LIMBS - 1; k >= base; --k) {
+        if (a->limbs[k] != b->limbs[k]) return (a->limbs[k] > b->limbs[k]) ? 1 : -1;
+    }
+    return 0;
+}
+
+static void HPAddMagnitude(HPReal *r, const HPReal *a, const HPReal *b, int base)
+{
+    u64 carry = 0;
+    for (int k = base; k < HP_MAX_LIMBS; ++k) {
+        u64 sum = (u64)a->limbs[k] + b->limbs[k] + carry;
+        r->limbs[k] = (u32)sum;
+        carry = sum >> 32;
+    }
+}
+
+// Pressupõe |a| >= |b|
+static void HPSubMagnitude(HPReal *r, const HPReal *a, const HPReal *b, int base)
+{
+    i64 borrow = 0;
+    for (int k = base; k < HP_MAX_LIMBS; ++k) {
+        i64 diff = (i64)a->limbs[k] - b->limbs[k] - borrow;
+        borrow = (diff < 0);
+        r->limbs[k] = (u32)(diff + (borrow << 32));
+    }
+}
+
+static void HPAddSigned(HPReal *r, const HPReal *a, const HPReal *b, b32 b_negative, i32 limbs)
+{
+    int base = HP_MAX_LIMBS - limbs;
+    HPReal result;
+    HPZero(&result);
+
+    if (a->negative == b_negative) {
+        HPAddMagnitude(&result, a, b, base);
+        result.negative = a->negative;
+    } else if (HPCompareMagnitude(a, b, base) >= 0) {
+        HPSubMagnitude(&result, a, b, base);
+        result.negative = a->negative;
+    } else {
+        HPSubMagnitude(&result, b, a, base);
+        result.negative = b_negative;
+    }
+
+    if (HPIsZero(&result, base)) result.negative = 0;
+    *r = result;
+}
+
+void HPAdd(HPReal *r, const HPReal *a, const HPReal *b, i32 limbs)
+{
+    HPAddSigned(r, a, b, b->negative, limbs);
+}
+
+void HPSub(HPReal *r, const HPReal *a, const HPReal *b, i32 limbs)
+{
+    HPAddSigned(r, a, b, !b->negative, limbs);
+}
+
+/*
+Multiplicação escolar dos limbs ativos. Com n limbs e a parte inteira no topo,
+o produto inteiro tem 2n limbs e o resultado de ponto fixo são os limbs
+[n - 1, 2n - 1) dele; o limb mais alto só seria usado se a parte inteira estourasse.
+*/
+void HPMul(HPReal *r, const HPReal *a, const HPReal *b, i32 limbs)
+{
+    int base = HP_MAX_LIMBS - limbs;
+    u32 product[2 * HP_MAX_LIMBS] = {0};
+
+    for (int i = 0; i < limbs; ++i) {
+        u64 a_limb = a->limbs[base + i];
+        if (a_limb == 0) continue;
+
+        u64 carry = 0;
+        for (int j = 0; j < limbs; ++j) {
+            u64 t = a_limb * b->limbs[base + j] + product[i + j] + carry;
+            product[i + j] = (u32)t;
+            carry = t >> 32;
+        }
+        product[i + limbs] = (u32)carry;
+    }
+
+    HPReal result;
+    HPZero(&result);
+    for (int k = 0; k < limbs; ++k) result.limbs[base + k] = product[k + limbs - 1];
+    result.negative = (a->negative != b->negative);
+    if (HPIsZero(&result, base)) result.negative = 0;
+    *r = result;
+}
+
+void HPAddF64(HPReal *r, f64 value)
+{
+    HPReal offset;
+    HPFromF64(&offset, value);
+    HPAdd(r, r, &offset, HP_MAX_LIMBS);
+}
+
+void HPTruncate(HPReal *r, i32 limbs)
+{
+    memset(r->limbs, 0, sizeof(u32) * (HP_MAX_LIMBS - limbs));
+}
+
+static void HPDivideMagnitudeSmall(HPReal *r, u32 divisor)
+{
+    u64 remainder = 0;
+    for (int k = HP_MAX_LIMBS - 1; k >= 0; --k) {
+        u64 current = (remainder << 32) | r->limbs[k];
+        r->limbs[k] = (u32)(current / divisor);
+        remainder = current % divisor;
+    }
+}
+
+/*
+Lê um decimal como "-0.7436438870371587522" sem passar por f64, para que
+coordenadas de zooms profundos não percam dígitos. Notação científica cai
+para strtod, já que quem a usa não precisa de mais que f64.
+*/
+b32 HPFromString(HPReal *r, const char *text)
+{
+    HPZero(r);
+    if (!text || !*text) return 0;
+
+    if (strchr(text, 'e') || strchr(text, 'E')) {
+        char *end;
+        f64 value = strtod(text, &end);
+        if (*end) return 0;
+        HPFromF64(r, value);
+        return 1;
+    }
+
+    const char *p = text;
+    b32 negative = 0;
+    if (*p == '-' || *p == '+') negative = (*p++ == '-');
+
+    u64 integer = 0;
+    const char *digits = p;
+    while (*p >= '0' && *p <= '9') {
+        integer = integer * 10 + (u64)(*p++ - '0');
+        if (integer > 0xFFFFFFFFu) return 0;
+    }
+
+    const char *fraction = NULL;
+    const char *fraction_end = NULL;
+    if (*p == '.') {
+        fraction = ++p;
+        while (*p >= '0' && *p <= '9') ++p;
+        fraction_end = p;
+    }
+    if (*p || p == digits) return 0;
+
+    // Horner de trás para frente: f = (d + f) / 10
+    if (fraction) {
+        for (const char *d = fraction_end; d > fraction; ) {
+            --d;
+            r->limbs[HP_MAX_LIMBS - 1] = (u32)(*d - '0');
+            HPDivideMagnitudeSmall(r, 10);
+        }
+    }
+
+    r->limbs[HP_MAX_LIMBS - 1] = (u32)integer;
+    r->negative = negative;
+    if (HPIsZero(r, 0)) r->negative = 0;
+    return 1;
+}
+
+i32 HPLimbsForZoom(f64 zoom)
+{
+    f64 bits = -log2(zoom) + 64.0;
+    i32 limbs = 1 + (i32)ceil(bits / 32.0);
+    if (limbs < 2) limbs = 2;
+    if (limbs > HP_MAX_LIMBS) limbs = HP_MAX_LIMBS;
+    return limbs;
+}
@@ -0,0 +1,1084 @@
+#include "platform.h"
+#include "kernels.h"
+
+#include <immintrin.h> // AVX2
+
+/*
+Kernel AVX2: 8 pixels f32 ou 4 f64 por registrador. A unidade é compilada com
+-mavx2 -mfma, mas as contas continuam em mul e add separados para bater bit a
+bit com os outros kernels.
+*/
+
+// Itera 8 pixels f32 até todos escaparem ou o limite chegar; devolve as contagens por lane
+static inline __m256i AVX2LanesF32(__m256 v_c_re, __m256 v_c_im, i32 max_iterations, i64 *saved)
+{
+    const __m256 v_threshold = _mm256_set1_ps(4.0f);
+    const __m256 v_two = _mm256_set1_ps(2.0f);
+    const __m256 v_quarter = _mm256_set1_ps(0.25f);
+    const __m256 v_one = _mm256_set1_ps(1.0f);
+    const __m256 v_sixteenth = _mm256_set1_ps(1.0f / 16.0f);
+    const __m256 v_epsilon = _mm256_set1_ps(PERIODICITY_EPSILON_F32);
+    const __m256 v_abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+
+    // Cardioide: q (q + x - 1/4) <= y^2 / 4, com q = (x - 1/4)^2 + y^2; bulbo: (x + 1)^2 + y^2 <= 1/16
+    __m256 v_c_im2 = _mm256_mul_ps(v_c_im, v_c_im);
+    __m256 v_xq = _mm256_sub_ps(v_c_re, v_quarter);
+    __m256 v_q = _mm256_add_ps(_mm256_mul_ps(v_xq, v_xq), v_c_im2);
+    __m256 v_in_cardioid = _mm256_cmp_ps(_mm256_mul_ps(v_q, _mm256_add_ps(v_q, v_xq)),
+                                         _mm256_mul_ps(v_quarter, v_c_im2), _CMP_LE_OQ);
+    __m256 v_x1 = _mm256_add_ps(v_c_re, v_one);
+    __m256 v_in_bulb = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(v_x1, v_x1), v_c_im2), v_sixteenth, _CMP_LE_OQ);
+    __m256 v_done = _mm256_or_ps(v_in_cardioid, v_in_bulb);
+
+    __m256 v_z_re = _mm256_setzero_ps();
+    __m256 v_z_im = _mm256_setzero_ps();
+    __m256 v_old_re = v_z_re;
+    __m256 v_old_im = v_z_im;
+    __m256i v_iterations = _mm256_setzero_si256();
+    int next_save = 1;
+
+    // Loop de iteração do Mandelbrot
+    for (int i = 0; i < max_iterations; ++i)
+    {
+        /*
+        A fórmula do Mandelbrot é:
+            Z_{n+1} = Z_n^2 + C
+        Expandindo Z = x + yi:
+            Z^2 = (x + yi)(x + yi) = x^2 - y^2 + 2xyi
+        A verificação de escape (para otimização) é:
+            |Z| <= 2, isto é, raiz(x^2 + y^2) <= 2,
+        ou melhor ainda:
+            x^2 + y^2 <= 4
+        */
+
+        __m256 v_z_re2 = _mm256_mul_ps(v_z_re, v_z_re); // Z_re^2
+        __m256 v_z_im2 = _mm256_mul_ps(v_z_im, v_z_im); // Z_im^2
+        __m256 v_mag2 = _mm256_add_ps(v_z_re2, v_z_im2); // mag^2 = re^2 + im^2
+
+        // Cria uma máscara; lanes já resolvidas pelas saídas antecipadas ficam de fora
+        __m256 v_mask_active = _mm256_andnot_ps(v_done, _mm256_cmp_ps(v_mag2, v_threshold, _CMP_LE_OQ));
+
+        // Se a máscara for toda zero, todos os pixels escaparam
+        int mask_bits = _mm256_movemask_ps(v_mask_active);
+        if (mask_bits == 0) break;
+
+        // A máscara 'v_mask_active' tem -1 para pixels ativos
+        v_iterations = _mm256_sub_epi32(v_iterations, _mm256_castps_si256(v_mask_active));
+
+        __m256 v_new_re = _mm256_add_ps(_mm256_sub_ps(v_z_re2, v_z_im2), v_c_re);
+        __m256 v_new_im = _mm256_add_ps(_mm256_mul_ps(v_two, _mm256_mul_ps(v_z_re, v_z_im)), v_c_im);
+
+        // _mm256_blendv_ps seleciona o segundo argumento se a máscara for true
+        v_z_re = _mm256_blendv_ps(v_z_re, v_new_re, v_mask_active);
+        v_z_im = _mm256_blendv_ps(v_z_im, v_new_im, v_mask_active);
+
+        // Periodicidade: z voltou para perto do ponto guardado
+        __m256 v_near_re = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(v_z_re, v_old_re), v_abs_mask), v_epsilon, _CMP_LE_OQ);
+        __m256 v_near_im = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(v_z_im, v_old_im), v_abs_mask), v_epsilon, _CMP_LE_OQ);
+        v_done = _mm256_or_ps(v_done, _mm256_and_ps(v_mask_active, _mm256_and_ps(v_near_re, v_near_im)));
+
+        if (i + 1 == next_save) {
+            v_old_re = v_z_re;
+            v_old_im = v_z_im;
+            next_save *= 2;
+        }
+    }
+
+    // As lanes resolvidas antes do fim recebem o limite, como se tivessem iterado até ele
+    i32 counts[8] __attribute__((aligned(32)));
+    _mm256_store_si256((__m256i*)counts, v_iterations);
+    int done_bits = _mm256_movemask_ps(v_done);
+    for (int k = 0; k < 8; ++k) {
+        if (done_bits & (1 << k)) *saved += max_iterations - counts[k];
+    }
+
+    return _mm256_blendv_epi8(v_iterations, _mm256_set1_epi32(max_iterations), _mm256_castps_si256(v_done));
+}
+
+/*
+Kernel principal em AVX2: calcula as iterações dos pixels x0, x0 + step, ... < x1
+de uma linha, gravando cada uma em iterations[x]. Cada pixel usa c = start_x + x * zoom,
+tanto nas lanes quanto no laço escalar, para que o resultado não dependa de onde o
+trecho começa nem do passo (faixas, tiles, passadas progressivas, etc).
+*/
+static i64 AVX2SpanF32(i32 *iterations, i32 x0, i32 x1, i32 step, f32 start_x, f32 c_im_scalar, f32 zoom, i32 max_iterations)
+{
+    const __m256 v_zoom_x = _mm256_set1_ps(zoom);
+    const __m256 v_start_x = _mm256_set1_ps(start_x);
+    const __m256i v_lane_offset = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(step));
+    const __m256 v_c_im = _mm256_set1_ps(c_im_scalar);
+
+    i32 iter_counts[8] __attribute__((aligned(32)));
+    i64 saved = 0;
+
+    int x = x0;
+    // Loop principal AVX
+    for (; x + 7 * step < x1; x += 8 * step)
+    {
+        __m256 v_x = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(x), v_lane_offset));
+        __m256 v_c_re = _mm256_add_ps(v_start_x, _mm256_mul_ps(v_x, v_zoom_x));
+        __m256i v_iterations = AVX2LanesF32(v_c_re, v_c_im, max_iterations, &saved);
+
+        // Uso do 'storeu' porque o trecho pode começar em qualquer coluna
+        if (step == 1) {
+            _mm256_storeu_si256((__m256i*)(iterations + x), v_iterations);
+        } else {
+            _mm256_store_si256((__m256i*)iter_counts, v_iterations);
+            for (int k = 0; k < 8; ++k) iterations[x + k * step] = iter_counts[k];
+        }
+    }
+
+    // Processa os pixels restantes se o trecho não for múltiplo de 8
+    for (; x < x1; x += step)
+    {
+        iterations[x] = IterateScalarF32(start_x + x * zoom, c_im_scalar, max_iterations, &saved);
+    }
+
+    return saved;
+}
+
+// O mesmo para os pixels [y0, y1) de uma coluna; o pixel y vai para iterations[y * stride]
+static i64 AVX2ColumnF32(i32 *iterations, i32 stride, i32 y0, i32 y1, f32 c_re_scalar, f32 start_y, f32 zoom, i32 max_iterations)
+{
+    const __m256 v_zoom_y = _mm256_set1_ps(zoom);
+    const __m256 v_start_y = _mm256_set1_ps(start_y);
+    const __m256i v_lane_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 v_c_re = _mm256_set1_ps(c_re_scalar);
+
+    i32 iter_counts[8] __attribute__((aligned(32)));
+    i64 saved = 0;
+
+    int y = y0;
+    for (; y + 7 < y1; y += 8)
+    {
+        __m256 v_y = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(y), v_lane_index));
+        __m256 v_c_im = _mm256_add_ps(v_start_y, _mm256_mul_ps(v_y, v_zoom_y));
+        _mm256_store_si256((__m256i*)iter_counts, AVX2LanesF32(v_c_re, v_c_im, max_iterations, &saved));
+        for (int k = 0; k < 8; ++k) iterations[(size_t)(y + k) * stride] = iter_counts[k];
+    }
+
+    for (; y < y1; ++y)
+    {
+        iterations[(size_t)y * stride] = IterateScalarF32(c_re_scalar, start_y + y * zoom, max_iterations, &saved);
+    }
+
+    return saved;
+}
+
+// Mesma estrutura do kernel f32, mas com 4 pixels de precisão dupla por registrador
+static inline __m256i AVX2LanesF64(__m256d v_c_re, __m256d v_c_im, i32 max_iterations, i64 *saved)
+{
+    const __m256d v_threshold = _mm256_set1_pd(4.0);
+    const __m256d v_two = _mm256_set1_pd(2.0);
+    const __m256d v_quarter = _mm256_set1_pd(0.25);
+    const __m256d v_one = _mm256_set1_pd(1.0);
+    const __m256d v_sixteenth = _mm256_set1_pd(1.0 / 16.0);
+    const __m256d v_epsilon = _mm256_set1_pd(PERIODICITY_EPSILON_F64);
+    const __m256d v_abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+
+    __m256d v_c_im2 = _mm256_mul_pd(v_c_im, v_c_im);
+    __m256d v_xq = _mm256_sub_pd(v_c_re, v_quarter);
+    __m256d v_q = _mm256_add_pd(_mm256_mul_pd(v_xq, v_xq), v_c_im2);
+    __m256d v_in_cardioid = _mm256_cmp_pd(_mm256_mul_pd(v_q, _mm256_add_pd(v_q, v_xq)),
+                                          _mm256_mul_pd(v_quarter, v_c_im2), _CMP_LE_OQ);
+    __m256d v_x1 = _mm256_add_pd(v_c_re, v_one);
+    __m256d v_in_bulb = _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(v_x1, v_x1), v_c_im2), v_sixteenth, _CMP_LE_OQ);
+    __m256d v_done = _mm256_or_pd(v_in_cardioid, v_in_bulb);
+
+    __m256d v_z_re = _mm256_setzero_pd();
+    __m256d v_z_im = _mm256_setzero_pd();
+    __m256d v_old_re = v_z_re;
+    __m256d v_old_im = v_z_im;
+    __m256i v_iterations = _mm256_setzero_si256();
+    int next_save = 1;
+
+    for (int i = 0; i < max_iterations; ++i)
+    {
+        __m256d v_z_re2 = _mm256_mul_pd(v_z_re, v_z_re);
+        __m256d v_z_im2 = _mm256_mul_pd(v_z_im, v_z_im);
+        __m256d v_mag2 = _mm256_add_pd(v_z_re2, v_z_im2);
+
+        __m256d v_mask_active = _mm256_andnot_pd(v_done, _mm256_cmp_pd(v_mag2, v_threshold, _CMP_LE_OQ));
+        if (_mm256_movemask_pd(v_mask_active) == 0) break;
+
+        // Lanes de 64 bits: a máscara -1 incrementa o contador de cada pixel ativo
+        v_iterations = _mm256_sub_epi64(v_iterations, _mm256_castpd_si256(v_mask_active));
+
+        __m256d v_new_re = _mm256_add_pd(_mm256_sub_pd(v_z_re2, v_z_im2), v_c_re);
+        __m256d v_new_im = _mm256_add_pd(_mm256_mul_pd(v_two, _mm256_mul_pd(v_z_re, v_z_im)), v_c_im);
+
+        v_z_re = _mm256_blendv_pd(v_z_re, v_new_re, v_mask_active);
+        v_z_im = _mm256_blendv_pd(v_z_im, v_new_im, v_mask_active);
+
+        __m256d v_near_re = _mm256_cmp_pd(_mm256_and_pd(_mm256_sub_pd(v_z_re, v_old_re), v_abs_mask), v_epsilon, _CMP_LE_OQ);
+        __m256d v_near_im = _mm256_cmp_pd(_mm256_and_pd(_mm256_sub_pd(v_z_im, v_old_im), v_abs_mask), v_epsilon, _CMP_LE_OQ);
+        v_done = _mm256_or_pd(v_done, _mm256_and_pd(v_mask_active, _mm256_and_pd(v_near_re, v_near_im)));
+
+        if (i + 1 == next_save) {
+            v_old_re = v_z_re;
+            v_old_im = v_z_im;
+            next_save *= 2;
+        }
+    }
+
+    i64 counts[4] __attribute__((aligned(32)));
+    _mm256_store_si256((__m256i*)counts, v_iterations);
+    int done_bits = _mm256_movemask_pd(v_done);
+    for (int k = 0; k < 4; ++k) {
+        if (done_bits & (1 << k)) *saved += max_iterations - counts[k];
+    }
+
+    return _mm256_blendv_epi8(v_iterations, _mm256_set1_epi64x(max_iterations), _mm256_castpd_si256(v_done));
+}
+
+static i64 AVX2SpanF64(i32 *iterations, i32 x0, i32 x1, i32 step, f64 start_x, f64 c_im_scalar, f64 zoom, i32 max_iterations)
+{
+    const __m256d v_lane_offset = _mm256_setr_pd(0, step, 2 * step, 3 * step);
+    const __m256d v_zoom = _mm256_set1_pd(zoom);
+    const __m256d v_start_x = _mm256_set1_pd(start_x);
+    const __m256d v_c_im = _mm256_set1_pd(c_im_scalar);
+
+    i64 iter_counts[4] __attribute__((aligned(32)));
+    i64 saved = 0;
+
+    int x = x0;
+    for (; x + 3 * step < x1; x += 4 * step)
+    {
+        // Cada lane calcula start_x + (x + k * step) * zoom, igual ao caminho escalar
+        __m256d v_x = _mm256_add_pd(_mm256_set1_pd((f64)x), v_lane_offset);
+        __m256d v_c_re = _mm256_add_pd(v_start_x, _mm256_mul_pd(v_x, v_zoom));
+
+        _mm256_store_si256((__m256i*)iter_counts, AVX2LanesF64(v_c_re, v_c_im, max_iterations, &saved));
+        for (int k = 0; k < 4; ++k) iterations[x + k * step] = (i32)iter_counts[k];
+    }
+
+    for (; x < x1; x += step)
+    {
+        iterations[x] = IterateScalarF64(start_x + x * zoom, c_im_scalar, max_iterations, &saved);
+    }
+
+    return saved;
+}
+
+static i64 AVX2ColumnF64(i32 *iterations, i32 stride, i32 y0, i32 y1, f64 c_re_scalar, f64 start_y, f64 zoom, i32 max_iterations)
+{
+    const __m256d v_lane_index = _mm256_setr_pd(0, 1, 2, 3);
+    const __m256d v_zoom = _mm256_set1_pd(zoom);
+    const __m256d v_start_y = _mm256_set1_pd(start_y);
+    const __m256d v_c_re = _mm256_set1_pd(c_re_scalar);
+
+    i64 iter_counts[4] __attribute__((aligned(32)));
+    i64 saved = 0;
+
+    int y = y0;
+    for (; y + 3 < y1; y += 4)
+    {
+        __m256d v_y = _mm256_add_pd(_mm256_set1_pd((f64)y), v_lane_index);
+        __m256d v_c_im = _mm256_add_pd(v_start_y, _mm256_mul_pd(v_y, v_zoom));
+
+        _mm256_store_si256((__m256i*)iter_counts, AVX2LanesF64(v_c_re, v_c_im, max_iterations, &saved));
+        for (int k = 0; k < 4; ++k) iterations[(size_t)(y + k) * stride] = (i32)iter_counts[k];
+    }
+
+    for (; y < y1; ++y)
+    {
+        iterations[(size_t)y * stride] = IterateScalarF64(c_re_scalar, start_y + y * zoom, max_iterations, &saved);
+    }
+
+    return saved;
+}
+
+/*
+Double-double em 4 lanes: as mesmas operações de kernels.h, com o erro do produto
+vindo de _mm256_fmsub_pd. É o único uso de FMA fora do kernel "fma", e não muda
+nada bit a bit, porque o erro de um produto é exato por qualquer caminho.
+*/
+typedef struct {
+    __m256d hi;
+    __m256d lo;
+} AVX2DoubleDouble;
+
+static inline AVX2DoubleDouble AVX2DDTwoSum(__m256d a, __m256d b)
+{
+    __m256d s = _mm256_add_pd(a, b);
+    __m256d bb = _mm256_sub_pd(s, a);
+    return (AVX2DoubleDouble){s, _mm256_add_pd(_mm256_sub_pd(a, _mm256_sub_pd(s, bb)), _mm256_sub_pd(b, bb))};
+}
+
+static inline AVX2DoubleDouble AVX2DDQuickTwoSum(__m256d a, __m256d b)
+{
+    __m256d s = _mm256_add_pd(a, b);
+    return (AVX2DoubleDouble){s, _mm256_sub_pd(b, _mm256_sub_pd(s, a))};
+}
+
+static inline AVX2DoubleDouble AVX2DDTwoProd(__m256d a, __m256d b)
+{
+    __m256d p = _mm256_mul_pd(a, b);
+    return (AVX2DoubleDouble){p, _mm256_fmsub_pd(a, b, p)};
+}
+
+static inline AVX2DoubleDouble AVX2DDAdd(AVX2DoubleDouble a, AVX2DoubleDouble b)
+{
+    AVX2DoubleDouble s = AVX2DDTwoSum(a.hi, b.hi);
+    return AVX2DDQuickTwoSum(s.hi, _mm256_add_pd(s.lo, _mm256_add_pd(a.lo, b.lo)));
+}
+
+static inline AVX2DoubleDouble AVX2DDAddF64(AVX2DoubleDouble a, __m256d b)
+{
+    AVX2DoubleDouble s = AVX2DDTwoSum(a.hi, b);
+    return AVX2DDQuickTwoSum(s.hi, _mm256_add_pd(s.lo, a.lo));
+}
+
+static inline AVX2DoubleDouble AVX2DDMul(AVX2DoubleDouble a, AVX2DoubleDouble b)
+{
+    AVX2DoubleDouble p = AVX2DDTwoProd(a.hi, b.hi);
+    __m256d cross = _mm256_add_pd(_mm256_mul_pd(a.hi, b.lo), _mm256_mul_pd(a.lo, b.hi));
+    return AVX2DDQuickTwoSum(p.hi, _mm256_add_pd(p.lo, cross));
+}
+
+static inline AVX2DoubleDouble AVX2DDSqr(AVX2DoubleDouble a)
+{
+    AVX2DoubleDouble p = AVX2DDTwoProd(a.hi, a.hi);
+    __m256d cross = _mm256_mul_pd(_mm256_set1_pd(2.0), _mm256_mul_pd(a.hi, a.lo));
+    return AVX2DDQuickTwoSum(p.hi, _mm256_add_pd(p.lo, cross));
+}
+
+static inline AVX2DoubleDouble AVX2DDBlend(AVX2DoubleDouble a, AVX2DoubleDouble b, __m256d mask)
+{
+    return (AVX2DoubleDouble){_mm256_blendv_pd(a.hi, b.hi, mask), _mm256_blendv_pd(a.lo, b.lo, mask)};
+}
+
+// Mesmo laço de IterateScalarDD, 4 pixels por vez, com as lanes que terminaram congeladas
+static inline __m256i AVX2LanesDD(AVX2DoubleDouble c_re, AVX2DoubleDouble c_im, i32 max_iterations, i64 *saved)
+{
+    const __m256d v_threshold = _mm256_set1_pd(4.0);
+    const __m256d v_two = _mm256_set1_pd(2.0);
+    const __m256d v_quarter = _mm256_set1_pd(0.25);
+    const __m256d v_one = _mm256_set1_pd(1.0);
+    const __m256d v_sixteenth = _mm256_set1_pd(1.0 / 16.0);
+    const __m256d v_epsilon = _mm256_set1_pd(PERIODICITY_EPSILON_DD);
+    const __m256d v_abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+    const __m256d v_sign_mask = _mm256_set1_pd(-0.0);
+
+    __m256d v_c_im2 = _mm256_mul_pd(c_im.hi, c_im.hi);
+    __m256d v_xq = _mm256_sub_pd(c_re.hi, v_quarter);
+    __m256d v_q = _mm256_add_pd(_mm256_mul_pd(v_xq, v_xq), v_c_im2);
+    __m256d v_in_cardioid = _mm256_cmp_pd(_mm256_mul_pd(v_q, _mm256_add_pd(v_q, v_xq)),
+                                          _mm256_mul_pd(v_quarter, v_c_im2), _CMP_LE_OQ);
+    __m256d v_x1 = _mm256_add_pd(c_re.hi, v_one);
+    __m256d v_in_bulb = _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(v_x1, v_x1), v_c_im2), v_sixteenth, _CMP_LE_OQ);
+    __m256d v_done = _mm256_or_pd(v_in_cardioid, v_in_bulb);
+
+    const AVX2DoubleDouble zero = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    AVX2DoubleDouble z_re = zero, z_im = zero, z_re2 = zero, z_im2 = zero;
+    AVX2DoubleDouble old_re = zero, old_im = zero;
+    __m256i v_iterations = _mm256_setzero_si256();
+    int next_save = 1;
+
+    for (int i = 0; i < max_iterations; ++i)
+    {
+        __m256d v_mag2 = _mm256_add_pd(z_re2.hi, z_im2.hi);
+        __m256d v_mask_active = _mm256_andnot_pd(v_done, _mm256_cmp_pd(v_mag2, v_threshold, _CMP_LE_OQ));
+        if (_mm256_movemask_pd(v_mask_active) == 0) break;
+
+        v_iterations = _mm256_sub_epi64(v_iterations, _mm256_castpd_si256(v_mask_active));
+
+        AVX2DoubleDouble product = AVX2DDMul(z_re, z_im);
+        AVX2DoubleDouble twice = {_mm256_mul_pd(v_two, product.hi), _mm256_mul_pd(v_two, product.lo)};
+        AVX2DoubleDouble new_im = AVX2DDAdd(twice, c_im);
+        AVX2DoubleDouble minus_im2 = {_mm256_xor_pd(z_im2.hi, v_sign_mask), _mm256_xor_pd(z_im2.lo, v_sign_mask)};
+        AVX2DoubleDouble new_re = AVX2DDAdd(AVX2DDAdd(z_re2, minus_im2), c_re);
+
+        z_re = AVX2DDBlend(z_re, new_re, v_mask_active);
+        z_im = AVX2DDBlend(z_im, new_im, v_mask_active);
+        z_re2 = AVX2DDSqr(z_re);
+        z_im2 = AVX2DDSqr(z_im);
+
+        __m256d v_delta_re = _mm256_add_pd(_mm256_sub_pd(z_re.hi, old_re.hi), _mm256_sub_pd(z_re.lo, old_re.lo));
+        __m256d v_delta_im = _mm256_add_pd(_mm256_sub_pd(z_im.hi, old_im.hi), _mm256_sub_pd(z_im.lo, old_im.lo));
+        __m256d v_near_re = _mm256_cmp_pd(_mm256_and_pd(v_delta_re, v_abs_mask), v_epsilon, _CMP_LE_OQ);
+        __m256d v_near_im = _mm256_cmp_pd(_mm256_and_pd(v_delta_im, v_abs_mask), v_epsilon, _CMP_LE_OQ);
+        v_done = _mm256_or_pd(v_done, _mm256_and_pd(v_mask_active, _mm256_and_pd(v_near_re, v_near_im)));
+
+        if (i + 1 == next_save) {
+            old_re = z_re;
+            old_im = z_im;
+            next_save *= 2;
+        }
+    }
+
+    i64 counts[4] __attribute__((aligned(32)));
+    _mm256_store_si256((__m256i*)counts, v_iterations);
+    int done_bits = _mm256_movemask_pd(v_done);
+    for (int k = 0; k < 4; ++k) {
+        if (done_bits & (1 << k)) *saved += max_iterations - counts[k];
+    }
+
+    return _mm256_blendv_epi8(v_iterations, _mm256_set1_epi64x(max_iterations), _mm256_castpd_si256(v_done));
+}
+
+i64 AVX2SpanDD(i32 *iterations, i32 x0, i32 x1, i32 step, DoubleDouble start_x, DoubleDouble c_im, f64 zoom,
+               i32 max_iterations)
+{
+    const __m256d v_lane_offset = _mm256_setr_pd(0, step, 2 * step, 3 * step);
+    const __m256d v_zoom = _mm256_set1_pd(zoom);
+    const AVX2DoubleDouble v_start_x = {_mm256_set1_pd(start_x.hi), _mm256_set1_pd(start_x.lo)};
+    const AVX2DoubleDouble v_c_im = {_mm256_set1_pd(c_im.hi), _mm256_set1_pd(c_im.lo)};
+
+    i64 iter_counts[4] __attribute__((aligned(32)));
+    i64 saved = 0;
+
+    int x = x0;
+    for (; x + 3 * step < x1; x += 4 * step)
+    {
+        __m256d v_x = _mm256_add_pd(_mm256_set1_pd((f64)x), v_lane_offset);
+        AVX2DoubleDouble v_c_re = AVX2DDAddF64(v_start_x, _mm256_mul_pd(v_x, v_zoom));
+
+        _mm256_store_si256((__m256i*)iter_counts, AVX2LanesDD(v_c_re, v_c_im, max_iterations, &saved));
+        for (int k = 0; k < 4; ++k) iterations[x + k * step] = (i32)iter_counts[k];
+    }
+
+    for (; x < x1; x += step)
+    {
+        iterations[x] = IterateScalarDD(DDAddF64(start_x, (f64)x * zoom), c_im, max_iterations, &saved);
+    }
+
+    return saved;
+}
+
+i64 AVX2ColumnDD(i32 *iterations, i32 stride, i32 y0, i32 y1, DoubleDouble c_re, DoubleDouble start_y, f64 zoom,
+                 i32 max_iterations)
+{
+    const __m256d v_lane_index = _mm256_setr_pd(0, 1, 2, 3);
+    const __m256d v_zoom = _mm256_set1_pd(zoom);
+    const AVX2DoubleDouble v_start_y = {_mm256_set1_pd(start_y.hi), _mm256_set1_pd(start_y.lo)};
+    const AVX2DoubleDouble v_c_re = {_mm256_set1_pd(c_re.hi), _mm256_set1_pd(c_re.lo)};
+
+    i64 iter_counts[4] __attribute__((aligned(32)));
+    i64 saved = 0;
+
+    int y = y0;
+    for (; y + 3 < y1; y += 4)
+    {
+        __m256d v_y = _mm256_add_pd(_mm256_set1_pd((f64)y), v_lane_index);
+        AVX2DoubleDouble v_c_im = AVX2DDAddF64(v_start_y, _mm256_mul_pd(v_y, v_zoom));
+
+        _mm256_store_si256((__m256i*)iter_counts, AVX2LanesDD(v_c_re, v_c_im, max_iterations, &saved));
+        for (int k = 0; k < 4; ++k) iterations[(size_t)(y + k) * stride] = (i32)iter_counts[k];
+    }
+
+    for (; y < y1; ++y)
+    {
+        iterations[(size_t)y * stride] = IterateScalarDD(c_re, DDAddF64(start_y, (f64)y * zoom), max_iterations, &saved);
+    }
+
+    return saved;
+}
+
+// Máscara de lanes (todos os bits ligados) a partir dos bits de movemask
+static inline __m256 AVX2MaskFromBitsF32(int bits)
+{
+    const __m256i v_lane_bit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits), v_lane_bit), v_lane_bit));
+}
+
+static inline __m256d AVX2MaskFromBitsF64(int bits)
+{
+    const __m256i v_lane_bit = _mm256_setr_epi64x(1, 2, 4, 8);
+    return _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(bits), v_lane_bit), v_lane_bit));
+}
+
+/*
+Bloco com recarga de lanes; mesmas regras de AVX512BlockF32. Com só 16
+registradores ymm, a troca de pixels fica numa função separada que trabalha sobre
+o estado das lanes na memória: inlinada, ela faria o compilador tirar do registrador
+as variáveis do laço de iteração. Sem expand nem scatter, os candidatos da fila são
+distribuídos às lanes livres num laço escalar curto, e as contagens saem do mesmo
+jeito; cardioide e bulbo continuam resolvidos na fila, em vetor.
+*/
+typedef struct {
+    __m256 c_re, c_im, z_re, z_im, old_re, old_im;
+    __m256 done; // Lanes vazias também contam como resolvidas, para ficarem fora das ativas
+    __m256i iterations, next_save, next_event;
+    size_t lane_pixel[8];
+    int live;
+    b32 is_contiguous; // Lane k está no pixel lane_pixel[0] + k
+
+    i32 *pixels;
+    i32 stride, x0, x1, y1;
+    i32 x, y; // Próximo pixel da fila
+    f32 start_x, start_y, zoom;
+    i32 max_iterations;
+    i64 saved;
+} AVX2BlockF32State;
+
+// Grava as lanes terminadas e recarrega as livres; devolve quantas lanes seguem ocupadas
+static __attribute__((noinline)) int AVX2RefillLanesF32(AVX2BlockF32State *block, int finished)
+{
+    const __m256 v_quarter = _mm256_set1_ps(0.25f);
+    const __m256 v_one = _mm256_set1_ps(1.0f);
+    const __m256 v_sixteenth = _mm256_set1_ps(1.0f / 16.0f);
+    const __m256 v_zoom = _mm256_set1_ps(block->zoom);
+    const __m256 v_start_x = _mm256_set1_ps(block->start_x);
+    const __m256i v_lane_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i v_one_i = _mm256_set1_epi32(1);
+    i32 max_iterations = block->max_iterations;
+
+    // As lanes resolvidas antes do fim recebem o limite, como em AVX2LanesF32
+    i32 counts[8] __attribute__((aligned(32)));
+    _mm256_store_si256((__m256i*)counts, block->iterations);
+    int done_bits = _mm256_movemask_ps(block->done);
+    for (int bits = finished & done_bits; bits; bits &= bits - 1) {
+        int k = __builtin_ctz(bits);
+        block->saved += max_iterations - counts[k];
+        counts[k] = max_iterations;
+    }
+    // Caso comum nas regiões que escapam rápido: o grupo inteiro terminou junto e veio de pixels seguidos
+    if (finished == 0xFF && block->is_contiguous) {
+        _mm256_storeu_si256((__m256i*)(block->pixels + block->lane_pixel[0]), _mm256_load_si256((const __m256i*)counts));
+    } else {
+        for (int bits = finished; bits; bits &= bits - 1) {
+            int k = __builtin_ctz(bits);
+            block->pixels[block->lane_pixel[k]] = counts[k];
+        }
+    }
+    block->live &= ~finished;
+
+    f32 candidates[8] __attribute__((aligned(32)));
+    f32 pending_re[8] __attribute__((aligned(32))) = {0};
+    f32 pending_im[8] __attribute__((aligned(32))) = {0};
+    int empty = ~block->live & 0xFF;
+    int refill = 0;
+    __m256 v_fill_re = _mm256_setzero_ps(), v_fill_im = _mm256_setzero_ps();
+    block->is_contiguous = 0;
+    while (empty && block->y < block->y1) {
+        i32 x = block->x, y = block->y;
+        i32 count = (block->x1 - x < 8) ? block->x1 - x : 8;
+        __m256 v_cand_re = _mm256_add_ps(v_start_x, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(x), v_lane_index)), v_zoom));
+        f32 c_im = block->start_y + y * block->zoom;
+        __m256 v_cand_im = _mm256_set1_ps(c_im);
+
+        __m256 v_c_im2 = _mm256_mul_ps(v_cand_im, v_cand_im);
+        __m256 v_xq = _mm256_sub_ps(v_cand_re, v_quarter);
+        __m256 v_q = _mm256_add_ps(_mm256_mul_ps(v_xq, v_xq), v_c_im2);
+        __m256 v_in_cardioid = _mm256_cmp_ps(_mm256_mul_ps(v_q, _mm256_add_ps(v_q, v_xq)),
+                                             _mm256_mul_ps(v_quarter, v_c_im2), _CMP_LE_OQ);
+        __m256 v_x1 = _mm256_add_ps(v_cand_re, v_one);
+        __m256 v_in_bulb = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(v_x1, v_x1), v_c_im2), v_sixteenth, _CMP_LE_OQ);
+        int interior = _mm256_movemask_ps(_mm256_or_ps(v_in_cardioid, v_in_bulb));
+        size_t row_offset = (size_t)y * block->stride;
+
+        // Caso comum: todas as lanes livres e 8 pixels seguidos fora do interior vão direto, na ordem
+        if (empty == 0xFF && count == 8 && !interior) {
+            v_fill_re = v_cand_re;
+            v_fill_im = v_cand_im;
+            for (int k = 0; k < 8; ++k) block->lane_pixel[k] = row_offset + x + k;
+            block->is_contiguous = 1;
+            refill = 0xFF;
+            empty = 0;
+            block->x += 8;
+            if (block->x == block->x1) {
+                block->x = block->x0;
+                ++block->y;
+            }
+            break;
+        }
+        _mm256_store_ps(candidates, v_cand_re);
+
+        // Com mais candidatos que lanes livres, a fila só anda até o último que coube
+        int valid = (1 << count) - 1;
+        interior &= valid;
+        int pending = valid & ~interior;
+        int free_lanes = __builtin_popcount(empty);
+        if (__builtin_popcount(pending) > free_lanes) {
+            int bits = pending;
+            for (int k = 1; k < free_lanes; ++k) bits &= bits - 1;
+            valid = (2 << __builtin_ctz(bits)) - 1;
+            pending &= valid;
+            interior &= valid;
+        }
+
+        // Interior recebe o limite direto, sem passar por uma lane
+        _mm256_maskstore_epi32(block->pixels + row_offset + x, _mm256_castps_si256(AVX2MaskFromBitsF32(interior)),
+                               _mm256_set1_epi32(max_iterations));
+        block->saved += (i64)__builtin_popcount(interior) * max_iterations;
+
+        for (; pending; pending &= pending - 1) {
+            int j = __builtin_ctz(pending);
+            int k = __builtin_ctz(empty);
+            empty &= empty - 1;
+            pending_re[k] = candidates[j];
+            pending_im[k] = c_im;
+            block->lane_pixel[k] = row_offset + x + j;
+            refill |= 1 << k;
+        }
+
+        block->x += __builtin_popcount(valid);
+        if (block->x == block->x1) {
+            block->x = block->x0;
+            ++block->y;
+        }
+    }
+
+    __m256 v_refill = AVX2MaskFromBitsF32(refill);
+    __m256i v_refill_i = _mm256_castps_si256(v_refill);
+    if (!block->is_contiguous) {
+        v_fill_re = _mm256_load_ps(pending_re);
+        v_fill_im = _mm256_load_ps(pending_im);
+    }
+    block->c_re = _mm256_blendv_ps(block->c_re, v_fill_re, v_refill);
+    block->c_im = _mm256_blendv_ps(block->c_im, v_fill_im, v_refill);
+    block->z_re = _mm256_andnot_ps(v_refill, block->z_re);
+    block->z_im = _mm256_andnot_ps(v_refill, block->z_im);
+    block->old_re = _mm256_andnot_ps(v_refill, block->old_re);
+    block->old_im = _mm256_andnot_ps(v_refill, block->old_im);
+    block->iterations = _mm256_andnot_si256(v_refill_i, block->iterations);
+    block->next_save = _mm256_blendv_epi8(block->next_save, v_one_i, v_refill_i);
+    block->next_event = _mm256_blendv_epi8(block->next_event, v_one_i, v_refill_i);
+    block->live |= refill;
+    block->done = AVX2MaskFromBitsF32(~block->live & 0xFF);
+    return block->live;
+}
+
+static i64 AVX2BlockF32(i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1,
+                        f32 start_x, f32 start_y, f32 zoom, i32 max_iterations)
+{
+    const __m256 v_threshold = _mm256_set1_ps(4.0f);
+    const __m256 v_two = _mm256_set1_ps(2.0f);
+    const __m256 v_epsilon = _mm256_set1_ps(PERIODICITY_EPSILON_F32);
+    const __m256 v_abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256i v_max = _mm256_set1_epi32(max_iterations);
+
+    AVX2BlockF32State block = {0};
+    block.done = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    block.next_save = block.next_event = _mm256_set1_epi32(1);
+    block.pixels = iterations;
+    block.stride = stride;
+    block.x0 = x0;
+    block.x1 = x1;
+    block.y1 = y1;
+    block.x = x0;
+    block.y = (x0 < x1) ? y0 : y1;
+    block.start_x = start_x;
+    block.start_y = start_y;
+    block.zoom = zoom;
+    block.max_iterations = max_iterations;
+
+    int finished = 0;
+    while (AVX2RefillLanesF32(&block, finished))
+    {
+        __m256 v_c_re = block.c_re, v_c_im = block.c_im;
+        __m256 v_z_re = block.z_re, v_z_im = block.z_im;
+        __m256 v_old_re = block.old_re, v_old_im = block.old_im;
+        __m256 v_done = block.done;
+        __m256i v_iterations = block.iterations, v_next_event = block.next_event;
+        int live = block.live;
+
+        for (;;)
+        {
+            __m256 v_z_re2 = _mm256_mul_ps(v_z_re, v_z_re);
+            __m256 v_z_im2 = _mm256_mul_ps(v_z_im, v_z_im);
+            __m256 v_mag2 = _mm256_add_ps(v_z_re2, v_z_im2);
+
+            __m256 v_mask_active = _mm256_andnot_ps(v_done, _mm256_cmp_ps(v_mag2, v_threshold, _CMP_LE_OQ));
+            int active = _mm256_movemask_ps(v_mask_active);
+            finished = live & ~active;
+            if (!active || __builtin_popcount(finished) >= REFILL_MIN_LANES(8)) break;
+
+            v_iterations = _mm256_sub_epi32(v_iterations, _mm256_castps_si256(v_mask_active));
+
+            __m256 v_new_re = _mm256_add_ps(_mm256_sub_ps(v_z_re2, v_z_im2), v_c_re);
+            __m256 v_new_im = _mm256_add_ps(_mm256_mul_ps(v_two, _mm256_mul_ps(v_z_re, v_z_im)), v_c_im);
+
+            v_z_re = _mm256_blendv_ps(v_z_re, v_new_re, v_mask_active);
+            v_z_im = _mm256_blendv_ps(v_z_im, v_new_im, v_mask_active);
+
+            __m256 v_near_re = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(v_z_re, v_old_re), v_abs_mask), v_epsilon, _CMP_LE_OQ);
+            __m256 v_near_im = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(v_z_im, v_old_im), v_abs_mask), v_epsilon, _CMP_LE_OQ);
+            v_done = _mm256_or_ps(v_done, _mm256_and_ps(v_mask_active, _mm256_and_ps(v_near_re, v_near_im)));
+
+            // Limite e próxima potência de 2 num só evento, como em AVX512BlockF32
+            __m256i v_event = _mm256_cmpeq_epi32(v_iterations, v_next_event);
+            if (!_mm256_testz_si256(v_event, _mm256_castps_si256(v_mask_active))) {
+                v_event = _mm256_and_si256(v_event, _mm256_castps_si256(v_mask_active));
+                __m256i v_save = _mm256_and_si256(v_event, _mm256_cmpeq_epi32(v_iterations, block.next_save));
+                v_old_re = _mm256_blendv_ps(v_old_re, v_z_re, _mm256_castsi256_ps(v_save));
+                v_old_im = _mm256_blendv_ps(v_old_im, v_z_im, _mm256_castsi256_ps(v_save));
+                block.next_save = _mm256_add_epi32(block.next_save, _mm256_and_si256(block.next_save, v_save));
+                v_next_event = _mm256_min_epi32(block.next_save, v_max);
+                v_done = _mm256_or_ps(v_done, _mm256_castsi256_ps(_mm256_and_si256(v_event, _mm256_cmpeq_epi32(v_iterations, v_max))));
+            }
+        }
+
+        block.z_re = v_z_re;
+        block.z_im = v_z_im;
+        block.old_re = v_old_re;
+        block.old_im = v_old_im;
+        block.done = v_done;
+        block.iterations = v_iterations;
+        block.next_event = v_next_event;
+    }
+
+    return block.saved;
+}
+
+// O mesmo com 4 pixels f64 e contadores de 64 bits, como em AVX2LanesF64
+typedef struct {
+    __m256d c_re, c_im, z_re, z_im, old_re, old_im;
+    __m256d done;
+    __m256i iterations, next_save, next_event;
+    size_t lane_pixel[4];
+    int live;
+    b32 is_contiguous;
+
+    i32 *pixels;
+    i32 stride, x0, x1, y1;
+    i32 x, y;
+    f64 start_x, start_y, zoom;
+    i32 max_iterations;
+    i64 saved;
+} AVX2BlockF64State;
+
+static __attribute__((noinline)) int AVX2RefillLanesF64(AVX2BlockF64State *block, int finished)
+{
+    const __m256d v_quarter = _mm256_set1_pd(0.25);
+    const __m256d v_one = _mm256_set1_pd(1.0);
+    const __m256d v_sixteenth = _mm256_set1_pd(1.0 / 16.0);
+    const __m256d v_zoom = _mm256_set1_pd(block->zoom);
+    const __m256d v_start_x = _mm256_set1_pd(block->start_x);
+    const __m256d v_lane_offset = _mm256_setr_pd(0, 1, 2, 3);
+    const __m256i v_one_i = _mm256_set1_epi64x(1);
+    i32 max_iterations = block->max_iterations;
+
+    i64 counts[4] __attribute__((aligned(32)));
+    _mm256_store_si256((__m256i*)counts, block->iterations);
+    int done_bits = _mm256_movemask_pd(block->done);
+    for (int bits = finished & done_bits; bits; bits &= bits - 1) {
+        int k = __builtin_ctz(bits);
+        block->saved += max_iterations - counts[k];
+        counts[k] = max_iterations;
+    }
+    if (finished == 0xF && block->is_contiguous) {
+        _mm_storeu_si128((__m128i*)(block->pixels + block->lane_pixel[0]), _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_load_si256((const __m256i*)counts), _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6))));
+    } else {
+        for (int bits = finished; bits; bits &= bits - 1) {
+            int k = __builtin_ctz(bits);
+            block->pixels[block->lane_pixel[k]] = (i32)counts[k];
+        }
+    }
+    block->live &= ~finished;
+
+    f64 candidates[4] __attribute__((aligned(32)));
+    f64 pending_re[4] __attribute__((aligned(32))) = {0};
+    f64 pending_im[4] __attribute__((aligned(32))) = {0};
+    int empty = ~block->live & 0xF;
+    int refill = 0;
+    __m256d v_fill_re = _mm256_setzero_pd(), v_fill_im = _mm256_setzero_pd();
+    block->is_contiguous = 0;
+    while (empty && block->y < block->y1) {
+        i32 x = block->x, y = block->y;
+        i32 count = (block->x1 - x < 4) ? block->x1 - x : 4;
+        __m256d v_cand_re = _mm256_add_pd(v_start_x, _mm256_mul_pd(_mm256_add_pd(_mm256_set1_pd((f64)x), v_lane_offset), v_zoom));
+        f64 c_im = block->start_y + y * block->zoom;
+        __m256d v_cand_im = _mm256_set1_pd(c_im);
+
+        __m256d v_c_im2 = _mm256_mul_pd(v_cand_im, v_cand_im);
+        __m256d v_xq = _mm256_sub_pd(v_cand_re, v_quarter);
+        __m256d v_q = _mm256_add_pd(_mm256_mul_pd(v_xq, v_xq), v_c_im2);
+        __m256d v_in_cardioid = _mm256_cmp_pd(_mm256_mul_pd(v_q, _mm256_add_pd(v_q, v_xq)),
+                                              _mm256_mul_pd(v_quarter, v_c_im2), _CMP_LE_OQ);
+        __m256d v_x1 = _mm256_add_pd(v_cand_re, v_one);
+        __m256d v_in_bulb = _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(v_x1, v_x1), v_c_im2), v_sixteenth, _CMP_LE_OQ);
+        int interior = _mm256_movemask_pd(_mm256_or_pd(v_in_cardioid, v_in_bulb));
+        size_t row_offset = (size_t)y * block->stride;
+
+        if (empty == 0xF && count == 4 && !interior) {
+            v_fill_re = v_cand_re;
+            v_fill_im = v_cand_im;
+            for (int k = 0; k < 4; ++k) block->lane_pixel[k] = row_offset + x + k;
+            block->is_contiguous = 1;
+            refill = 0xF;
+            empty = 0;
+            block->x += 4;
+            if (block->x == block->x1) {
+                block->x = block->x0;
+                ++block->y;
+            }
+            break;
+        }
+        _mm256_store_pd(candidates, v_cand_re);
+
+        int valid = (1 << count) - 1;
+        interior &= valid;
+        int pending = valid & ~interior;
+        int free_lanes = __builtin_popcount(empty);
+        if (__builtin_popcount(pending) > free_lanes) {
+            int bits = pending;
+            for (int k = 1; k < free_lanes; ++k) bits &= bits - 1;
+            valid = (2 << __builtin_ctz(bits)) - 1;
+            pending &= valid;
+            interior &= valid;
+        }
+
+        for (int bits = interior; bits; bits &= bits - 1) {
+            block->pixels[row_offset + x + __builtin_ctz(bits)] = max_iterations;
+        }
+        block->saved += (i64)__builtin_popcount(interior) * max_iterations;
+
+        for (; pending; pending &= pending - 1) {
+            int j = __builtin_ctz(pending);
+            int k = __builtin_ctz(empty);
+            empty &= empty - 1;
+            pending_re[k] = candidates[j];
+            pending_im[k] = c_im;
+            block->lane_pixel[k] = row_offset + x + j;
+            refill |= 1 << k;
+        }
+
+        block->x += __builtin_popcount(valid);
+        if (block->x == block->x1) {
+            block->x = block->x0;
+            ++block->y;
+        }
+    }
+
+    __m256d v_refill = AVX2MaskFromBitsF64(refill);
+    __m256i v_refill_i = _mm256_castpd_si256(v_refill);
+    if (!block->is_contiguous) {
+        v_fill_re = _mm256_load_pd(pending_re);
+        v_fill_im = _mm256_load_pd(pending_im);
+    }
+    block->c_re = _mm256_blendv_pd(block->c_re, v_fill_re, v_refill);
+    block->c_im = _mm256_blendv_pd(block->c_im, v_fill_im, v_refill);
+    block->z_re = _mm256_andnot_pd(v_refill, block->z_re);
+    block->z_im = _mm256_andnot_pd(v_refill, block->z_im);
+    block->old_re = _mm256_andnot_pd(v_refill, block->old_re);
+    block->old_im = _mm256_andnot_pd(v_refill, block->old_im);
+    block->iterations = _mm256_andnot_si256(v_refill_i, block->iterations);
+    block->next_save = _mm256_blendv_epi8(block->next_save, v_one_i, v_refill_i);
+    block->next_event = _mm256_blendv_epi8(block->next_event, v_one_i, v_refill_i);
+    block->live |= refill;
+    block->done = AVX2MaskFromBitsF64(~block->live & 0xF);
+    return block->live;
+}
+
+static i64 AVX2BlockF64(i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1,
+                        f64 start_x, f64 start_y, f64 zoom, i32 max_iterations)
+{
+    const __m256d v_threshold = _mm256_set1_pd(4.0);
+    const __m256d v_two = _mm256_set1_pd(2.0);
+    const __m256d v_epsilon = _mm256_set1_pd(PERIODICITY_EPSILON_F64);
+    const __m256d v_abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+    const __m256i v_max = _mm256_set1_epi64x(max_iterations);
+
+    AVX2BlockF64State block = {0};
+    block.done = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    block.next_save = block.next_event = _mm256_set1_epi64x(1);
+    block.pixels = iterations;
+    block.stride = stride;
+    block.x0 = x0;
+    block.x1 = x1;
+    block.y1 = y1;
+    block.x = x0;
+    block.y = (x0 < x1) ? y0 : y1;
+    block.start_x = start_x;
+    block.start_y = start_y;
+    block.zoom = zoom;
+    block.max_iterations = max_iterations;
+
+    int finished = 0;
+    while (AVX2RefillLanesF64(&block, finished))
+    {
+        __m256d v_c_re = block.c_re, v_c_im = block.c_im;
+        __m256d v_z_re = block.z_re, v_z_im = block.z_im;
+        __m256d v_old_re = block.old_re, v_old_im = block.old_im;
+        __m256d v_done = block.done;
+        __m256i v_iterations = block.iterations, v_next_event = block.next_event;
+        int live = block.live;
+
+        for (;;)
+        {
+            __m256d v_z_re2 = _mm256_mul_pd(v_z_re, v_z_re);
+            __m256d v_z_im2 = _mm256_mul_pd(v_z_im, v_z_im);
+            __m256d v_mag2 = _mm256_add_pd(v_z_re2, v_z_im2);
+
+            __m256d v_mask_active = _mm256_andnot_pd(v_done, _mm256_cmp_pd(v_mag2, v_threshold, _CMP_LE_OQ));
+            int active = _mm256_movemask_pd(v_mask_active);
+            finished = live & ~active;
+            if (!active || __builtin_popcount(finished) >= REFILL_MIN_LANES(4)) break;
+
+            v_iterations = _mm256_sub_epi64(v_iterations, _mm256_castpd_si256(v_mask_active));
+
+            __m256d v_new_re = _mm256_add_pd(_mm256_sub_pd(v_z_re2, v_z_im2), v_c_re);
+            __m256d v_new_im = _mm256_add_pd(_mm256_mul_pd(v_two, _mm256_mul_pd(v_z_re, v_z_im)), v_c_im);
+
+            v_z_re = _mm256_blendv_pd(v_z_re, v_new_re, v_mask_active);
+            v_z_im = _mm256_blendv_pd(v_z_im, v_new_im, v_mask_active);
+
+            __m256d v_near_re = _mm256_cmp_pd(_mm256_and_pd(_mm256_sub_pd(v_z_re, v_old_re), v_abs_mask), v_epsilon, _CMP_LE_OQ);
+            __m256d v_near_im = _mm256_cmp_pd(_mm256_and_pd(_mm256_sub_pd(v_z_im, v_old_im), v_abs_mask), v_epsilon, _CMP_LE_OQ);
+            v_done = _mm256_or_pd(v_done, _mm256_and_pd(v_mask_active, _mm256_and_pd(v_near_re, v_near_im)));
+
+            __m256i v_event = _mm256_cmpeq_epi64(v_iterations, v_next_event);
+            if (!_mm256_testz_si256(v_event, _mm256_castpd_si256(v_mask_active))) {
+                v_event = _mm256_and_si256(v_event, _mm256_castpd_si256(v_mask_active));
+                __m256i v_save = _mm256_and_si256(v_event, _mm256_cmpeq_epi64(v_iterations, block.next_save));
+                v_old_re = _mm256_blendv_pd(v_old_re, v_z_re, _mm256_castsi256_pd(v_save));
+                v_old_im = _mm256_blendv_pd(v_old_im, v_z_im, _mm256_castsi256_pd(v_save));
+                block.next_save = _mm256_add_epi64(block.next_save, _mm256_and_si256(block.next_save, v_save));
+                // Sem min de 64 bits no AVX2: o evento é next_save enquanto ele não passa do limite
+                v_next_event = _mm256_blendv_epi8(block.next_save, v_max, _mm256_cmpgt_epi64(block.next_save, v_max));
+                v_done = _mm256_or_pd(v_done, _mm256_castsi256_pd(_mm256_and_si256(v_event, _mm256_cmpeq_epi64(v_iterations, v_max))));
+            }
+        }
+
+        block.z_re = v_z_re;
+        block.z_im = v_z_im;
+        block.old_re = v_old_re;
+        block.old_im = v_old_im;
+        block.done = v_done;
+        block.iterations = v_iterations;
+        block.next_event = v_next_event;
+    }
+
+    return block.saved;
+}
+
+// 4 pixels por registrador com desvios em f64; cada lane tem seu próprio índice na referência
+void AVX2PerturbLanesF64(const ReferenceLanes *ref, const f64 *dc_re, const f64 *dc_im,
+                         const f64 *d_re, const f64 *d_im, i32 skip, i32 max_iterations, i32 *counts)
+{
+    const __m256d v_threshold = _mm256_set1_pd(4.0);
+    const __m256d v_two = _mm256_set1_pd(2.0);
+    const __m256i v_last = _mm256_set1_epi64x(ref->length - 1);
+
+    __m256d v_dc_re = _mm256_loadu_pd(dc_re);
+    __m256d v_dc_im = _mm256_loadu_pd(dc_im);
+    __m256d v_d_re = _mm256_loadu_pd(d_re);
+    __m256d v_d_im = _mm256_loadu_pd(d_im);
+    __m256i v_m = _mm256_set1_epi64x(skip);
+    __m256i v_iterations = _mm256_set1_epi64x(skip);
+    __m256d v_active = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+
+    for (int i = skip; i < max_iterations; ++i)
+    {
+        __m256d v_zr = _mm256_i64gather_pd(ref->z_re, v_m, 8);
+        __m256d v_zi = _mm256_i64gather_pd(ref->z_im, v_m, 8);
+        __m256d v_z_re = _mm256_add_pd(v_zr, v_d_re);
+        __m256d v_z_im = _mm256_add_pd(v_zi, v_d_im);
+        __m256d v_mag2 = _mm256_add_pd(_mm256_mul_pd(v_z_re, v_z_re), _mm256_mul_pd(v_z_im, v_z_im));
+
+        v_active = _mm256_and_pd(v_active, _mm256_cmp_pd(v_mag2, v_threshold, _CMP_LE_OQ));
+        if (_mm256_movemask_pd(v_active) == 0) break;
+        v_iterations = _mm256_sub_epi64(v_iterations, _mm256_castpd_si256(v_active));
+
+        // Rebase: |z| < |d| ou a referência acabou
+        __m256d v_d_mag2 = _mm256_add_pd(_mm256_mul_pd(v_d_re, v_d_re), _mm256_mul_pd(v_d_im, v_d_im));
+        __m256d v_rebase = _mm256_or_pd(_mm256_cmp_pd(v_mag2, v_d_mag2, _CMP_LT_OQ),
+                                        _mm256_castsi256_pd(_mm256_cmpeq_epi64(v_m, v_last)));
+        v_d_re = _mm256_blendv_pd(v_d_re, v_z_re, v_rebase);
+        v_d_im = _mm256_blendv_pd(v_d_im, v_z_im, v_rebase);
+        v_zr = _mm256_andnot_pd(v_rebase, v_zr);
+        v_zi = _mm256_andnot_pd(v_rebase, v_zi);
+        v_m = _mm256_andnot_si256(_mm256_castpd_si256(v_rebase), v_m);
+
+        __m256d v_tr = _mm256_add_pd(_mm256_mul_pd(v_two, v_zr), v_d_re);
+        __m256d v_ti = _mm256_add_pd(_mm256_mul_pd(v_two, v_zi), v_d_im);
+        __m256d v_new_re = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(v_tr, v_d_re), _mm256_mul_pd(v_ti, v_d_im)), v_dc_re);
+        __m256d v_new_im = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(v_tr, v_d_im), _mm256_mul_pd(v_ti, v_d_re)), v_dc_im);
+
+        v_d_re = _mm256_blendv_pd(v_d_re, v_new_re, v_active);
+        v_d_im = _mm256_blendv_pd(v_d_im, v_new_im, v_active);
+        v_m = _mm256_sub_epi64(v_m, _mm256_castpd_si256(v_active));
+    }
+
+    // Contagens de 64 bits para 32: pega o dword baixo de cada lane
+    __m256i v_low = _mm256_permutevar8x32_epi32(v_iterations, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+    _mm_storeu_si128((__m128i*)counts, _mm256_castsi256_si128(v_low));
+}
+
+// Mesma iteração com 8 desvios em f32, para zooms em que eles ainda são representáveis
+void AVX2PerturbLanesF32(const ReferenceLanes *ref, const f32 *dc_re, const f32 *dc_im,
+                         const f32 *d_re, const f32 *d_im, i32 skip, i32 max_iterations, i32 *counts)
+{
+    const __m256 v_threshold = _mm256_set1_ps(4.0f);
+    const __m256 v_two = _mm256_set1_ps(2.0f);
+    const __m256i v_last = _mm256_set1_epi32(ref->length - 1);
+
+    __m256 v_dc_re = _mm256_loadu_ps(dc_re);
+    __m256 v_dc_im = _mm256_loadu_ps(dc_im);
+    __m256 v_d_re = _mm256_loadu_ps(d_re);
+    __m256 v_d_im = _mm256_loadu_ps(d_im);
+    __m256i v_m = _mm256_set1_epi32(skip);
+    __m256i v_iterations = _mm256_set1_epi32(skip);
+    __m256 v_active = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+    for (int i = skip; i < max_iterations; ++i)
+    {
+        __m256 v_zr = _mm256_i32gather_ps(ref->z_re32, v_m, 4);
+        __m256 v_zi = _mm256_i32gather_ps(ref->z_im32, v_m, 4);
+        __m256 v_z_re = _mm256_add_ps(v_zr, v_d_re);
+        __m256 v_z_im = _mm256_add_ps(v_zi, v_d_im);
+        __m256 v_mag2 = _mm256_add_ps(_mm256_mul_ps(v_z_re, v_z_re), _mm256_mul_ps(v_z_im, v_z_im));
+
+        v_active = _mm256_and_ps(v_active, _mm256_cmp_ps(v_mag2, v_threshold, _CMP_LE_OQ));
+        if (_mm256_movemask_ps(v_active) == 0) break;
+        v_iterations = _mm256_sub_epi32(v_iterations, _mm256_castps_si256(v_active));
+
+        __m256 v_d_mag2 = _mm256_add_ps(_mm256_mul_ps(v_d_re, v_d_re), _mm256_mul_ps(v_d_im, v_d_im));
+        __m256 v_rebase = _mm256_or_ps(_mm256_cmp_ps(v_mag2, v_d_mag2, _CMP_LT_OQ),
+                                       _mm256_castsi256_ps(_mm256_cmpeq_epi32(v_m, v_last)));
+        v_d_re = _mm256_blendv_ps(v_d_re, v_z_re, v_rebase);
+        v_d_im = _mm256_blendv_ps(v_d_im, v_z_im, v_rebase);
+        v_zr = _mm256_andnot_ps(v_rebase, v_zr);
+        v_zi = _mm256_andnot_ps(v_rebase, v_zi);
+        v_m = _mm256_andnot_si256(_mm256_castps_si256(v_rebase), v_m);
+
+        __m256 v_tr = _mm256_add_ps(_mm256_mul_ps(v_two, v_zr), v_d_re);
+        __m256 v_ti = _mm256_add_ps(_mm256_mul_ps(v_two, v_zi), v_d_im);
+        __m256 v_new_re = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(v_tr, v_d_re), _mm256_mul_ps(v_ti, v_d_im)), v_dc_re);
+        __m256 v_new_im = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(v_tr, v_d_im), _mm256_mul_ps(v_ti, v_d_re)), v_dc_im);
+
+        v_d_re = _mm256_blendv_ps(v_d_re, v_new_re, v_active);
+        v_d_im = _mm256_blendv_ps(v_d_im, v_new_im, v_active);
+        v_m = _mm256_sub_epi32(v_m, _mm256_castps_si256(v_active));
+    }
+
+    _mm256_storeu_si256((__m256i*)counts, v_iterations);
+}
+
+// 8 consultas à tabela por gather
+void AVX2ColorizeSpan(u32 *pixels, const i32 *iterations, i32 count, const u32 *lut, i32 max_iterations)
+{
+    const __m256i v_max = _mm256_set1_epi32(max_iterations);
+
+    int k = 0;
+    if (count >= COLORIZE_STREAM_MIN_PIXELS && ((uintptr_t)pixels & 31) == 0) {
+        for (; k + 7 < count; k += 8) {
+            __m256i v_index = _mm256_min_epi32(_mm256_loadu_si256((const __m256i*)(iterations + k)), v_max);
+            _mm256_stream_si256((__m256i*)(pixels + k), _mm256_i32gather_epi32((const int *)lut, v_index, 4));
+        }
+        // Os stores sem cache não seguem a ordem dos outros; a linha precisa estar completa para quem a ler
+        _mm_sfence();
+    }
+    for (; k + 7 < count; k += 8) {
+        __m256i v_index = _mm256_min_epi32(_mm256_loadu_si256((const __m256i*)(iterations + k)), v_max);
+        _mm256_storeu_si256((__m256i*)(pixels + k), _mm256_i32gather_epi32((const int *)lut, v_index, 4));
+    }
+    ScalarColorizeSpan(pixels + k, iterations + k, count - k, lut, max_iterations);
+}
+
+const IterationKernel KernelAVX2 = {
+    "avx2",
+    AVX2SpanF32,
+    AVX2SpanF64,
+    AVX2ColumnF32,
+    AVX2ColumnF64,
+    AVX2PerturbLanesF32,
+    AVX2PerturbLanesF64,
+    AVX2ColorizeSpan,
+    AVX2BlockF32,
+    AVX2BlockF64,
+    AVX2SpanDD,
+    AVX2ColumnDD,
+};
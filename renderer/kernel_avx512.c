@@ -0,0 +1,586 @@
+#include "platform.h"
+#include "kernels.h"
+
+#include <immintrin.h> // AVX-512F
+
+/*
+Kernel AVX-512: 16 pixels f32 ou 8 f64 por registrador. As máscaras de lanes
+ativas e resolvidas ficam nos registradores k, então o contador é incrementado e
+z atualizado direto com operações mascaradas, sem blend. A perturbação continua
+nas 8 lanes do kernel AVX2.
+*/
+
+// Itera 16 pixels f32; mesmas contas e saídas antecipadas de IterateScalarF32
+static inline __m512i AVX512LanesF32(__m512 v_c_re, __m512 v_c_im, i32 max_iterations, i64 *saved)
+{
+    const __m512 v_threshold = _mm512_set1_ps(4.0f);
+    const __m512 v_two = _mm512_set1_ps(2.0f);
+    const __m512 v_quarter = _mm512_set1_ps(0.25f);
+    const __m512 v_one = _mm512_set1_ps(1.0f);
+    const __m512 v_sixteenth = _mm512_set1_ps(1.0f / 16.0f);
+    const __m512 v_epsilon = _mm512_set1_ps(PERIODICITY_EPSILON_F32);
+    const __m512i v_one_i = _mm512_set1_epi32(1);
+
+    __m512 v_c_im2 = _mm512_mul_ps(v_c_im, v_c_im);
+    __m512 v_xq = _mm512_sub_ps(v_c_re, v_quarter);
+    __m512 v_q = _mm512_add_ps(_mm512_mul_ps(v_xq, v_xq), v_c_im2);
+    __mmask16 in_cardioid = _mm512_cmp_ps_mask(_mm512_mul_ps(v_q, _mm512_add_ps(v_q, v_xq)),
+                                               _mm512_mul_ps(v_quarter, v_c_im2), _CMP_LE_OQ);
+    __m512 v_x1 = _mm512_add_ps(v_c_re, v_one);
+    __mmask16 in_bulb = _mm512_cmp_ps_mask(_mm512_add_ps(_mm512_mul_ps(v_x1, v_x1), v_c_im2), v_sixteenth, _CMP_LE_OQ);
+    __mmask16 done = in_cardioid | in_bulb;
+
+    __m512 v_z_re = _mm512_setzero_ps();
+    __m512 v_z_im = _mm512_setzero_ps();
+    __m512 v_old_re = v_z_re;
+    __m512 v_old_im = v_z_im;
+    __m512i v_iterations = _mm512_setzero_si512();
+    int next_save = 1;
+
+    for (int i = 0; i < max_iterations; ++i)
+    {
+        __m512 v_z_re2 = _mm512_mul_ps(v_z_re, v_z_re);
+        __m512 v_z_im2 = _mm512_mul_ps(v_z_im, v_z_im);
+        __m512 v_mag2 = _mm512_add_ps(v_z_re2, v_z_im2);
+
+        __mmask16 active = _mm512_mask_cmp_ps_mask((__mmask16)~done, v_mag2, v_threshold, _CMP_LE_OQ);
+        if (active == 0) break;
+
+        v_iterations = _mm512_mask_add_epi32(v_iterations, active, v_iterations, v_one_i);
+
+        __m512 v_new_re = _mm512_add_ps(_mm512_sub_ps(v_z_re2, v_z_im2), v_c_re);
+        __m512 v_new_im = _mm512_add_ps(_mm512_mul_ps(v_two, _mm512_mul_ps(v_z_re, v_z_im)), v_c_im);
+
+        v_z_re = _mm512_mask_mov_ps(v_z_re, active, v_new_re);
+        v_z_im = _mm512_mask_mov_ps(v_z_im, active, v_new_im);
+
+        __mmask16 near_re = _mm512_mask_cmp_ps_mask(active, _mm512_abs_ps(_mm512_sub_ps(v_z_re, v_old_re)), v_epsilon, _CMP_LE_OQ);
+        __mmask16 near_im = _mm512_mask_cmp_ps_mask(near_re, _mm512_abs_ps(_mm512_sub_ps(v_z_im, v_old_im)), v_epsilon, _CMP_LE_OQ);
+        done |= near_im;
+
+        if (i + 1 == next_save) {
+            v_old_re = v_z_re;
+            v_old_im = v_z_im;
+            next_save *= 2;
+        }
+    }
+
+    __m512i v_max = _mm512_set1_epi32(max_iterations);
+    *saved += _mm512_mask_reduce_add_epi32(done, _mm512_sub_epi32(v_max, v_iterations));
+
+    return _mm512_mask_mov_epi32(v_iterations, done, v_max);
+}
+
+static i64 AVX512SpanF32(i32 *iterations, i32 x0, i32 x1, i32 step, f32 start_x, f32 c_im_scalar, f32 zoom, i32 max_iterations)
+{
+    const __m512 v_zoom_x = _mm512_set1_ps(zoom);
+    const __m512 v_start_x = _mm512_set1_ps(start_x);
+    const __m512i v_lane_offset = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+                                                     _mm512_set1_epi32(step));
+    const __m512 v_c_im = _mm512_set1_ps(c_im_scalar);
+
+    i64 saved = 0;
+
+    int x = x0;
+    for (; x + 15 * step < x1; x += 16 * step)
+    {
+        __m512 v_x = _mm512_cvtepi32_ps(_mm512_add_epi32(_mm512_set1_epi32(x), v_lane_offset));
+        __m512 v_c_re = _mm512_add_ps(v_start_x, _mm512_mul_ps(v_x, v_zoom_x));
+        __m512i v_iterations = AVX512LanesF32(v_c_re, v_c_im, max_iterations, &saved);
+
+        // Com passo o scatter grava cada lane direto na sua coluna
+        if (step == 1) {
+            _mm512_storeu_si512((void*)(iterations + x), v_iterations);
+        } else {
+            _mm512_i32scatter_epi32(iterations + x, v_lane_offset, v_iterations, 4);
+        }
+    }
+
+    for (; x < x1; x += step)
+    {
+        iterations[x] = IterateScalarF32(start_x + x * zoom, c_im_scalar, max_iterations, &saved);
+    }
+
+    return saved;
+}
+
+static i64 AVX512ColumnF32(i32 *iterations, i32 stride, i32 y0, i32 y1, f32 c_re_scalar, f32 start_y, f32 zoom, i32 max_iterations)
+{
+    const __m512 v_zoom_y = _mm512_set1_ps(zoom);
+    const __m512 v_start_y = _mm512_set1_ps(start_y);
+    const __m512i v_lane_index = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512 v_c_re = _mm512_set1_ps(c_re_scalar);
+
+    i32 iter_counts[16] __attribute__((aligned(64)));
+    i64 saved = 0;
+
+    int y = y0;
+    for (; y + 15 < y1; y += 16)
+    {
+        __m512 v_y = _mm512_cvtepi32_ps(_mm512_add_epi32(_mm512_set1_epi32(y), v_lane_index));
+        __m512 v_c_im = _mm512_add_ps(v_start_y, _mm512_mul_ps(v_y, v_zoom_y));
+        _mm512_store_si512((void*)iter_counts, AVX512LanesF32(v_c_re, v_c_im, max_iterations, &saved));
+        for (int k = 0; k < 16; ++k) iterations[(size_t)(y + k) * stride] = iter_counts[k];
+    }
+
+    for (; y < y1; ++y)
+    {
+        iterations[(size_t)y * stride] = IterateScalarF32(c_re_scalar, start_y + y * zoom, max_iterations, &saved);
+    }
+
+    return saved;
+}
+
+// Mesma estrutura com 8 pixels f64; o contador usa lanes de 64 bits e sai convertido para 32
+static inline __m256i AVX512LanesF64(__m512d v_c_re, __m512d v_c_im, i32 max_iterations, i64 *saved)
+{
+    const __m512d v_threshold = _mm512_set1_pd(4.0);
+    const __m512d v_two = _mm512_set1_pd(2.0);
+    const __m512d v_quarter = _mm512_set1_pd(0.25);
+    const __m512d v_one = _mm512_set1_pd(1.0);
+    const __m512d v_sixteenth = _mm512_set1_pd(1.0 / 16.0);
+    const __m512d v_epsilon = _mm512_set1_pd(PERIODICITY_EPSILON_F64);
+    const __m512i v_one_i = _mm512_set1_epi64(1);
+
+    __m512d v_c_im2 = _mm512_mul_pd(v_c_im, v_c_im);
+    __m512d v_xq = _mm512_sub_pd(v_c_re, v_quarter);
+    __m512d v_q = _mm512_add_pd(_mm512_mul_pd(v_xq, v_xq), v_c_im2);
+    __mmask8 in_cardioid = _mm512_cmp_pd_mask(_mm512_mul_pd(v_q, _mm512_add_pd(v_q, v_xq)),
+                                              _mm512_mul_pd(v_quarter, v_c_im2), _CMP_LE_OQ);
+    __m512d v_x1 = _mm512_add_pd(v_c_re, v_one);
+    __mmask8 in_bulb = _mm512_cmp_pd_mask(_mm512_add_pd(_mm512_mul_pd(v_x1, v_x1), v_c_im2), v_sixteenth, _CMP_LE_OQ);
+    __mmask8 done = in_cardioid | in_bulb;
+
+    __m512d v_z_re = _mm512_setzero_pd();
+    __m512d v_z_im = _mm512_setzero_pd();
+    __m512d v_old_re = v_z_re;
+    __m512d v_old_im = v_z_im;
+    __m512i v_iterations = _mm512_setzero_si512();
+    int next_save = 1;
+
+    for (int i = 0; i < max_iterations; ++i)
+    {
+        __m512d v_z_re2 = _mm512_mul_pd(v_z_re, v_z_re);
+        __m512d v_z_im2 = _mm512_mul_pd(v_z_im, v_z_im);
+        __m512d v_mag2 = _mm512_add_pd(v_z_re2, v_z_im2);
+
+        __mmask8 active = _mm512_mask_cmp_pd_mask((__mmask8)~done, v_mag2, v_threshold, _CMP_LE_OQ);
+        if (active == 0) break;
+
+        v_iterations = _mm512_mask_add_epi64(v_iterations, active, v_iterations, v_one_i);
+
+        __m512d v_new_re = _mm512_add_pd(_mm512_sub_pd(v_z_re2, v_z_im2), v_c_re);
+        __m512d v_new_im = _mm512_add_pd(_mm512_mul_pd(v_two, _mm512_mul_pd(v_z_re, v_z_im)), v_c_im);
+
+        v_z_re = _mm512_mask_mov_pd(v_z_re, active, v_new_re);
+        v_z_im = _mm512_mask_mov_pd(v_z_im, active, v_new_im);
+
+        __mmask8 near_re = _mm512_mask_cmp_pd_mask(active, _mm512_abs_pd(_mm512_sub_pd(v_z_re, v_old_re)), v_epsilon, _CMP_LE_OQ);
+        __mmask8 near_im = _mm512_mask_cmp_pd_mask(near_re, _mm512_abs_pd(_mm512_sub_pd(v_z_im, v_old_im)), v_epsilon, _CMP_LE_OQ);
+        done |= near_im;
+
+        if (i + 1 == next_save) {
+            v_old_re = v_z_re;
+            v_old_im = v_z_im;
+            next_save *= 2;
+        }
+    }
+
+    __m512i v_max = _mm512_set1_epi64(max_iterations);
+    *saved += _mm512_mask_reduce_add_epi64(done, _mm512_sub_epi64(v_max, v_iterations));
+
+    return _mm512_cvtepi64_epi32(_mm512_mask_mov_epi64(v_iterations, done, v_max));
+}
+
+static i64 AVX512SpanF64(i32 *iterations, i32 x0, i32 x1, i32 step, f64 start_x, f64 c_im_scalar, f64 zoom, i32 max_iterations)
+{
+    const __m256i v_lane_offset = _mm256_setr_epi32(0, step, 2 * step, 3 * step, 4 * step, 5 * step, 6 * step, 7 * step);
+    const __m512d v_zoom = _mm512_set1_pd(zoom);
+    const __m512d v_start_x = _mm512_set1_pd(start_x);
+    const __m512d v_c_im = _mm512_set1_pd(c_im_scalar);
+
+    i64 saved = 0;
+
+    int x = x0;
+    for (; x + 7 * step < x1; x += 8 * step)
+    {
+        // Cada lane calcula start_x + (x + k * step) * zoom, igual ao caminho escalar
+        __m512d v_x = _mm512_add_pd(_mm512_set1_pd((f64)x), _mm512_cvtepi32_pd(v_lane_offset));
+        __m512d v_c_re = _mm512_add_pd(v_start_x, _mm512_mul_pd(v_x, v_zoom));
+        __m256i v_iterations = AVX512LanesF64(v_c_re, v_c_im, max_iterations, &saved);
+
+        if (step == 1) {
+            _mm256_storeu_si256((__m256i*)(iterations + x), v_iterations);
+        } else {
+            // Só as 8 lanes de baixo existem; as de cima da conversão para 512 bits são lixo
+            _mm512_mask_i32scatter_epi32(iterations + x, 0x00FF, _mm512_castsi256_si512(v_lane_offset),
+                                         _mm512_castsi256_si512(v_iterations), 4);
+        }
+    }
+
+    for (; x < x1; x += step)
+    {
+        iterations[x] = IterateScalarF64(start_x + x * zoom, c_im_scalar, max_iterations, &saved);
+    }
+
+    return saved;
+}
+
+static i64 AVX512ColumnF64(i32 *iterations, i32 stride, i32 y0, i32 y1, f64 c_re_scalar, f64 start_y, f64 zoom, i32 max_iterations)
+{
+    const __m512d v_lane_index = _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m512d v_zoom = _mm512_set1_pd(zoom);
+    const __m512d v_start_y = _mm512_set1_pd(start_y);
+    const __m512d v_c_re = _mm512_set1_pd(c_re_scalar);
+
+    i32 iter_counts[8] __attribute__((aligned(32)));
+    i64 saved = 0;
+
+    int y = y0;
+    for (; y + 7 < y1; y += 8)
+    {
+        __m512d v_y = _mm512_add_pd(_mm512_set1_pd((f64)y), v_lane_index);
+        __m512d v_c_im = _mm512_add_pd(v_start_y, _mm512_mul_pd(v_y, v_zoom));
+
+        _mm256_store_si256((__m256i*)iter_counts, AVX512LanesF64(v_c_re, v_c_im, max_iterations, &saved));
+        for (int k = 0; k < 8; ++k) iterations[(size_t)(y + k) * stride] = iter_counts[k];
+    }
+
+    for (; y < y1; ++y)
+    {
+        iterations[(size_t)y * stride] = IterateScalarF64(c_re_scalar, start_y + y * zoom, max_iterations, &saved);
+    }
+
+    return saved;
+}
+
+// Menores 'count' bits ligados de 'bits'
+static inline u32 LowestBits(u32 bits, int count)
+{
+    u32 result = 0;
+    for (; count > 0 && bits; --count) {
+        result |= bits & (0u - bits);
+        bits &= bits - 1;
+    }
+    return result;
+}
+
+/*
+Bloco com recarga de lanes. Cada lane guarda o seu pixel, a sua contagem e o seu
+próximo ponto de salvamento da periodicidade, então lanes vizinhas podem estar em
+pixels e iterações diferentes. Quando metade das lanes terminou, as contagens vão
+para o buffer por scatter e as lanes livres recebem os próximos pixels da fila por
+expand, com z = 0. Pixels do cardioide e do bulbo são resolvidos já na fila e nem
+chegam a ocupar uma lane. Por pixel as contas são as de AVX512LanesF32, na mesma
+ordem, então as contagens são as mesmas bit a bit.
+
+O limite e a próxima potência de 2 viram um único "evento" por lane
+(min(next_save, max)), para que o laço comum pague só uma comparação a mais; chegar
+ao limite marca a lane como resolvida, o que dá a mesma contagem sem economia.
+*/
+static i64 AVX512BlockF32(i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1,
+                          f32 start_x, f32 start_y, f32 zoom, i32 max_iterations)
+{
+    const __m512 v_threshold = _mm512_set1_ps(4.0f);
+    const __m512 v_two = _mm512_set1_ps(2.0f);
+    const __m512 v_quarter = _mm512_set1_ps(0.25f);
+    const __m512 v_one = _mm512_set1_ps(1.0f);
+    const __m512 v_sixteenth = _mm512_set1_ps(1.0f / 16.0f);
+    const __m512 v_epsilon = _mm512_set1_ps(PERIODICITY_EPSILON_F32);
+    const __m512 v_zoom = _mm512_set1_ps(zoom);
+    const __m512 v_start_x = _mm512_set1_ps(start_x);
+    const __m512i v_lane_index = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i v_one_i = _mm512_set1_epi32(1);
+    const __m512i v_max = _mm512_set1_epi32(max_iterations);
+
+    // Posições relativas à primeira linha do bloco, para caberem nos índices de 32 bits do scatter
+    i32 *block = iterations + (size_t)y0 * stride;
+    i32 x = x0, y = (x0 < x1) ? y0 : y1;
+
+    __m512 v_c_re = _mm512_setzero_ps();
+    __m512 v_c_im = _mm512_setzero_ps();
+    __m512 v_z_re = _mm512_setzero_ps();
+    __m512 v_z_im = _mm512_setzero_ps();
+    __m512 v_old_re = v_z_re;
+    __m512 v_old_im = v_z_im;
+    __m512i v_iterations = _mm512_setzero_si512();
+    __m512i v_next_save = v_one_i;
+    __m512i v_next_event = v_one_i;
+    __m512i v_pixel = _mm512_setzero_si512();
+    __mmask16 live = 0, done = 0;
+    i64 saved = 0;
+
+    for (;;)
+    {
+        __m512 v_z_re2 = _mm512_mul_ps(v_z_re, v_z_re);
+        __m512 v_z_im2 = _mm512_mul_ps(v_z_im, v_z_im);
+        __m512 v_mag2 = _mm512_add_ps(v_z_re2, v_z_im2);
+
+        __mmask16 active = _mm512_mask_cmp_ps_mask(live & ~done, v_mag2, v_threshold, _CMP_LE_OQ);
+        __mmask16 finished = live & ~active;
+
+        if (!active || __builtin_popcount(finished) >= REFILL_MIN_LANES(16)) {
+            // As lanes resolvidas antes do fim recebem o limite, como em AVX512LanesF32
+            saved += _mm512_mask_reduce_add_epi32(finished & done, _mm512_sub_epi32(v_max, v_iterations));
+            _mm512_mask_i32scatter_epi32(block, finished, v_pixel, _mm512_mask_mov_epi32(v_iterations, done, v_max), 4);
+            live &= ~finished;
+
+            __mmask16 empty = (__mmask16)~live;
+            while (empty && y < y1) {
+                // Até 16 candidatos seguidos da linha atual da fila
+                i32 row_left = x1 - x;
+                __mmask16 valid = (row_left >= 16) ? 0xFFFF : (__mmask16)((1u << row_left) - 1);
+                __m512i v_x = _mm512_add_epi32(_mm512_set1_epi32(x), v_lane_index);
+                __m512 v_cand_re = _mm512_add_ps(v_start_x, _mm512_mul_ps(_mm512_cvtepi32_ps(v_x), v_zoom));
+                __m512 v_cand_im = _mm512_set1_ps(start_y + y * zoom);
+
+                __m512 v_c_im2 = _mm512_mul_ps(v_cand_im, v_cand_im);
+                __m512 v_xq = _mm512_sub_ps(v_cand_re, v_quarter);
+                __m512 v_q = _mm512_add_ps(_mm512_mul_ps(v_xq, v_xq), v_c_im2);
+                __mmask16 in_cardioid = _mm512_mask_cmp_ps_mask(valid, _mm512_mul_ps(v_q, _mm512_add_ps(v_q, v_xq)),
+                                                                _mm512_mul_ps(v_quarter, v_c_im2), _CMP_LE_OQ);
+                __m512 v_x1 = _mm512_add_ps(v_cand_re, v_one);
+                __mmask16 in_bulb = _mm512_mask_cmp_ps_mask(valid, _mm512_add_ps(_mm512_mul_ps(v_x1, v_x1), v_c_im2),
+                                                            v_sixteenth, _CMP_LE_OQ);
+                __mmask16 interior = in_cardioid | in_bulb;
+                __mmask16 pending = valid & ~interior;
+
+                // Com mais candidatos que lanes livres, a fila só anda até o último que coube
+                int free_lanes = __builtin_popcount(empty);
+                if (__builtin_popcount(pending) > free_lanes) {
+                    u32 bits = pending;
+                    for (int k = 1; k < free_lanes; ++k) bits &= bits - 1;
+                    __mmask16 consumed = (__mmask16)((2u << __builtin_ctz(bits)) - 1);
+                    valid &= consumed;
+                    pending &= consumed;
+                    interior &= consumed;
+                }
+
+                i32 row_offset = (y - y0) * stride;
+                _mm512_mask_storeu_epi32(block + row_offset + x, interior, v_max);
+                saved += (i64)__builtin_popcount(interior) * max_iterations;
+
+                __mmask16 lanes = (__mmask16)LowestBits(empty, __builtin_popcount(pending));
+                v_c_re = _mm512_mask_expand_ps(v_c_re, lanes, _mm512_maskz_compress_ps(pending, v_cand_re));
+                v_c_im = _mm512_mask_mov_ps(v_c_im, lanes, v_cand_im);
+                v_pixel = _mm512_mask_expand_epi32(v_pixel, lanes,
+                                                   _mm512_maskz_compress_epi32(pending, _mm512_add_epi32(v_x, _mm512_set1_epi32(row_offset))));
+                v_z_re = _mm512_maskz_mov_ps((__mmask16)~lanes, v_z_re);
+                v_z_im = _mm512_maskz_mov_ps((__mmask16)~lanes, v_z_im);
+                v_old_re = _mm512_maskz_mov_ps((__mmask16)~lanes, v_old_re);
+                v_old_im = _mm512_maskz_mov_ps((__mmask16)~lanes, v_old_im);
+                v_iterations = _mm512_maskz_mov_epi32((__mmask16)~lanes, v_iterations);
+                v_next_save = _mm512_mask_mov_epi32(v_next_save, lanes, v_one_i);
+                v_next_event = _mm512_mask_mov_epi32(v_next_event, lanes, v_one_i);
+                done &= ~lanes;
+                live |= lanes;
+                empty &= ~lanes;
+
+                x += __builtin_popcount(valid);
+                if (x == x1) {
+                    x = x0;
+                    ++y;
+                }
+            }
+
+            if (!live) break;
+            continue;
+        }
+
+        v_iterations = _mm512_mask_add_epi32(v_iterations, active, v_iterations, v_one_i);
+
+        __m512 v_new_re = _mm512_add_ps(_mm512_sub_ps(v_z_re2, v_z_im2), v_c_re);
+        __m512 v_new_im = _mm512_add_ps(_mm512_mul_ps(v_two, _mm512_mul_ps(v_z_re, v_z_im)), v_c_im);
+
+        v_z_re = _mm512_mask_mov_ps(v_z_re, active, v_new_re);
+        v_z_im = _mm512_mask_mov_ps(v_z_im, active, v_new_im);
+
+        __mmask16 near_re = _mm512_mask_cmp_ps_mask(active, _mm512_abs_ps(_mm512_sub_ps(v_z_re, v_old_re)), v_epsilon, _CMP_LE_OQ);
+        __mmask16 near_im = _mm512_mask_cmp_ps_mask(near_re, _mm512_abs_ps(_mm512_sub_ps(v_z_im, v_old_im)), v_epsilon, _CMP_LE_OQ);
+        done |= near_im;
+
+        __mmask16 event = _mm512_mask_cmpeq_epi32_mask(active, v_iterations, v_next_event);
+        if (event) {
+            __mmask16 save = _mm512_mask_cmpeq_epi32_mask(event, v_iterations, v_next_save);
+            v_old_re = _mm512_mask_mov_ps(v_old_re, save, v_z_re);
+            v_old_im = _mm512_mask_mov_ps(v_old_im, save, v_z_im);
+            v_next_save = _mm512_mask_add_epi32(v_next_save, save, v_next_save, v_next_save);
+            v_next_event = _mm512_min_epi32(v_next_save, v_max);
+            done |= _mm512_mask_cmpeq_epi32_mask(event, v_iterations, v_max);
+        }
+    }
+
+    return saved;
+}
+
+// O mesmo com 8 pixels f64 e contadores de 64 bits, como em AVX512LanesF64; as posições também são de 64 bits
+static i64 AVX512BlockF64(i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1,
+                          f64 start_x, f64 start_y, f64 zoom, i32 max_iterations)
+{
+    const __m512d v_threshold = _mm512_set1_pd(4.0);
+    const __m512d v_two = _mm512_set1_pd(2.0);
+    const __m512d v_quarter = _mm512_set1_pd(0.25);
+    const __m512d v_one = _mm512_set1_pd(1.0);
+    const __m512d v_sixteenth = _mm512_set1_pd(1.0 / 16.0);
+    const __m512d v_epsilon = _mm512_set1_pd(PERIODICITY_EPSILON_F64);
+    const __m512d v_zoom = _mm512_set1_pd(zoom);
+    const __m512d v_start_x = _mm512_set1_pd(start_x);
+    const __m512d v_lane_offset = _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m512i v_lane_index = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m512i v_one_i = _mm512_set1_epi64(1);
+    const __m512i v_max = _mm512_set1_epi64(max_iterations);
+
+    i32 x = x0, y = (x0 < x1) ? y0 : y1;
+
+    __m512d v_c_re = _mm512_setzero_pd();
+    __m512d v_c_im = _mm512_setzero_pd();
+    __m512d v_z_re = _mm512_setzero_pd();
+    __m512d v_z_im = _mm512_setzero_pd();
+    __m512d v_old_re = v_z_re;
+    __m512d v_old_im = v_z_im;
+    __m512i v_iterations = _mm512_setzero_si512();
+    __m512i v_next_save = v_one_i;
+    __m512i v_next_event = v_one_i;
+    __m512i v_pixel = _mm512_setzero_si512();
+    __mmask8 live = 0, done = 0;
+    i64 saved = 0;
+
+    for (;;)
+    {
+        __m512d v_z_re2 = _mm512_mul_pd(v_z_re, v_z_re);
+        __m512d v_z_im2 = _mm512_mul_pd(v_z_im, v_z_im);
+        __m512d v_mag2 = _mm512_add_pd(v_z_re2, v_z_im2);
+
+        __mmask8 active = _mm512_mask_cmp_pd_mask(live & ~done, v_mag2, v_threshold, _CMP_LE_OQ);
+        __mmask8 finished = live & ~active;
+
+        if (!active || __builtin_popcount(finished) >= REFILL_MIN_LANES(8)) {
+            saved += _mm512_mask_reduce_add_epi64(finished & done, _mm512_sub_epi64(v_max, v_iterations));
+            _mm512_mask_i64scatter_epi32(iterations, finished, v_pixel,
+                                         _mm512_cvtepi64_epi32(_mm512_mask_mov_epi64(v_iterations, done, v_max)), 4);
+            live &= ~finished;
+
+            __mmask8 empty = (__mmask8)~live;
+            while (empty && y < y1) {
+                i32 row_left = x1 - x;
+                __mmask8 valid = (row_left >= 8) ? 0xFF : (__mmask8)((1u << row_left) - 1);
+                __m512d v_cand_re = _mm512_add_pd(v_start_x, _mm512_mul_pd(_mm512_add_pd(_mm512_set1_pd((f64)x), v_lane_offset), v_zoom));
+                __m512d v_cand_im = _mm512_set1_pd(start_y + y * zoom);
+
+                __m512d v_c_im2 = _mm512_mul_pd(v_cand_im, v_cand_im);
+                __m512d v_xq = _mm512_sub_pd(v_cand_re, v_quarter);
+                __m512d v_q = _mm512_add_pd(_mm512_mul_pd(v_xq, v_xq), v_c_im2);
+                __mmask8 in_cardioid = _mm512_mask_cmp_pd_mask(valid, _mm512_mul_pd(v_q, _mm512_add_pd(v_q, v_xq)),
+                                                               _mm512_mul_pd(v_quarter, v_c_im2), _CMP_LE_OQ);
+                __m512d v_x1 = _mm512_add_pd(v_cand_re, v_one);
+                __mmask8 in_bulb = _mm512_mask_cmp_pd_mask(valid, _mm512_add_pd(_mm512_mul_pd(v_x1, v_x1), v_c_im2),
+                                                           v_sixteenth, _CMP_LE_OQ);
+                __mmask8 interior = in_cardioid | in_bulb;
+                __mmask8 pending = valid & ~interior;
+
+                int free_lanes = __builtin_popcount(empty);
+                if (__builtin_popcount(pending) > free_lanes) {
+                    u32 bits = pending;
+                    for (int k = 1; k < free_lanes; ++k) bits &= bits - 1;
+                    __mmask8 consumed = (__mmask8)((2u << __builtin_ctz(bits)) - 1);
+                    valid &= consumed;
+                    pending &= consumed;
+                    interior &= consumed;
+                }
+
+                i64 row_offset = (i64)y * stride;
+                _mm512_mask_cvtepi64_storeu_epi32(iterations + row_offset + x, interior, v_max);
+                saved += (i64)__builtin_popcount(interior) * max_iterations;
+
+                __mmask8 lanes = (__mmask8)LowestBits(empty, __builtin_popcount(pending));
+                __m512i v_cand_pixel = _mm512_add_epi64(_mm512_set1_epi64(row_offset + x), v_lane_index);
+                v_c_re = _mm512_mask_expand_pd(v_c_re, lanes, _mm512_maskz_compress_pd(pending, v_cand_re));
+                v_c_im = _mm512_mask_mov_pd(v_c_im, lanes, v_cand_im);
+                v_pixel = _mm512_mask_expand_epi64(v_pixel, lanes, _mm512_maskz_compress_epi64(pending, v_cand_pixel));
+                v_z_re = _mm512_maskz_mov_pd((__mmask8)~lanes, v_z_re);
+                v_z_im = _mm512_maskz_mov_pd((__mmask8)~lanes, v_z_im);
+                v_old_re = _mm512_maskz_mov_pd((__mmask8)~lanes, v_old_re);
+                v_old_im = _mm512_maskz_mov_pd((__mmask8)~lanes, v_old_im);
+                v_iterations = _mm512_maskz_mov_epi64((__mmask8)~lanes, v_iterations);
+                v_next_save = _mm512_mask_mov_epi64(v_next_save, lanes, v_one_i);
+                v_next_event = _mm512_mask_mov_epi64(v_next_event, lanes, v_one_i);
+                done &= ~lanes;
+                live |= lanes;
+                empty &= ~lanes;
+
+                x += __builtin_popcount(valid);
+                if (x == x1) {
+                    x = x0;
+                    ++y;
+                }
+            }
+
+            if (!live) break;
+            continue;
+        }
+
+        v_iterations = _mm512_mask_add_epi64(v_iterations, active, v_iterations, v_one_i);
+
+        __m512d v_new_re = _mm512_add_pd(_mm512_sub_pd(v_z_re2, v_z_im2), v_c_re);
+        __m512d v_new_im = _mm512_add_pd(_mm512_mul_pd(v_two, _mm512_mul_pd(v_z_re, v_z_im)), v_c_im);
+
+        v_z_re = _mm512_mask_mov_pd(v_z_re, active, v_new_re);
+        v_z_im = _mm512_mask_mov_pd(v_z_im, active, v_new_im);
+
+        __mmask8 near_re = _mm512_mask_cmp_pd_mask(active, _mm512_abs_pd(_mm512_sub_pd(v_z_re, v_old_re)), v_epsilon, _CMP_LE_OQ);
+        __mmask8 near_im = _mm512_mask_cmp_pd_mask(near_re, _mm512_abs_pd(_mm512_sub_pd(v_z_im, v_old_im)), v_epsilon, _CMP_LE_OQ);
+        done |= near_im;
+
+        __mmask8 event = _mm512_mask_cmpeq_epi64_mask(active, v_iterations, v_next_event);
+        if (event) {
+            __mmask8 save = _mm512_mask_cmpeq_epi64_mask(event, v_iterations, v_next_save);
+            v_old_re = _mm512_mask_mov_pd(v_old_re, save, v_z_re);
+            v_old_im = _mm512_mask_mov_pd(v_old_im, save, v_z_im);
+            v_next_save = _mm512_mask_add_epi64(v_next_save, save, v_next_save, v_next_save);
+            v_next_event = _mm512_min_epi64(v_next_save, v_max);
+            done |= _mm512_mask_cmpeq_epi64_mask(event, v_iterations, v_max);
+        }
+    }
+
+    return saved;
+}
+
+static void AVX512ColorizeSpan(u32 *pixels, const i32 *iterations, i32 count, const u32 *lut, i32 max_iterations)
+{
+    const __m512i v_max = _mm512_set1_epi32(max_iterations);
+
+    int k = 0;
+    if (count >= COLORIZE_STREAM_MIN_PIXELS && ((uintptr_t)pixels & 63) == 0) {
+        for (; k + 15 < count; k += 16) {
+            __m512i v_index = _mm512_min_epi32(_mm512_loadu_si512(iterations + k), v_max);
+            _mm512_stream_si512((__m512i*)(pixels + k), _mm512_i32gather_epi32(v_index, lut, 4));
+        }
+        _mm_sfence();
+    }
+    for (; k + 15 < count; k += 16) {
+        __m512i v_index = _mm512_min_epi32(_mm512_loadu_si512(iterations + k), v_max);
+        _mm512_storeu_si512(pixels + k, _mm512_i32gather_epi32(v_index, lut, 4));
+    }
+
+    // A sobra vai com máscara em vez de cair no laço escalar
+    if (k < count) {
+        __mmask16 tail = (__mmask16)((1u << (count - k)) - 1);
+        __m512i v_index = _mm512_min_epi32(_mm512_maskz_loadu_epi32(tail, iterations + k), v_max);
+        _mm512_mask_storeu_epi32(pixels + k, tail, _mm512_mask_i32gather_epi32(v_max, tail, v_index, lut, 4));
+    }
+}
+
+const IterationKernel KernelAVX512 = {
+    "avx512",
+    AVX512SpanF32,
+    AVX512SpanF64,
+    AVX512ColumnF32,
+    AVX512ColumnF64,
+    AVX2PerturbLanesF32,
+    AVX2PerturbLanesF64,
+    AVX512ColorizeSpan,
+    AVX512BlockF32,
+    AVX512BlockF64,
+    AVX2SpanDD,
+    AVX2ColumnDD,
+};
@@ -0,0 +1,525 @@
+#include "platform.h"
+#include "kernels.h"
+
+#include <immintrin.h> // AVX2 + FMA
+
+/*
+Kernel FMA: AVX2 com z^2 + c em multiplicações-adições fundidas e FMA_GROUPS grupos
+de pixels (8 f32 ou 4 f64 cada) iterando juntos no mesmo laço. Um grupo sozinho é
+uma cadeia de dependências de duas FMAs por iteração, e o núcleo passa a maior parte
+do tempo esperando a latência delas; com vários grupos intercalados sempre há uma
+conta independente pronta para despachar.
+
+O teste de escape sai do laço: os grupos andam FMA_CHECK_INTERVAL iterações sem
+olhar para |z| e só no fim do pedaço o teste é feito. Fora do círculo de raio 2
+(e com |z| >= |c|) o módulo só cresce, então um pixel que escapou no meio do pedaço
+continua fora no fim, ou virou inf/NaN, que o teste também pega. O grupo então volta
+ao z do início do pedaço e refaz essas iterações testando a cada passo, o que dá a
+contagem exata. A periodicidade também só é conferida no fim dos pedaços, com os
+pontos guardados nas potências de 2 a partir de FMA_CHECK_INTERVAL.
+
+A FMA arredonda uma vez onde mul + add arredondam duas, então perto da fronteira as
+contagens diferem um pouco das dos outros kernels. Por isso este kernel fica fora da
+escolha automática: só entra com -k fma ou MANDELBROT_KERNEL=fma.
+*/
+
+#define FMA_GROUPS 4
+#define FMA_CHECK_INTERVAL 8
+
+/*
+Pixels de um trecho ou de uma coluna: o pixel p tem coordenada coord0 + p * coord_step
+no eixo que varia (c = start + coordenada * zoom, a mesma conta dos outros kernels),
+'fixed' no outro eixo, e a contagem vai para out[p * out_step].
+*/
+typedef struct {
+    __m256 z_re[FMA_GROUPS], z_im[FMA_GROUPS];
+    __m256 c_re[FMA_GROUPS], c_im[FMA_GROUPS];
+    __m256 old_re[FMA_GROUPS], old_im[FMA_GROUPS];
+    __m256 done[FMA_GROUPS];
+    __m256i counts[FMA_GROUPS];
+    i32 iteration[FMA_GROUPS], next_save[FMA_GROUPS];
+    i32 first[FMA_GROUPS], lanes[FMA_GROUPS]; // Primeiro pixel do grupo e quantos ele tem; 0 = grupo vazio
+
+    i32 *out;
+    i32 out_step;
+    i32 count, next;
+    i32 coord0, coord_step;
+    f32 start, zoom, fixed;
+    b32 is_column;
+    i32 max_iterations;
+    i64 saved;
+} FMAStateF32;
+
+static inline void FMAStepF32(__m256 *z_re, __m256 *z_im, __m256 c_re, __m256 c_im)
+{
+    __m256 re = *z_re;
+    *z_re = _mm256_fmadd_ps(re, re, _mm256_fnmadd_ps(*z_im, *z_im, c_re));
+    *z_im = _mm256_fmadd_ps(_mm256_add_ps(re, re), *z_im, c_im);
+}
+
+// Lanes ainda não resolvidas com |z|^2 > 4; NaN também conta como escape
+static inline __m256 FMAEscapedF32(__m256 z_re, __m256 z_im, __m256 done)
+{
+    __m256 v_mag2 = _mm256_fmadd_ps(z_re, z_re, _mm256_mul_ps(z_im, z_im));
+    return _mm256_andnot_ps(done, _mm256_cmp_ps(v_mag2, _mm256_set1_ps(4.0f), _CMP_NLE_UQ));
+}
+
+// Anda 'steps' iterações do grupo g testando o escape a cada uma, e mais o teste da seguinte
+static void FMACheckedF32(FMAStateF32 *s, int g, int steps)
+{
+    __m256 v_z_re = s->z_re[g], v_z_im = s->z_im[g];
+    __m256 v_done = s->done[g];
+    __m256i v_counts = s->counts[g];
+    i32 iteration = s->iteration[g];
+
+    for (int t = 0; iteration < s->max_iterations; ++t) {
+        __m256 v_escaped = FMAEscapedF32(v_z_re, v_z_im, v_done);
+        v_counts = _mm256_blendv_epi8(v_counts, _mm256_set1_epi32(iteration), _mm256_castps_si256(v_escaped));
+        v_done = _mm256_or_ps(v_done, v_escaped);
+        if (t == steps) break;
+        FMAStepF32(&v_z_re, &v_z_im, s->c_re[g], s->c_im[g]);
+        ++iteration;
+    }
+
+    s->z_re[g] = v_z_re;
+    s->z_im[g] = v_z_im;
+    s->done[g] = v_done;
+    s->counts[g] = v_counts;
+    s->iteration[g] = iteration;
+}
+
+// Põe os próximos pixels no grupo g; sem pixels na fila o grupo fica vazio
+static void FMALoadGroupF32(FMAStateF32 *s, int g)
+{
+    const __m256 v_quarter = _mm256_set1_ps(0.25f);
+    const __m256 v_one = _mm256_set1_ps(1.0f);
+    const __m256 v_sixteenth = _mm256_set1_ps(1.0f / 16.0f);
+    const __m256i v_lane_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    for (;;) {
+        i32 lanes = s->count - s->next;
+        if (lanes > 8) lanes = 8;
+        if (lanes < 0) lanes = 0;
+
+        __m256i v_coord = _mm256_add_epi32(_mm256_set1_epi32(s->coord0),
+                                           _mm256_mullo_epi32(_mm256_add_epi32(_mm256_set1_epi32(s->next), v_lane_index),
+                                                              _mm256_set1_epi32(s->coord_step)));
+        __m256 v_axis = _mm256_add_ps(_mm256_set1_ps(s->start), _mm256_mul_ps(_mm256_cvtepi32_ps(v_coord), _mm256_set1_ps(s->zoom)));
+        __m256 v_fixed = _mm256_set1_ps(s->fixed);
+        __m256 v_c_re = s->is_column ? v_fixed : v_axis;
+        __m256 v_c_im = s->is_column ? v_axis : v_fixed;
+        __m256 v_valid = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(lanes), v_lane_index));
+
+        // Cardioide e bulbo, como em IterateScalarF32
+        __m256 v_c_im2 = _mm256_mul_ps(v_c_im, v_c_im);
+        __m256 v_xq = _mm256_sub_ps(v_c_re, v_quarter);
+        __m256 v_q = _mm256_add_ps(_mm256_mul_ps(v_xq, v_xq), v_c_im2);
+        __m256 v_in_cardioid = _mm256_cmp_ps(_mm256_mul_ps(v_q, _mm256_add_ps(v_q, v_xq)),
+                                             _mm256_mul_ps(v_quarter, v_c_im2), _CMP_LE_OQ);
+        __m256 v_x1 = _mm256_add_ps(v_c_re, v_one);
+        __m256 v_in_bulb = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(v_x1, v_x1), v_c_im2), v_sixteenth, _CMP_LE_OQ);
+        __m256 v_interior = _mm256_and_ps(v_valid, _mm256_or_ps(v_in_cardioid, v_in_bulb));
+        int interior = _mm256_movemask_ps(v_interior);
+        s->saved += (i64)__builtin_popcount(interior) * s->max_iterations;
+
+        // Grupo inteiro no interior: grava o limite e passa para o próximo sem ocupar o grupo
+        if (lanes && interior == (1 << lanes) - 1) {
+            i32 *out = s->out + (size_t)s->next * s->out_step;
+            if (s->out_step == 1) {
+                _mm256_maskstore_epi32(out, _mm256_castps_si256(v_valid), _mm256_set1_epi32(s->max_iterations));
+            } else {
+                for (int k = 0; k < lanes; ++k) out[(size_t)k * s->out_step] = s->max_iterations;
+            }
+            s->next += lanes;
+            continue;
+        }
+
+        s->z_re[g] = s->z_im[g] = s->old_re[g] = s->old_im[g] = _mm256_setzero_ps();
+        s->c_re[g] = lanes ? v_c_re : _mm256_setzero_ps();
+        s->c_im[g] = lanes ? v_c_im : _mm256_setzero_ps();
+        s->done[g] = _mm256_or_ps(v_interior, _mm256_andnot_ps(v_valid, _mm256_castsi256_ps(_mm256_set1_epi32(-1))));
+        s->counts[g] = _mm256_and_si256(_mm256_castps_si256(v_interior), _mm256_set1_epi32(s->max_iterations));
+        s->iteration[g] = 0;
+        s->next_save[g] = FMA_CHECK_INTERVAL;
+        s->first[g] = s->next;
+        s->lanes[g] = lanes;
+        s->next += lanes;
+        return;
+    }
+}
+
+// Grava as contagens do grupo g; quem não escapou nem foi resolvido chegou ao limite
+static void FMAStoreGroupF32(FMAStateF32 *s, int g)
+{
+    const __m256i v_lane_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i v_counts = _mm256_blendv_epi8(_mm256_set1_epi32(s->max_iterations), s->counts[g], _mm256_castps_si256(s->done[g]));
+    i32 *out = s->out + (size_t)s->first[g] * s->out_step;
+
+    if (s->out_step == 1) {
+        _mm256_maskstore_epi32(out, _mm256_cmpgt_epi32(_mm256_set1_epi32(s->lanes[g]), v_lane_index), v_counts);
+    } else {
+        i32 counts[8] __attribute__((aligned(32)));
+        _mm256_store_si256((__m256i*)counts, v_counts);
+        for (int k = 0; k < s->lanes[g]; ++k) out[(size_t)k * s->out_step] = counts[k];
+    }
+}
+
+// Troca o grupo g enquanto ele estiver resolvido ou perto demais do limite para um pedaço inteiro
+static void FMASettleGroupF32(FMAStateF32 *s, int g)
+{
+    while (s->lanes[g]) {
+        if (_mm256_movemask_ps(s->done[g]) != 0xFF) {
+            i32 remaining = s->max_iterations - s->iteration[g];
+            if (remaining >= FMA_CHECK_INTERVAL) return;
+            FMACheckedF32(s, g, remaining);
+        }
+        FMAStoreGroupF32(s, g);
+        FMALoadGroupF32(s, g);
+    }
+}
+
+static i64 FMAIteratePixelsF32(FMAStateF32 *s)
+{
+    const __m256 v_epsilon = _mm256_set1_ps(PERIODICITY_EPSILON_F32);
+    const __m256 v_abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+
+    int live = 0;
+    for (int g = 0; g < FMA_GROUPS; ++g) {
+        FMALoadGroupF32(s, g);
+        FMASettleGroupF32(s, g);
+        if (s->lanes[g]) ++live;
+    }
+
+    while (live)
+    {
+        // Pedaço sem testes: só as FMAs dos grupos intercalados
+        __m256 z_re[FMA_GROUPS], z_im[FMA_GROUPS];
+        #pragma GCC unroll 4
+        for (int g = 0; g < FMA_GROUPS; ++g) {
+            z_re[g] = s->z_re[g];
+            z_im[g] = s->z_im[g];
+        }
+        for (int t = 0; t < FMA_CHECK_INTERVAL; ++t) {
+            #pragma GCC unroll 4
+            for (int g = 0; g < FMA_GROUPS; ++g) FMAStepF32(&z_re[g], &z_im[g], s->c_re[g], s->c_im[g]);
+        }
+
+        live = 0;
+        for (int g = 0; g < FMA_GROUPS; ++g) {
+            if (!s->lanes[g]) continue;
+
+            // Alguém escapou no pedaço: refaz a partir do z do início, que ainda está no estado
+            if (_mm256_movemask_ps(FMAEscapedF32(z_re[g], z_im[g], s->done[g]))) {
+                FMACheckedF32(s, g, FMA_CHECK_INTERVAL);
+            } else {
+                s->z_re[g] = z_re[g];
+                s->z_im[g] = z_im[g];
+                s->iteration[g] += FMA_CHECK_INTERVAL;
+            }
+
+            __m256 v_near_re = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(s->z_re[g], s->old_re[g]), v_abs_mask), v_epsilon, _CMP_LE_OQ);
+            __m256 v_near_im = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(s->z_im[g], s->old_im[g]), v_abs_mask), v_epsilon, _CMP_LE_OQ);
+            __m256 v_periodic = _mm256_andnot_ps(s->done[g], _mm256_and_ps(v_near_re, v_near_im));
+            int periodic = _mm256_movemask_ps(v_periodic);
+            if (periodic) {
+                s->counts[g] = _mm256_blendv_epi8(s->counts[g], _mm256_set1_epi32(s->max_iterations), _mm256_castps_si256(v_periodic));
+                s->done[g] = _mm256_or_ps(s->done[g], v_periodic);
+                s->saved += (i64)__builtin_popcount(periodic) * (s->max_iterations - s->iteration[g]);
+            }
+            if (s->iteration[g] == s->next_save[g]) {
+                s->old_re[g] = s->z_re[g];
+                s->old_im[g] = s->z_im[g];
+                s->next_save[g] *= 2;
+            }
+
+            FMASettleGroupF32(s, g);
+            if (s->lanes[g]) ++live;
+        }
+    }
+
+    return s->saved;
+}
+
+static i64 FMASpanF32(i32 *iterations, i32 x0, i32 x1, i32 step, f32 start_x, f32 c_im, f32 zoom, i32 max_iterations)
+{
+    if (x0 >= x1) return 0;
+    FMAStateF32 s;
+    s.out = iterations + x0;
+    s.out_step = step;
+    s.count = (x1 - x0 + step - 1) / step;
+    s.next = 0;
+    s.coord0 = x0;
+    s.coord_step = step;
+    s.start = start_x;
+    s.zoom = zoom;
+    s.fixed = c_im;
+    s.is_column = 0;
+    s.max_iterations = max_iterations;
+    s.saved = 0;
+    return FMAIteratePixelsF32(&s);
+}
+
+static i64 FMAColumnF32(i32 *iterations, i32 stride, i32 y0, i32 y1, f32 c_re, f32 start_y, f32 zoom, i32 max_iterations)
+{
+    if (y0 >= y1) return 0;
+    FMAStateF32 s;
+    s.out = iterations + (size_t)y0 * stride;
+    s.out_step = stride;
+    s.count = y1 - y0;
+    s.next = 0;
+    s.coord0 = y0;
+    s.coord_step = 1;
+    s.start = start_y;
+    s.zoom = zoom;
+    s.fixed = c_re;
+    s.is_column = 1;
+    s.max_iterations = max_iterations;
+    s.saved = 0;
+    return FMAIteratePixelsF32(&s);
+}
+
+// O mesmo com grupos de 4 pixels f64 e contadores de 64 bits
+typedef struct {
+    __m256d z_re[FMA_GROUPS], z_im[FMA_GROUPS];
+    __m256d c_re[FMA_GROUPS], c_im[FMA_GROUPS];
+    __m256d old_re[FMA_GROUPS], old_im[FMA_GROUPS];
+    __m256d done[FMA_GROUPS];
+    __m256i counts[FMA_GROUPS];
+    i32 iteration[FMA_GROUPS], next_save[FMA_GROUPS];
+    i32 first[FMA_GROUPS], lanes[FMA_GROUPS];
+
+    i32 *out;
+    i32 out_step;
+    i32 count, next;
+    i32 coord0, coord_step;
+    f64 start, zoom, fixed;
+    b32 is_column;
+    i32 max_iterations;
+    i64 saved;
+} FMAStateF64;
+
+static inline void FMAStepF64(__m256d *z_re, __m256d *z_im, __m256d c_re, __m256d c_im)
+{
+    __m256d re = *z_re;
+    *z_re = _mm256_fmadd_pd(re, re, _mm256_fnmadd_pd(*z_im, *z_im, c_re));
+    *z_im = _mm256_fmadd_pd(_mm256_add_pd(re, re), *z_im, c_im);
+}
+
+static inline __m256d FMAEscapedF64(__m256d z_re, __m256d z_im, __m256d done)
+{
+    __m256d v_mag2 = _mm256_fmadd_pd(z_re, z_re, _mm256_mul_pd(z_im, z_im));
+    return _mm256_andnot_pd(done, _mm256_cmp_pd(v_mag2, _mm256_set1_pd(4.0), _CMP_NLE_UQ));
+}
+
+static void FMACheckedF64(FMAStateF64 *s, int g, int steps)
+{
+    __m256d v_z_re = s->z_re[g], v_z_im = s->z_im[g];
+    __m256d v_done = s->done[g];
+    __m256i v_counts = s->counts[g];
+    i32 iteration = s->iteration[g];
+
+    for (int t = 0; iteration < s->max_iterations; ++t) {
+        __m256d v_escaped = FMAEscapedF64(v_z_re, v_z_im, v_done);
+        v_counts = _mm256_blendv_epi8(v_counts, _mm256_set1_epi64x(iteration), _mm256_castpd_si256(v_escaped));
+        v_done = _mm256_or_pd(v_done, v_escaped);
+        if (t == steps) break;
+        FMAStepF64(&v_z_re, &v_z_im, s->c_re[g], s->c_im[g]);
+        ++iteration;
+    }
+
+    s->z_re[g] = v_z_re;
+    s->z_im[g] = v_z_im;
+    s->done[g] = v_done;
+    s->counts[g] = v_counts;
+    s->iteration[g] = iteration;
+}
+
+static void FMALoadGroupF64(FMAStateF64 *s, int g)
+{
+    const __m256d v_quarter = _mm256_set1_pd(0.25);
+    const __m256d v_one = _mm256_set1_pd(1.0);
+    const __m256d v_sixteenth = _mm256_set1_pd(1.0 / 16.0);
+    const __m256d v_lane_index = _mm256_setr_pd(0, 1, 2, 3);
+
+    for (;;) {
+        i32 lanes = s->count - s->next;
+        if (lanes > 4) lanes = 4;
+        if (lanes < 0) lanes = 0;
+
+        // Cada lane calcula start + (coord0 + (next + k) * coord_step) * zoom, exato em f64
+        __m256d v_coord = _mm256_add_pd(_mm256_set1_pd((f64)s->coord0 + (f64)s->next * s->coord_step),
+                                        _mm256_mul_pd(v_lane_index, _mm256_set1_pd((f64)s->coord_step)));
+        __m256d v_axis = _mm256_add_pd(_mm256_set1_pd(s->start), _mm256_mul_pd(v_coord, _mm256_set1_pd(s->zoom)));
+        __m256d v_fixed = _mm256_set1_pd(s->fixed);
+        __m256d v_c_re = s->is_column ? v_fixed : v_axis;
+        __m256d v_c_im = s->is_column ? v_axis : v_fixed;
+        __m256d v_valid = _mm256_cmp_pd(v_lane_index, _mm256_set1_pd((f64)lanes), _CMP_LT_OQ);
+
+        __m256d v_c_im2 = _mm256_mul_pd(v_c_im, v_c_im);
+        __m256d v_xq = _mm256_sub_pd(v_c_re, v_quarter);
+        __m256d v_q = _mm256_add_pd(_mm256_mul_pd(v_xq, v_xq), v_c_im2);
+        __m256d v_in_cardioid = _mm256_cmp_pd(_mm256_mul_pd(v_q, _mm256_add_pd(v_q, v_xq)),
+                                              _mm256_mul_pd(v_quarter, v_c_im2), _CMP_LE_OQ);
+        __m256d v_x1 = _mm256_add_pd(v_c_re, v_one);
+        __m256d v_in_bulb = _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(v_x1, v_x1), v_c_im2), v_sixteenth, _CMP_LE_OQ);
+        __m256d v_interior = _mm256_and_pd(v_valid, _mm256_or_pd(v_in_cardioid, v_in_bulb));
+        int interior = _mm256_movemask_pd(v_interior);
+        s->saved += (i64)__builtin_popcount(interior) * s->max_iterations;
+
+        if (lanes && interior == (1 << lanes) - 1) {
+            i32 *out = s->out + (size_t)s->next * s->out_step;
+            for (int k = 0; k < lanes; ++k) out[(size_t)k * s->out_step] = s->max_iterations;
+            s->next += lanes;
+            continue;
+        }
+
+        s->z_re[g] = s->z_im[g] = s->old_re[g] = s->old_im[g] = _mm256_setzero_pd();
+        s->c_re[g] = lanes ? v_c_re : _mm256_setzero_pd();
+        s->c_im[g] = lanes ? v_c_im : _mm256_setzero_pd();
+        s->done[g] = _mm256_or_pd(v_interior, _mm256_andnot_pd(v_valid, _mm256_castsi256_pd(_mm256_set1_epi64x(-1))));
+        s->counts[g] = _mm256_and_si256(_mm256_castpd_si256(v_interior), _mm256_set1_epi64x(s->max_iterations));
+        s->iteration[g] = 0;
+        s->next_save[g] = FMA_CHECK_INTERVAL;
+        s->first[g] = s->next;
+        s->lanes[g] = lanes;
+        s->next += lanes;
+        return;
+    }
+}
+
+static void FMAStoreGroupF64(FMAStateF64 *s, int g)
+{
+    __m256i v_counts = _mm256_blendv_epi8(_mm256_set1_epi64x(s->max_iterations), s->counts[g], _mm256_castpd_si256(s->done[g]));
+    i32 *out = s->out + (size_t)s->first[g] * s->out_step;
+
+    i64 counts[4] __attribute__((aligned(32)));
+    _mm256_store_si256((__m256i*)counts, v_counts);
+    for (int k = 0; k < s->lanes[g]; ++k) out[(size_t)k * s->out_step] = (i32)counts[k];
+}
+
+static void FMASettleGroupF64(FMAStateF64 *s, int g)
+{
+    while (s->lanes[g]) {
+        if (_mm256_movemask_pd(s->done[g]) != 0xF) {
+            i32 remaining = s->max_iterations - s->iteration[g];
+            if (remaining >= FMA_CHECK_INTERVAL) return;
+            FMACheckedF64(s, g, remaining);
+        }
+        FMAStoreGroupF64(s, g);
+        FMALoadGroupF64(s, g);
+    }
+}
+
+static i64 FMAIteratePixelsF64(FMAStateF64 *s)
+{
+    const __m256d v_epsilon = _mm256_set1_pd(PERIODICITY_EPSILON_F64);
+    const __m256d v_abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+
+    int live = 0;
+    for (int g = 0; g < FMA_GROUPS; ++g) {
+        FMALoadGroupF64(s, g);
+        FMASettleGroupF64(s, g);
+        if (s->lanes[g]) ++live;
+    }
+
+    while (live)
+    {
+        __m256d z_re[FMA_GROUPS], z_im[FMA_GROUPS];
+        #pragma GCC unroll 4
+        for (int g = 0; g < FMA_GROUPS; ++g) {
+            z_re[g] = s->z_re[g];
+            z_im[g] = s->z_im[g];
+        }
+        for (int t = 0; t < FMA_CHECK_INTERVAL; ++t) {
+            #pragma GCC unroll 4
+            for (int g = 0; g < FMA_GROUPS; ++g) FMAStepF64(&z_re[g], &z_im[g], s->c_re[g], s->c_im[g]);
+        }
+
+        live = 0;
+        for (int g = 0; g < FMA_GROUPS; ++g) {
+            if (!s->lanes[g]) continue;
+
+            if (_mm256_movemask_pd(FMAEscapedF64(z_re[g], z_im[g], s->done[g]))) {
+                FMACheckedF64(s, g, FMA_CHECK_INTERVAL);
+            } else {
+                s->z_re[g] = z_re[g];
+                s->z_im[g] = z_im[g];
+                s->iteration[g] += FMA_CHECK_INTERVAL;
+            }
+
+            __m256d v_near_re = _mm256_cmp_pd(_mm256_and_pd(_mm256_sub_pd(s->z_re[g], s->old_re[g]), v_abs_mask), v_epsilon, _CMP_LE_OQ);
+            __m256d v_near_im = _mm256_cmp_pd(_mm256_and_pd(_mm256_sub_pd(s->z_im[g], s->old_im[g]), v_abs_mask), v_epsilon, _CMP_LE_OQ);
+            __m256d v_periodic = _mm256_andnot_pd(s->done[g], _mm256_and_pd(v_near_re, v_near_im));
+            int periodic = _mm256_movemask_pd(v_periodic);
+            if (periodic) {
+                s->counts[g] = _mm256_blendv_epi8(s->counts[g], _mm256_set1_epi64x(s->max_iterations), _mm256_castpd_si256(v_periodic));
+                s->done[g] = _mm256_or_pd(s->done[g], v_periodic);
+                s->saved += (i64)__builtin_popcount(periodic) * (s->max_iterations - s->iteration[g]);
+            }
+            if (s->iteration[g] == s->next_save[g]) {
+                s->old_re[g] = s->z_re[g];
+                s->old_im[g] = s->z_im[g];
+                s->next_save[g] *= 2;
+            }
+
+            FMASettleGroupF64(s, g);
+            if (s->lanes[g]) ++live;
+        }
+    }
+
+    return s->saved;
+}
+
+static i64 FMASpanF64(i32 *iterations, i32 x0, i32 x1, i32 step, f64 start_x, f64 c_im, f64 zoom, i32 max_iterations)
+{
+    if (x0 >= x1) return 0;
+    FMAStateF64 s;
+    s.out = iterations + x0;
+    s.out_step = step;
+    s.count = (x1 - x0 + step - 1) / step;
+    s.next = 0;
+    s.coord0 = x0;
+    s.coord_step = step;
+    s.start = start_x;
+    s.zoom = zoom;
+    s.fixed = c_im;
+    s.is_column = 0;
+    s.max_iterations = max_iterations;
+    s.saved = 0;
+    return FMAIteratePixelsF64(&s);
+}
+
+static i64 FMAColumnF64(i32 *iterations, i32 stride, i32 y0, i32 y1, f64 c_re, f64 start_y, f64 zoom, i32 max_iterations)
+{
+    if (y0 >= y1) return 0;
+    FMAStateF64 s;
+    s.out = iterations + (size_t)y0 * stride;
+    s.out_step = stride;
+    s.count = y1 - y0;
+    s.next = 0;
+    s.coord0 = y0;
+    s.coord_step = 1;
+    s.start = start_y;
+    s.zoom = zoom;
+    s.fixed = c_re;
+    s.is_column = 1;
+    s.max_iterations = max_iterations;
+    s.saved = 0;
+    return FMAIteratePixelsF64(&s);
+}
+
+// Perturbação e coloração são as do AVX2; sem entrada de bloco, os blocos vão linha a linha pelos trechos
+const IterationKernel KernelFMA = {
+    "fma",
+    FMASpanF32,
+    FMASpanF64,
+    FMAColumnF32,
+    FMAColumnF64,
+    AVX2PerturbLanesF32,
+    AVX2PerturbLanesF64,
+    AVX2ColorizeSpan,
+    NULL,
+    NULL,
+    AVX2SpanDD,
+    AVX2ColumnDD,
+};
@@ -0,0 +1,153 @@
+#include "platform.h"
+#include "kernels.h"
+
+/*
+Kernel escalar: roda em qualquer x86-64 (e em qualquer outra arquitetura) e é a
+referência das contas que os kernels vetoriais repetem lane a lane.
+*/
+
+i64 ScalarSpanF32(i32 *iterations, i32 x0, i32 x1, i32 step, f32 start_x, f32 c_im, f32 zoom, i32 max_iterations)
+{
+    i64 saved = 0;
+    for (int x = x0; x < x1; x += step) {
+        iterations[x] = IterateScalarF32(start_x + (f32)x * zoom, c_im, max_iterations, &saved);
+    }
+    return saved;
+}
+
+i64 ScalarSpanF64(i32 *iterations, i32 x0, i32 x1, i32 step, f64 start_x, f64 c_im, f64 zoom, i32 max_iterations)
+{
+    i64 saved = 0;
+    for (int x = x0; x < x1; x += step) {
+        iterations[x] = IterateScalarF64(start_x + (f64)x * zoom, c_im, max_iterations, &saved);
+    }
+    return saved;
+}
+
+i64 ScalarColumnF32(i32 *iterations, i32 stride, i32 y0, i32 y1, f32 c_re, f32 start_y, f32 zoom, i32 max_iterations)
+{
+    i64 saved = 0;
+    for (int y = y0; y < y1; ++y) {
+        iterations[(size_t)y * stride] = IterateScalarF32(c_re, start_y + (f32)y * zoom, max_iterations, &saved);
+    }
+    return saved;
+}
+
+i64 ScalarColumnF64(i32 *iterations, i32 stride, i32 y0, i32 y1, f64 c_re, f64 start_y, f64 zoom, i32 max_iterations)
+{
+    i64 saved = 0;
+    for (int y = y0; y < y1; ++y) {
+        iterations[(size_t)y * stride] = IterateScalarF64(c_re, start_y + (f64)y * zoom, max_iterations, &saved);
+    }
+    return saved;
+}
+
+i64 ScalarSpanDD(i32 *iterations, i32 x0, i32 x1, i32 step, DoubleDouble start_x, DoubleDouble c_im, f64 zoom,
+                 i32 max_iterations)
+{
+    i64 saved = 0;
+    for (int x = x0; x < x1; x += step) {
+        iterations[x] = IterateScalarDD(DDAddF64(start_x, (f64)x * zoom), c_im, max_iterations, &saved);
+    }
+    return saved;
+}
+
+i64 ScalarColumnDD(i32 *iterations, i32 stride, i32 y0, i32 y1, DoubleDouble c_re, DoubleDouble start_y, f64 zoom,
+                   i32 max_iterations)
+{
+    i64 saved = 0;
+    for (int y = y0; y < y1; ++y) {
+        iterations[(size_t)y * stride] = IterateScalarDD(c_re, DDAddF64(start_y, (f64)y * zoom), max_iterations, &saved);
+    }
+    return saved;
+}
+
+// Um pixel por vez, com o mesmo rebase das lanes: |z| < |d| ou a referência acabou
+void ScalarPerturbLanesF32(const ReferenceLanes *ref, const f32 *dc_re, const f32 *dc_im,
+                           const f32 *d_re, const f32 *d_im, i32 skip, i32 max_iterations, i32 *counts)
+{
+    i32 last = ref->length - 1;
+
+    for (int k = 0; k < PERTURB_LANES_F32; ++k) {
+        f32 dr = d_re[k], di = d_im[k];
+        i32 m = skip;
+        i32 iteration = skip;
+        for (; iteration < max_iterations; ++iteration) {
+            f32 zr = ref->z_re32[m], zi = ref->z_im32[m];
+            f32 z_re = zr + dr, z_im = zi + di;
+            f32 z_mag2 = z_re * z_re + z_im * z_im;
+            if (!(z_mag2 <= 4.0f)) break;
+
+            if (z_mag2 < dr * dr + di * di || m == last) {
+                dr = z_re;
+                di = z_im;
+                zr = zi = 0.0f;
+                m = 0;
+            }
+
+            f32 tr = 2.0f * zr + dr, ti = 2.0f * zi + di;
+            f32 nr = (tr * dr - ti * di) + dc_re[k];
+            f32 ni = (tr * di + ti * dr) + dc_im[k];
+            dr = nr;
+            di = ni;
+            ++m;
+        }
+        counts[k] = iteration;
+    }
+}
+
+void ScalarPerturbLanesF64(const ReferenceLanes *ref, const f64 *dc_re, const f64 *dc_im,
+                           const f64 *d_re, const f64 *d_im, i32 skip, i32 max_iterations, i32 *counts)
+{
+    i32 last = ref->length - 1;
+
+    for (int k = 0; k < PERTURB_LANES_F64; ++k) {
+        f64 dr = d_re[k], di = d_im[k];
+        i32 m = skip;
+        i32 iteration = skip;
+        for (; iteration < max_iterations; ++iteration) {
+            f64 zr = ref->z_re[m], zi = ref->z_im[m];
+            f64 z_re = zr + dr, z_im = zi + di;
+            f64 z_mag2 = z_re * z_re + z_im * z_im;
+            if (!(z_mag2 <= 4.0)) break;
+
+            if (z_mag2 < dr * dr + di * di || m == last) {
+                dr = z_re;
+                di = z_im;
+                zr = zi = 0.0;
+                m = 0;
+            }
+
+            f64 tr = 2.0 * zr + dr, ti = 2.0 * zi + di;
+            f64 nr = (tr * dr - ti * di) + dc_re[k];
+            f64 ni = (tr * di + ti * dr) + dc_im[k];
+            dr = nr;
+            di = ni;
+            ++m;
+        }
+        counts[k] = iteration;
+    }
+}
+
+void ScalarColorizeSpan(u32 *pixels, const i32 *iterations, i32 count, const u32 *lut, i32 max_iterations)
+{
+    for (int k = 0; k < count; ++k) {
+        i32 iteration = iterations[k];
+        pixels[k] = lut[iteration < max_iterations ? iteration : max_iterations];
+    }
+}
+
+const IterationKernel KernelScalar = {
+    "scalar",
+    ScalarSpanF32,
+    ScalarSpanF64,
+    ScalarColumnF32,
+    ScalarColumnF64,
+    ScalarPerturbLanesF32,
+    ScalarPerturbLanesF64,
+    ScalarColorizeSpan,
+    NULL,
+    NULL,
+    ScalarSpanDD,
+    ScalarColumnDD,
+};
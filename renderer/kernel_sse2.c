@@ -0,0 +1,284 @@
+#include "platform.h"
+#include "kernels.h"
+
+#include <emmintrin.h> // SSE2
+
+/*
+Kernel SSE2: 4 pixels f32 ou 2 f64 por registrador. É o mínimo de qualquer
+x86-64, então serve de piso para as máquinas sem AVX2. Sem blendv (que é do
+SSE4.1), a seleção por máscara é feita com and/andnot/or. O deep zoom usa a
+perturbação escalar, já que o SSE2 não tem gather.
+*/
+
+static inline __m128 SSE2Select(__m128 a, __m128 b, __m128 mask)
+{
+    return _mm_or_ps(_mm_andnot_ps(mask, a), _mm_and_ps(mask, b));
+}
+
+static inline __m128d SSE2SelectF64(__m128d a, __m128d b, __m128d mask)
+{
+    return _mm_or_pd(_mm_andnot_pd(mask, a), _mm_and_pd(mask, b));
+}
+
+static inline __m128i SSE2SelectInt(__m128i a, __m128i b, __m128i mask)
+{
+    return _mm_or_si128(_mm_andnot_si128(mask, a), _mm_and_si128(mask, b));
+}
+
+// Itera 4 pixels f32; mesmas contas e saídas antecipadas de IterateScalarF32
+static inline __m128i SSE2LanesF32(__m128 v_c_re, __m128 v_c_im, i32 max_iterations, i64 *saved)
+{
+    const __m128 v_threshold = _mm_set1_ps(4.0f);
+    const __m128 v_two = _mm_set1_ps(2.0f);
+    const __m128 v_quarter = _mm_set1_ps(0.25f);
+    const __m128 v_one = _mm_set1_ps(1.0f);
+    const __m128 v_sixteenth = _mm_set1_ps(1.0f / 16.0f);
+    const __m128 v_epsilon = _mm_set1_ps(PERIODICITY_EPSILON_F32);
+    const __m128 v_abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+    __m128 v_c_im2 = _mm_mul_ps(v_c_im, v_c_im);
+    __m128 v_xq = _mm_sub_ps(v_c_re, v_quarter);
+    __m128 v_q = _mm_add_ps(_mm_mul_ps(v_xq, v_xq), v_c_im2);
+    __m128 v_in_cardioid = _mm_cmple_ps(_mm_mul_ps(v_q, _mm_add_ps(v_q, v_xq)), _mm_mul_ps(v_quarter, v_c_im2));
+    __m128 v_x1 = _mm_add_ps(v_c_re, v_one);
+    __m128 v_in_bulb = _mm_cmple_ps(_mm_add_ps(_mm_mul_ps(v_x1, v_x1), v_c_im2), v_sixteenth);
+    __m128 v_done = _mm_or_ps(v_in_cardioid, v_in_bulb);
+
+    __m128 v_z_re = _mm_setzero_ps();
+    __m128 v_z_im = _mm_setzero_ps();
+    __m128 v_old_re = v_z_re;
+    __m128 v_old_im = v_z_im;
+    __m128i v_iterations = _mm_setzero_si128();
+    int next_save = 1;
+
+    for (int i = 0; i < max_iterations; ++i)
+    {
+        __m128 v_z_re2 = _mm_mul_ps(v_z_re, v_z_re);
+        __m128 v_z_im2 = _mm_mul_ps(v_z_im, v_z_im);
+        __m128 v_mag2 = _mm_add_ps(v_z_re2, v_z_im2);
+
+        __m128 v_mask_active = _mm_andnot_ps(v_done, _mm_cmple_ps(v_mag2, v_threshold));
+        if (_mm_movemask_ps(v_mask_active) == 0) break;
+
+        v_iterations = _mm_sub_epi32(v_iterations, _mm_castps_si128(v_mask_active));
+
+        __m128 v_new_re = _mm_add_ps(_mm_sub_ps(v_z_re2, v_z_im2), v_c_re);
+        __m128 v_new_im = _mm_add_ps(_mm_mul_ps(v_two, _mm_mul_ps(v_z_re, v_z_im)), v_c_im);
+
+        v_z_re = SSE2Select(v_z_re, v_new_re, v_mask_active);
+        v_z_im = SSE2Select(v_z_im, v_new_im, v_mask_active);
+
+        __m128 v_near_re = _mm_cmple_ps(_mm_and_ps(_mm_sub_ps(v_z_re, v_old_re), v_abs_mask), v_epsilon);
+        __m128 v_near_im = _mm_cmple_ps(_mm_and_ps(_mm_sub_ps(v_z_im, v_old_im), v_abs_mask), v_epsilon);
+        v_done = _mm_or_ps(v_done, _mm_and_ps(v_mask_active, _mm_and_ps(v_near_re, v_near_im)));
+
+        if (i + 1 == next_save) {
+            v_old_re = v_z_re;
+            v_old_im = v_z_im;
+            next_save *= 2;
+        }
+    }
+
+    i32 counts[4] __attribute__((aligned(16)));
+    _mm_store_si128((__m128i*)counts, v_iterations);
+    int done_bits = _mm_movemask_ps(v_done);
+    for (int k = 0; k < 4; ++k) {
+        if (done_bits & (1 << k)) *saved += max_iterations - counts[k];
+    }
+
+    return SSE2SelectInt(v_iterations, _mm_set1_epi32(max_iterations), _mm_castps_si128(v_done));
+}
+
+static i64 SSE2SpanF32(i32 *iterations, i32 x0, i32 x1, i32 step, f32 start_x, f32 c_im_scalar, f32 zoom, i32 max_iterations)
+{
+    const __m128 v_zoom_x = _mm_set1_ps(zoom);
+    const __m128 v_start_x = _mm_set1_ps(start_x);
+    const __m128i v_lane_offset = _mm_setr_epi32(0, step, 2 * step, 3 * step);
+    const __m128 v_c_im = _mm_set1_ps(c_im_scalar);
+
+    i32 iter_counts[4] __attribute__((aligned(16)));
+    i64 saved = 0;
+
+    int x = x0;
+    for (; x + 3 * step < x1; x += 4 * step)
+    {
+        __m128 v_x = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x), v_lane_offset));
+        __m128 v_c_re = _mm_add_ps(v_start_x, _mm_mul_ps(v_x, v_zoom_x));
+        __m128i v_iterations = SSE2LanesF32(v_c_re, v_c_im, max_iterations, &saved);
+
+        if (step == 1) {
+            _mm_storeu_si128((__m128i*)(iterations + x), v_iterations);
+        } else {
+            _mm_store_si128((__m128i*)iter_counts, v_iterations);
+            for (int k = 0; k < 4; ++k) iterations[x + k * step] = iter_counts[k];
+        }
+    }
+
+    for (; x < x1; x += step)
+    {
+        iterations[x] = IterateScalarF32(start_x + x * zoom, c_im_scalar, max_iterations, &saved);
+    }
+
+    return saved;
+}
+
+static i64 SSE2ColumnF32(i32 *iterations, i32 stride, i32 y0, i32 y1, f32 c_re_scalar, f32 start_y, f32 zoom, i32 max_iterations)
+{
+    const __m128 v_zoom_y = _mm_set1_ps(zoom);
+    const __m128 v_start_y = _mm_set1_ps(start_y);
+    const __m128i v_lane_index = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128 v_c_re = _mm_set1_ps(c_re_scalar);
+
+    i32 iter_counts[4] __attribute__((aligned(16)));
+    i64 saved = 0;
+
+    int y = y0;
+    for (; y + 3 < y1; y += 4)
+    {
+        __m128 v_y = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(y), v_lane_index));
+        __m128 v_c_im = _mm_add_ps(v_start_y, _mm_mul_ps(v_y, v_zoom_y));
+        _mm_store_si128((__m128i*)iter_counts, SSE2LanesF32(v_c_re, v_c_im, max_iterations, &saved));
+        for (int k = 0; k < 4; ++k) iterations[(size_t)(y + k) * stride] = iter_counts[k];
+    }
+
+    for (; y < y1; ++y)
+    {
+        iterations[(size_t)y * stride] = IterateScalarF32(c_re_scalar, start_y + y * zoom, max_iterations, &saved);
+    }
+
+    return saved;
+}
+
+static inline __m128i SSE2LanesF64(__m128d v_c_re, __m128d v_c_im, i32 max_iterations, i64 *saved)
+{
+    const __m128d v_threshold = _mm_set1_pd(4.0);
+    const __m128d v_two = _mm_set1_pd(2.0);
+    const __m128d v_quarter = _mm_set1_pd(0.25);
+    const __m128d v_one = _mm_set1_pd(1.0);
+    const __m128d v_sixteenth = _mm_set1_pd(1.0 / 16.0);
+    const __m128d v_epsilon = _mm_set1_pd(PERIODICITY_EPSILON_F64);
+    const __m128d v_abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+
+    __m128d v_c_im2 = _mm_mul_pd(v_c_im, v_c_im);
+    __m128d v_xq = _mm_sub_pd(v_c_re, v_quarter);
+    __m128d v_q = _mm_add_pd(_mm_mul_pd(v_xq, v_xq), v_c_im2);
+    __m128d v_in_cardioid = _mm_cmple_pd(_mm_mul_pd(v_q, _mm_add_pd(v_q, v_xq)), _mm_mul_pd(v_quarter, v_c_im2));
+    __m128d v_x1 = _mm_add_pd(v_c_re, v_one);
+    __m128d v_in_bulb = _mm_cmple_pd(_mm_add_pd(_mm_mul_pd(v_x1, v_x1), v_c_im2), v_sixteenth);
+    __m128d v_done = _mm_or_pd(v_in_cardioid, v_in_bulb);
+
+    __m128d v_z_re = _mm_setzero_pd();
+    __m128d v_z_im = _mm_setzero_pd();
+    __m128d v_old_re = v_z_re;
+    __m128d v_old_im = v_z_im;
+    __m128i v_iterations = _mm_setzero_si128();
+    int next_save = 1;
+
+    for (int i = 0; i < max_iterations; ++i)
+    {
+        __m128d v_z_re2 = _mm_mul_pd(v_z_re, v_z_re);
+        __m128d v_z_im2 = _mm_mul_pd(v_z_im, v_z_im);
+        __m128d v_mag2 = _mm_add_pd(v_z_re2, v_z_im2);
+
+        __m128d v_mask_active = _mm_andnot_pd(v_done, _mm_cmple_pd(v_mag2, v_threshold));
+        if (_mm_movemask_pd(v_mask_active) == 0) break;
+
+        v_iterations = _mm_sub_epi64(v_iterations, _mm_castpd_si128(v_mask_active));
+
+        __m128d v_new_re = _mm_add_pd(_mm_sub_pd(v_z_re2, v_z_im2), v_c_re);
+        __m128d v_new_im = _mm_add_pd(_mm_mul_pd(v_two, _mm_mul_pd(v_z_re, v_z_im)), v_c_im);
+
+        v_z_re = SSE2SelectF64(v_z_re, v_new_re, v_mask_active);
+        v_z_im = SSE2SelectF64(v_z_im, v_new_im, v_mask_active);
+
+        __m128d v_near_re = _mm_cmple_pd(_mm_and_pd(_mm_sub_pd(v_z_re, v_old_re), v_abs_mask), v_epsilon);
+        __m128d v_near_im = _mm_cmple_pd(_mm_and_pd(_mm_sub_pd(v_z_im, v_old_im), v_abs_mask), v_epsilon);
+        v_done = _mm_or_pd(v_done, _mm_and_pd(v_mask_active, _mm_and_pd(v_near_re, v_near_im)));
+
+        if (i + 1 == next_save) {
+            v_old_re = v_z_re;
+            v_old_im = v_z_im;
+            next_save *= 2;
+        }
+    }
+
+    i64 counts[2] __attribute__((aligned(16)));
+    _mm_store_si128((__m128i*)counts, v_iterations);
+    int done_bits = _mm_movemask_pd(v_done);
+    for (int k = 0; k < 2; ++k) {
+        if (done_bits & (1 << k)) *saved += max_iterations - counts[k];
+    }
+
+    return SSE2SelectInt(v_iterations, _mm_set1_epi64x(max_iterations), _mm_castpd_si128(v_done));
+}
+
+static i64 SSE2SpanF64(i32 *iterations, i32 x0, i32 x1, i32 step, f64 start_x, f64 c_im_scalar, f64 zoom, i32 max_iterations)
+{
+    const __m128d v_lane_offset = _mm_setr_pd(0, step);
+    const __m128d v_zoom = _mm_set1_pd(zoom);
+    const __m128d v_start_x = _mm_set1_pd(start_x);
+    const __m128d v_c_im = _mm_set1_pd(c_im_scalar);
+
+    i64 iter_counts[2] __attribute__((aligned(16)));
+    i64 saved = 0;
+
+    int x = x0;
+    for (; x + step < x1; x += 2 * step)
+    {
+        __m128d v_x = _mm_add_pd(_mm_set1_pd((f64)x), v_lane_offset);
+        __m128d v_c_re = _mm_add_pd(v_start_x, _mm_mul_pd(v_x, v_zoom));
+
+        _mm_store_si128((__m128i*)iter_counts, SSE2LanesF64(v_c_re, v_c_im, max_iterations, &saved));
+        for (int k = 0; k < 2; ++k) iterations[x + k * step] = (i32)iter_counts[k];
+    }
+
+    for (; x < x1; x += step)
+    {
+        iterations[x] = IterateScalarF64(start_x + x * zoom, c_im_scalar, max_iterations, &saved);
+    }
+
+    return saved;
+}
+
+static i64 SSE2ColumnF64(i32 *iterations, i32 stride, i32 y0, i32 y1, f64 c_re_scalar, f64 start_y, f64 zoom, i32 max_iterations)
+{
+    const __m128d v_lane_index = _mm_setr_pd(0, 1);
+    const __m128d v_zoom = _mm_set1_pd(zoom);
+    const __m128d v_start_y = _mm_set1_pd(start_y);
+    const __m128d v_c_re = _mm_set1_pd(c_re_scalar);
+
+    i64 iter_counts[2] __attribute__((aligned(16)));
+    i64 saved = 0;
+
+    int y = y0;
+    for (; y + 1 < y1; y += 2)
+    {
+        __m128d v_y = _mm_add_pd(_mm_set1_pd((f64)y), v_lane_index);
+        __m128d v_c_im = _mm_add_pd(v_start_y, _mm_mul_pd(v_y, v_zoom));
+
+        _mm_store_si128((__m128i*)iter_counts, SSE2LanesF64(v_c_re, v_c_im, max_iterations, &saved));
+        for (int k = 0; k < 2; ++k) iterations[(size_t)(y + k) * stride] = (i32)iter_counts[k];
+    }
+
+    for (; y < y1; ++y)
+    {
+        iterations[(size_t)y * stride] = IterateScalarF64(c_re_scalar, start_y + y * zoom, max_iterations, &saved);
+    }
+
+    return saved;
+}
+
+const IterationKernel KernelSSE2 = {
+    "sse2",
+    SSE2SpanF32,
+    SSE2SpanF64,
+    SSE2ColumnF32,
+    SSE2ColumnF64,
+    ScalarPerturbLanesF32,
+    ScalarPerturbLanesF64,
+    ScalarColorizeSpan, // Sem gather no SSE2; a consulta à tabela continua escalar
+    NULL,
+    NULL,
+    ScalarSpanDD, // Sem FMA, o TwoProd de Dekker em 2 lanes mal ganharia do escalar
+    ScalarColumnDD,
+};
@@ -0,0 +1,181 @@
+#include "platform.h"
+#include "mandelbrot.h"
+#include "kernels.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+/*
+Escolha do kernel em tempo de execução. Este arquivo é compilado sem flags de ISA,
+então só chama código AVX2/AVX-512 depois de confirmar com cpuid (via
+__builtin_cpu_supports, que também confere se o sistema salva os registradores
+largos) que a CPU aguenta.
+*/
+
+// Do mais rápido para o mais lento; o escalar sempre serve
+static const IterationKernel *const Kernels[] = {
+    &KernelAVX512,
+    &KernelAVX2,
+    &KernelSSE2,
+    &KernelScalar,
+    &KernelFMA,
+};
+
+/*
+Um contador de iterações economizadas por thread, cada um na sua linha de cache:
+com blocos de 64 pixels um contador único seria disputado por todos os núcleos.
+*/
+#define SAVED_ITERATIONS_SLOTS 64
+
+typedef struct {
+    _Alignas(64) i64 value;
+} SavedIterationsSlot;
+
+static const IterationKernel *ActiveKernel;
+static b32 IsLaneRefillEnabled = 1;
+static SavedIterationsSlot SavedIterations[SAVED_ITERATIONS_SLOTS];
+
+static b32 IsKernelSupported(const IterationKernel *kernel)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (kernel == &KernelAVX512) {
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }
+    if (kernel == &KernelAVX2 || kernel == &KernelFMA) return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (kernel == &KernelSSE2) return __builtin_cpu_supports("sse2");
+#endif
+    return kernel == &KernelScalar;
+}
+
+b32 SelectIterationKernel(const char *name)
+{
+    b32 is_auto = (!name || !*name || strcmp(name, "auto") == 0);
+
+    for (size_t i = 0; i < sizeof(Kernels) / sizeof(Kernels[0]); ++i) {
+        const IterationKernel *kernel = Kernels[i];
+        if (!is_auto && strcmp(name, kernel->name) != 0) continue;
+        // O FMA não dá as mesmas contagens bit a bit que os outros; só entra pedido pelo nome
+        if (is_auto && kernel == &KernelFMA) continue;
+        if (!IsKernelSupported(kernel)) {
+            if (is_auto) continue;
+            return 0;
+        }
+        ActiveKernel = kernel;
+        return 1;
+    }
+    return 0;
+}
+
+const IterationKernel *GetIterationKernel(void)
+{
+    if (!ActiveKernel) {
+        #pragma omp critical (IterationKernelSelect)
+        if (!ActiveKernel) {
+            // Para comparar kernels ou contornar uma CPU problemática sem recompilar
+            const char *requested = getenv("MANDELBROT_KERNEL");
+            if (!SelectIterationKernel(requested)) {
+                fprintf(stderr, "MANDELBROT_KERNEL=%s não existe ou não é suportado por esta CPU; usando o automático\n",
+                        requested);
+                SelectIterationKernel(NULL);
+            }
+        }
+    }
+    return ActiveKernel;
+}
+
+const char *GetIterationKernelName(void)
+{
+    return GetIterationKernel()->name;
+}
+
+static inline void CountSavedIterations(i64 saved)
+{
+    if (!saved) return;
+    i64 *slot = &SavedIterations[omp_get_thread_num() % SAVED_ITERATIONS_SLOTS].value;
+    #pragma omp atomic
+    *slot += saved;
+}
+
+void IterateSpanF32(i32 *iterations, i32 x0, i32 x1, i32 step, f32 start_x, f32 c_im, f32 zoom, i32 max_iterations)
+{
+    CountSavedIterations(GetIterationKernel()->span_f32(iterations, x0, x1, step, start_x, c_im, zoom, max_iterations));
+}
+
+void IterateSpanF64(i32 *iterations, i32 x0, i32 x1, i32 step, f64 start_x, f64 c_im, f64 zoom, i32 max_iterations)
+{
+    CountSavedIterations(GetIterationKernel()->span_f64(iterations, x0, x1, step, start_x, c_im, zoom, max_iterations));
+}
+
+void IterateColumnF32(i32 *iterations, i32 stride, i32 y0, i32 y1, f32 c_re, f32 start_y, f32 zoom, i32 max_iterations)
+{
+    CountSavedIterations(GetIterationKernel()->column_f32(iterations, stride, y0, y1, c_re, start_y, zoom, max_iterations));
+}
+
+void IterateColumnF64(i32 *iterations, i32 stride, i32 y0, i32 y1, f64 c_re, f64 start_y, f64 zoom, i32 max_iterations)
+{
+    CountSavedIterations(GetIterationKernel()->column_f64(iterations, stride, y0, y1, c_re, start_y, zoom, max_iterations));
+}
+
+void IterateSpanDD(i32 *iterations, i32 x0, i32 x1, i32 step, DoubleDouble start_x, DoubleDouble c_im, f64 zoom,
+                   i32 max_iterations)
+{
+    CountSavedIterations(GetIterationKernel()->span_dd(iterations, x0, x1, step, start_x, c_im, zoom, max_iterations));
+}
+
+void IterateColumnDD(i32 *iterations, i32 stride, i32 y0, i32 y1, DoubleDouble c_re, DoubleDouble start_y, f64 zoom,
+                     i32 max_iterations)
+{
+    CountSavedIterations(GetIterationKernel()->column_dd(iterations, stride, y0, y1, c_re, start_y, zoom, max_iterations));
+}
+
+void SetLaneRefill(b32 enabled)
+{
+    IsLaneRefillEnabled = enabled;
+}
+
+b32 IsLaneRefillActive(void)
+{
+    return IsLaneRefillEnabled && GetIterationKernel()->block_f32 != NULL;
+}
+
+// Sem recarga de lanes (desligada ou kernel sem a entrada) o bloco vai linha a linha pelos trechos
+void IterateBlockF32(i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1,
+                     f32 start_x, f32 start_y, f32 zoom, i32 max_iterations)
+{
+    const IterationKernel *kernel = GetIterationKernel();
+    if (IsLaneRefillEnabled && kernel->block_f32 && max_iterations > 0) {
+        CountSavedIterations(kernel->block_f32(iterations, stride, x0, y0, x1, y1, start_x, start_y, zoom, max_iterations));
+        return;
+    }
+    for (int y = y0; y < y1; ++y) {
+        IterateSpanF32(iterations + (size_t)y * stride, x0, x1, 1, start_x, start_y + y * zoom, zoom, max_iterations);
+    }
+}
+
+void IterateBlockF64(i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1,
+                     f64 start_x, f64 start_y, f64 zoom, i32 max_iterations)
+{
+    const IterationKernel *kernel = GetIterationKernel();
+    if (IsLaneRefillEnabled && kernel->block_f64 && max_iterations > 0) {
+        CountSavedIterations(kernel->block_f64(iterations, stride, x0, y0, x1, y1, start_x, start_y, zoom, max_iterations));
+        return;
+    }
+    for (int y = y0; y < y1; ++y) {
+        IterateSpanF64(iterations + (size_t)y * stride, x0, x1, 1, start_x, start_y + y * zoom, zoom, max_iterations);
+    }
+}
+
+void ResetSavedIterations(void)
+{
+    for (int i = 0; i < SAVED_ITERATIONS_SLOTS; ++i) SavedIterations[i].value = 0;
+}
+
+i64 GetSavedIterations(void)
+{
+    i64 total = 0;
+    for (int i = 0; i < SAVED_ITERATIONS_SLOTS; ++i) total += SavedIterations[i].value;
+    return total;
+}
@@ -0,0 +1,174 @@
+#include "platform.h"
+#include "mandelbrot.h"
+#include "profiler.h"
+
+#include <stdlib.h>
+#include <omp.h>
+
+/*
+Subdivisão de Mariani-Silver.
+
+O conjunto de Mandelbrot é conexo e as faixas de mesma contagem de iterações
+não têm "ilhas" dentro delas; então, se todos os pixels da borda de um
+retângulo têm a mesma contagem, o interior também tem e pode ser preenchido sem
+iterar. Caso contrário o retângulo é dividido em quatro pela linha e coluna do
+meio (que passam a ser borda dos filhos) e cada filho é tratado do mesmo jeito.
+
+Os retângulos aqui têm bordas inclusivas: [x0, x1] x [y0, y1], com a borda já
+calculada quando o retângulo é processado.
+*/
+
+// Tamanho dos blocos da grade inicial; cada bloco vira uma tarefa independente
+#define SUBDIVISION_BLOCK_SIZE 64
+
+// Retângulos com interior menor que isso são calculados direto, já que a borda custaria quase o mesmo
+#define SUBDIVISION_MIN_INTERIOR 6
+
+// Abaixo dessa área os filhos são processados na própria tarefa, sem criar outras
+#define SUBDIVISION_TASK_MIN_AREA (32 * 32)
+
+static SubdivisionStats LastSubdivisionStats;
+
+static void CountPixels(i64 computed, i64 filled)
+{
+    #pragma omp atomic
+    LastSubdivisionStats.computed_pixels += computed;
+    #pragma omp atomic
+    LastSubdivisionStats.filled_pixels += filled;
+}
+
+static b32 IsBorderUniform(const i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1)
+{
+    const i32 *top = iterations + (size_t)y0 * stride;
+    const i32 *bottom = iterations + (size_t)y1 * stride;
+    i32 value = top[x0];
+
+    for (int x = x0; x <= x1; ++x) {
+        if (top[x] != value || bottom[x] != value) return 0;
+    }
+    for (int y = y0 + 1; y < y1; ++y) {
+        const i32 *row = iterations + (size_t)y * stride;
+        if (row[x0] != value || row[x1] != value) return 0;
+    }
+    return 1;
+}
+
+static void SubdivideRect(const FrameSetup *frame, i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1)
+{
+    i32 inner_w = x1 - x0 - 1;
+    i32 inner_h = y1 - y0 - 1;
+    if (inner_w <= 0 || inner_h <= 0 || IsRenderCancelled()) return;
+
+    if (IsBorderUniform(iterations, stride, x0, y0, x1, y1)) {
+        i32 value = iterations[(size_t)y0 * stride + x0];
+        for (int y = y0 + 1; y < y1; ++y) {
+            i32 *row = iterations + (size_t)y * stride;
+            for (int x = x0 + 1; x < x1; ++x) row[x] = value;
+        }
+        CountPixels(0, (i64)inner_w * inner_h);
+        return;
+    }
+
+    if (inner_w < SUBDIVISION_MIN_INTERIOR || inner_h < SUBDIVISION_MIN_INTERIOR) {
+        // Interiores estreitos deixariam quase todas as lanes de uma linha vazias; em bloco elas se recarregam
+        FrameIterateBlock(frame, iterations, stride, x0 + 1, y0 + 1, x1, y1);
+        CountPixels((i64)inner_w * inner_h, 0);
+        return;
+    }
+
+    // A linha e a coluna do meio viram a borda compartilhada dos quatro filhos
+    i32 xm = x0 + (x1 - x0) / 2;
+    i32 ym = y0 + (y1 - y0) / 2;
+    FrameIterateSpan(frame, iterations + (size_t)ym * stride, x0 + 1, x1, 1, ym);
+    FrameIterateColumn(frame, iterations, stride, y0 + 1, ym, xm);
+    FrameIterateColumn(frame, iterations, stride, ym + 1, y1, xm);
+    CountPixels(inner_w + inner_h - 1, 0);
+
+    if ((i64)inner_w * inner_h >= SUBDIVISION_TASK_MIN_AREA) {
+        #pragma omp task
+        SubdivideRect(frame, iterations, stride, x0, y0, xm, ym);
+        #pragma omp task
+        SubdivideRect(frame, iterations, stride, xm, y0, x1, ym);
+        #pragma omp task
+        SubdivideRect(frame, iterations, stride, x0, ym, xm, y1);
+        #pragma omp task
+        SubdivideRect(frame, iterations, stride, xm, ym, x1, y1);
+    } else {
+        SubdivideRect(frame, iterations, stride, x0, y0, xm, ym);
+        SubdivideRect(frame, iterations, stride, xm, y0, x1, ym);
+        SubdivideRect(frame, iterations, stride, x0, ym, xm, y1);
+        SubdivideRect(frame, iterations, stride, xm, ym, x1, y1);
+    }
+}
+
+// Linha ou coluna k da grade inicial; a última sempre coincide com a borda do retângulo
+static inline i32 GridLine(i32 k, i32 lines, i32 origin, i32 last)
+{
+    return (k == lines - 1) ? last : origin + k * SUBDIVISION_BLOCK_SIZE;
+}
+
+/*
+Mesmo contrato de FrameIterateRect: preenche [x0, x1) x [y0, y1). Primeiro calcula
+uma grade de linhas e colunas a cada SUBDIVISION_BLOCK_SIZE pixels (mais a última
+linha e coluna) e depois subdivide cada bloco da grade numa tarefa OpenMP.
+*/
+void SubdivisionIterateRect(const FrameSetup *frame, i32 *iterations, i32 stride, i32 x0, i32 y0, i32 x1, i32 y1)
+{
+    if (x0 >= x1 || y0 >= y1) return;
+
+    i32 last_x = x1 - 1;
+    i32 last_y = y1 - 1;
+    i32 columns = (last_x - x0 + SUBDIVISION_BLOCK_SIZE - 1) / SUBDIVISION_BLOCK_SIZE + 1;
+    i32 rows = (last_y - y0 + SUBDIVISION_BLOCK_SIZE - 1) / SUBDIVISION_BLOCK_SIZE + 1;
+
+    #pragma omp parallel
+    {
+        #pragma omp for schedule(dynamic)
+        for (int k = 0; k < rows; ++k) {
+            i32 y = GridLine(k, rows, y0, last_y);
+            FrameIterateSpan(frame, iterations + (size_t)y * stride, x0, x1, 1, y);
+        }
+
+        // As colunas só precisam dos trechos entre as linhas já calculadas
+        #pragma omp for schedule(dynamic)
+        for (int k = 0; k < columns; ++k) {
+            i32 x = GridLine(k, columns, x0, last_x);
+            for (int j = 0; j + 1 < rows; ++j) {
+                FrameIterateColumn(frame, iterations, stride, GridLine(j, rows, y0, last_y) + 1,
+                                   GridLine(j + 1, rows, y0, last_y), x);
+            }
+        }
+
+        #pragma omp single
+        {
+            i64 grid_pixels = 0;
+            for (int k = 0; k < rows; ++k) grid_pixels += x1 - x0;
+            for (int k = 0; k < columns; ++k) grid_pixels += (y1 - y0) - rows;
+            CountPixels(grid_pixels, 0);
+
+            for (int j = 0; j + 1 < rows; ++j) {
+                for (int k = 0; k + 1 < columns; ++k) {
+                    i32 bx0 = GridLine(k, columns, x0, last_x), bx1 = GridLine(k + 1, columns, x0, last_x);
+                    i32 by0 = GridLine(j, rows, y0, last_y), by1 = GridLine(j + 1, rows, y0, last_y);
+                    #pragma omp task
+                    {
+                        ProfileZone zone = ProfileBegin("subdivide");
+                        SubdivideRect(frame, iterations, stride, bx0, by0, bx1, by1);
+                        ProfileEnd(&zone);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ResetSubdivisionStats(void)
+{
+    LastSubdivisionStats.computed_pixels = 0;
+    LastSubdivisionStats.filled_pixels = 0;
+}
+
+SubdivisionStats GetSubdivisionStats(void)
+{
+    return LastSubdivisionStats;
+}
@@ -0,0 +1,415 @@
+#include "platform.h"
+#include "mandelbrot.h"
+#include "hpreal.h"
+#include "kernels.h"
+#include "profiler.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include <pmmintrin.h> // MXCSR (FTZ/DAZ)
+
+/*
+Deep zoom por teoria de perturbação.
+
+Em vez de iterar cada pixel com precisão arbitrária, iteramos uma única órbita
+de referência Z_n (no ponto C) em ponto fixo e, para cada pixel c = C + dc,
+apenas o desvio d_n = z_n - Z_n, que é pequeno e cabe em f32/f64:
+
+    d_{n+1} = 2 Z_n d_n + d_n^2 + dc = (2 Z_n + d_n) d_n + dc
+
+Quando |Z_n + d_n| < |d_n| a referência deixou de representar bem o pixel
+(é aí que nascem os "glitches"); nesse caso fazemos o rebase: d = z e a
+referência volta para Z_0 = 0. O mesmo acontece quando a órbita de
+referência acaba por ter escapado antes do pixel.
+
+A aproximação por série d_n ~ A_n dc + B_n dc^2 + C_n dc^3 permite pular as
+primeiras iterações de todos os pixels do frame de uma vez.
+*/
+
+// Abaixo disso os desvios em f32 perdem precisão (e viram subnormais)
+#define PERTURBATION_F32_MIN_ZOOM 1e-30
+
+/*
+Os desvios em f64 são o padrão. O f32 só entra se o erro de arredondamento acumulado,
+~2^-24 por iteração iterada depois da série, ficar bem abaixo de um pixel: o desvio
+mede até a largura da vista, então o erro relativo precisa ser menor que 1/lado. A
+estimativa é otimista onde a órbita amplifica o erro, por isso uma linha de provas
+também precisa dar as mesmas contagens nas duas larguras.
+*/
+#define PERTURBATION_F32_ERROR_BUDGET (1.0 / 16.0)
+#define PERTURBATION_F32_PROBE_ROWS 4
+
+// Erro aceito da série, em frações do espaçamento entre pixels já transformado por A_n
+#define SERIES_TOLERANCE 1e-3
+
+#define SERIES_PROBE_COUNT 8
+
+typedef struct {
+    HPReal c_re;
+    HPReal c_im;
+    i32 limbs;
+    i32 max_iterations;
+
+    // Z_0 .. Z_{length - 1}; se length <= max_iterations a referência escapou
+    i32 length;
+    i32 capacity;
+    f64 *z_re;
+    f64 *z_im;
+    f32 *z_re32;
+    f32 *z_im32;
+
+    // Coeficientes A, B e C da série (re, im) para cada n < series_length
+    i32 series_length;
+    f64 *series;
+
+    b32 is_valid;
+} ReferenceOrbit;
+
+// Parâmetros do frame atual, preenchidos por PerturbationPrepare
+typedef struct {
+    f64 dc_re0;
+    f64 dc_im0;
+    f64 zoom;
+    i32 skip;
+    i32 max_iterations;
+    b32 use_f32;
+} PerturbationFrame;
+
+static ReferenceOrbit Reference;
+static PerturbationFrame Frame;
+static PerturbationStats LastStats;
+
+static b32 ReferenceReserve(ReferenceOrbit *ref, i32 capacity)
+{
+    if (capacity <= ref->capacity) return 1;
+
+    free(ref->z_re);
+    free(ref->z_im);
+    free(ref->z_re32);
+    free(ref->z_im32);
+    free(ref->series);
+
+    ref->z_re = malloc(sizeof(f64) * capacity);
+    ref->z_im = malloc(sizeof(f64) * capacity);
+    ref->z_re32 = malloc(sizeof(f32) * capacity);
+    ref->z_im32 = malloc(sizeof(f32) * capacity);
+    ref->series = malloc(sizeof(f64) * 6 * capacity);
+    ref->capacity = capacity;
+
+    if (!ref->z_re || !ref->z_im || !ref->z_re32 || !ref->z_im32 || !ref->series) {
+        ref->capacity = 0;
+        ref->is_valid = 0;
+        return 0;
+    }
+    return 1;
+}
+
+static void ReferenceCompute(ReferenceOrbit *ref, const HPReal *c_re, const HPReal *c_im,
+                             i32 limbs, i32 max_iterations)
+{
+    if (!ReferenceReserve(ref, max_iterations + 1)) return;
+
+    ref->c_re = *c_re;
+    ref->c_im = *c_im;
+    HPTruncate(&ref->c_re, limbs);
+    HPTruncate(&ref->c_im, limbs);
+    ref->limbs = limbs;
+    ref->max_iterations = max_iterations;
+
+    HPReal z_re, z_im, z_re2, z_im2, z_re_im;
+    HPZero(&z_re);
+    HPZero(&z_im);
+
+    // A_0 = B_0 = C_0 = 0, pois d_0 = 0
+    f64 a_re = 0, a_im = 0, b_re = 0, b_im = 0, cc_re = 0, cc_im = 0;
+    b32 series_alive = 1;
+    ref->series_length = 0;
+
+    i32 n = 0;
+    for (;;) {
+        f64 zr = HPToF64(&z_re);
+        f64 zi = HPToF64(&z_im);
+        ref->z_re[n] = zr;
+        ref->z_im[n] = zi;
+        ref->z_re32[n] = (f32)zr;
+        ref->z_im32[n] = (f32)zi;
+
+        if (series_alive) {
+            f64 *coefficients = ref->series + 6 * n;
+            coefficients[0] = a_re; coefficients[1] = a_im;
+            coefficients[2] = b_re; coefficients[3] = b_im;
+            coefficients[4] = cc_re; coefficients[5] = cc_im;
+            ref->series_length = n + 1;
+
+            // A' = 2ZA + 1, B' = 2ZB + A^2, C' = 2ZC + 2AB
+            f64 na_re = 2 * (zr * a_re - zi * a_im) + 1.0;
+            f64 na_im = 2 * (zr * a_im + zi * a_re);
+            f64 nb_re = 2 * (zr * b_re - zi * b_im) + (a_re * a_re - a_im * a_im);
+            f64 nb_im = 2 * (zr * b_im + zi * b_re) + 2 * a_re * a_im;
+            f64 nc_re = 2 * (zr * cc_re - zi * cc_im) + 2 * (a_re * b_re - a_im * b_im);
+            f64 nc_im = 2 * (zr * cc_im + zi * cc_re) + 2 * (a_re * b_im + a_im * b_re);
+            a_re = na_re; a_im = na_im;
+            b_re = nb_re; b_im = nb_im;
+            cc_re = nc_re; cc_im = nc_im;
+
+            series_alive = isfinite(na_re + na_im + nb_re + nb_im + nc_re + nc_im);
+        }
+
+        if (n == max_iterations || zr * zr + zi * zi > 4.0) break;
+
+        // Z' = Z^2 + C
+        HPMul(&z_re2, &z_re, &z_re, limbs);
+        HPMul(&z_im2, &z_im, &z_im, limbs);
+        HPMul(&z_re_im, &z_re, &z_im, limbs);
+        HPSub(&z_re, &z_re2, &z_im2, limbs);
+        HPAdd(&z_re, &z_re, &ref->c_re, limbs);
+        HPAdd(&z_im, &z_re_im, &z_re_im, limbs);
+        HPAdd(&z_im, &z_im, &ref->c_im, limbs);
+        ++n;
+    }
+
+    ref->length = n + 1;
+    ref->is_valid = 1;
+}
+
+/*
+Descobre quantas iterações a série consegue pular neste frame, comparando-a com
+a perturbação direta em pontos de prova nas bordas da vista (onde |dc| é maior
+e o erro da série também).
+*/
+static i32 SeriesFindSkip(const ReferenceOrbit *ref, const f64 *probe_re, const f64 *probe_im, f64 zoom)
+{
+    f64 d_re[SERIES_PROBE_COUNT] = {0};
+    f64 d_im[SERIES_PROBE_COUNT] = {0};
+
+    i32 limit = ref->series_length;
+    if (limit > ref->length - 1) limit = ref->length - 1;
+
+    i32 skip = 0;
+    for (i32 n = 1; n < limit; ++n) {
+        const f64 *coefficients = ref->series + 6 * n;
+        f64 a_re = coefficients[0], a_im = coefficients[1];
+        f64 b_re = coefficients[2], b_im = coefficients[3];
+        f64 c_re = coefficients[4], c_im = coefficients[5];
+        f64 tolerance = SERIES_TOLERANCE * sqrt(a_re * a_re + a_im * a_im) * zoom;
+
+        f64 zr = ref->z_re[n - 1], zi = ref->z_im[n - 1];
+        for (int p = 0; p < SERIES_PROBE_COUNT; ++p) {
+            f64 tr = 2 * zr + d_re[p], ti = 2 * zi + d_im[p];
+            f64 nr = tr * d_re[p] - ti * d_im[p] + probe_re[p];
+            f64 ni = tr * d_im[p] + ti * d_re[p] + probe_im[p];
+            d_re[p] = nr;
+            d_im[p] = ni;
+
+            f64 dc_re = probe_re[p], dc_im = probe_im[p];
+            f64 dc2_re = dc_re * dc_re - dc_im * dc_im, dc2_im = 2 * dc_re * dc_im;
+            f64 dc3_re = dc2_re * dc_re - dc2_im * dc_im, dc3_im = dc2_re * dc_im + dc2_im * dc_re;
+            f64 s_re = a_re * dc_re - a_im * dc_im + b_re * dc2_re - b_im * dc2_im + c_re * dc3_re - c_im * dc3_im;
+            f64 s_im = a_re * dc_im + a_im * dc_re + b_re * dc2_im + b_im * dc2_re + c_re * dc3_im + c_im * dc3_re;
+
+            f64 err_re = s_re - nr, err_im = s_im - ni;
+            if (sqrt(err_re * err_re + err_im * err_im) > tolerance) return skip;
+
+            // A prova não pode ter escapado nem precisado de rebase antes do salto
+            f64 z_re = ref->z_re[n] + nr, z_im = ref->z_im[n] + ni;
+            f64 z_mag2 = z_re * z_re + z_im * z_im;
+            if (z_mag2 > 4.0 || z_mag2 < nr * nr + ni * ni) return skip;
+        }
+        skip = n;
+    }
+
+    return skip;
+}
+
+static inline void SeriesEvaluate(const ReferenceOrbit *ref, i32 n, f64 dc_re, f64 dc_im, f64 *out_re, f64 *out_im)
+{
+    const f64 *coefficients = ref->series + 6 * n;
+    f64 dc2_re = dc_re * dc_re - dc_im * dc_im, dc2_im = 2 * dc_re * dc_im;
+    f64 dc3_re = dc2_re * dc_re - dc2_im * dc_im, dc3_im = dc2_re * dc_im + dc2_im * dc_re;
+    *out_re = coefficients[0] * dc_re - coefficients[1] * dc_im
+            + coefficients[2] * dc2_re - coefficients[3] * dc2_im
+            + coefficients[4] * dc3_re - coefficients[5] * dc3_im;
+    *out_im = coefficients[0] * dc_im + coefficients[1] * dc_re
+            + coefficients[2] * dc2_im + coefficients[3] * dc2_re
+            + coefficients[4] * dc3_im + coefficients[5] * dc3_re;
+}
+
+/*
+Percorre os pixels i0, i0 + step, ... < i1 de uma linha (vertical = 0) ou coluna
+(vertical = 1) da vista, gravando o pixel i em iterations[i * stride]. A coordenada
+que varia é along0 + i * zoom em qualquer caso, então uma linha e uma coluna que se
+cruzam chegam exatamente ao mesmo dc no pixel em comum.
+*/
+static void PerturbLine(const ReferenceOrbit *ref, const PerturbationFrame *frame, i32 *iterations, i32 i0, i32 i1,
+                        i32 step, i32 stride, f64 along0, f64 across, b32 vertical)
+{
+    const IterationKernel *kernel = GetIterationKernel();
+    ReferenceLanes lanes_ref = { ref->z_re, ref->z_im, ref->z_re32, ref->z_im32, ref->length };
+    i32 lanes = frame->use_f32 ? PERTURB_LANES_F32 : PERTURB_LANES_F64;
+
+    // O resto que não enche um registrador repete o último pixel nas lanes que sobram,
+    // para que todo pixel passe pela mesma aritmética das lanes
+    for (int i = i0; i < i1; i += lanes * step)
+    {
+        f64 dc_re[PERTURB_LANES_F32], dc_im[PERTURB_LANES_F32];
+        f64 d_re[PERTURB_LANES_F32], d_im[PERTURB_LANES_F32];
+        i32 counts[PERTURB_LANES_F32];
+        i32 count = 0;
+        for (int k = 0; k < lanes; ++k) {
+            if (i + k * step < i1) count = k + 1;
+            f64 along = along0 + (i + (count - 1) * step) * frame->zoom;
+            dc_re[k] = vertical ? across : along;
+            dc_im[k] = vertical ? along : across;
+            SeriesEvaluate(ref, frame->skip, dc_re[k], dc_im[k], &d_re[k], &d_im[k]);
+        }
+
+        if (frame->use_f32) {
+            f32 dc_re32[PERTURB_LANES_F32], dc_im32[PERTURB_LANES_F32];
+            f32 d_re32[PERTURB_LANES_F32], d_im32[PERTURB_LANES_F32];
+            for (int k = 0; k < lanes; ++k) {
+                dc_re32[k] = (f32)dc_re[k];
+                dc_im32[k] = (f32)dc_im[k];
+                d_re32[k] = (f32)d_re[k];
+                d_im32[k] = (f32)d_im[k];
+            }
+            kernel->perturb_f32(&lanes_ref, dc_re32, dc_im32, d_re32, d_im32, frame->skip, frame->max_iterations, counts);
+        } else {
+            kernel->perturb_f64(&lanes_ref, dc_re, dc_im, d_re, d_im, frame->skip, frame->max_iterations, counts);
+        }
+
+        for (int k = 0; k < count; ++k) iterations[(size_t)(i + k * step) * stride] = counts[k];
+    }
+}
+
+// Contagens das provas com as lanes do frame (f32 ou f64); 'counts' tem uma linha de largura por prova
+static void PerturbProbeRows(const PerturbationFrame *frame, i32 *counts, i32 width, i32 height)
+{
+    i32 step = width / PERTURB_LANES_F32 > 1 ? width / PERTURB_LANES_F32 : 1;
+    for (int r = 0; r < PERTURBATION_F32_PROBE_ROWS; ++r) {
+        i32 y = (2 * r + 1) * height / (2 * PERTURBATION_F32_PROBE_ROWS);
+        f64 dc_im = frame->dc_im0 + y * frame->zoom;
+        PerturbLine(&Reference, frame, counts + (size_t)r * width, step / 2, width, step, 1, frame->dc_re0, dc_im, 0);
+    }
+}
+
+static b32 PerturbationF32IsEnough(i32 width, i32 height)
+{
+    if (Frame.zoom < PERTURBATION_F32_MIN_ZOOM) return 0;
+
+    i32 side = width > height ? width : height;
+    f64 iterated = (f64)(Reference.length - Frame.skip);
+    if (iterated * side * ldexp(1.0, -24) > PERTURBATION_F32_ERROR_BUDGET) return 0;
+
+    size_t size = (size_t)PERTURBATION_F32_PROBE_ROWS * width;
+    i32 *counts32 = calloc(size, sizeof(i32));
+    i32 *counts64 = calloc(size, sizeof(i32));
+    b32 is_enough = counts32 && counts64;
+    if (is_enough) {
+        u32 saved_csr = _mm_getcsr();
+        _mm_setcsr(saved_csr | _MM_FLUSH_ZERO_ON | _MM_DENORMALS_ZERO_ON);
+        PerturbationFrame frame = Frame;
+        frame.use_f32 = 1;
+        PerturbProbeRows(&frame, counts32, width, height);
+        frame.use_f32 = 0;
+        PerturbProbeRows(&frame, counts64, width, height);
+        _mm_setcsr(saved_csr);
+        is_enough = memcmp(counts32, counts64, sizeof(i32) * size) == 0;
+    }
+    free(counts32);
+    free(counts64);
+    return is_enough;
+}
+
+b32 PerturbationPrepare(const HPReal *center_x, const HPReal *center_y, f64 zoom,
+                        i32 width, i32 height, i32 max_iterations)
+{
+    if (max_iterations < 1) max_iterations = 1;
+
+    f64 half_w = 0.5 * width * zoom;
+    f64 half_h = 0.5 * height * zoom;
+    i32 limbs = HPLimbsForZoom(zoom);
+
+    // A referência antiga serve enquanto estiver dentro da vista e tiver precisão suficiente
+    HPReal offset_re, offset_im;
+    b32 reused = 0;
+    if (Reference.is_valid && Reference.limbs >= limbs && Reference.max_iterations == max_iterations) {
+        HPSub(&offset_re, center_x, &Reference.c_re, HP_MAX_LIMBS);
+        HPSub(&offset_im, center_y, &Reference.c_im, HP_MAX_LIMBS);
+        reused = (fabs(HPToF64(&offset_re)) <= half_w && fabs(HPToF64(&offset_im)) <= half_h);
+    }
+
+    if (!reused) {
+        ProfileZone zone = ProfileBegin("reference orbit");
+        ReferenceCompute(&Reference, center_x, center_y, limbs, max_iterations);
+        ProfileEnd(&zone);
+        if (!Reference.is_valid) return 0;
+        HPSub(&offset_re, center_x, &Reference.c_re, HP_MAX_LIMBS);
+        HPSub(&offset_im, center_y, &Reference.c_im, HP_MAX_LIMBS);
+    }
+
+    // dc do pixel (0, 0) em relação à referência
+    Frame.dc_re0 = HPToF64(&offset_re) - half_w;
+    Frame.dc_im0 = HPToF64(&offset_im) - half_h;
+    Frame.zoom = zoom;
+    Frame.max_iterations = max_iterations;
+    Frame.use_f32 = 0;
+
+    f64 probe_re[SERIES_PROBE_COUNT], probe_im[SERIES_PROBE_COUNT];
+    for (int p = 0; p < SERIES_PROBE_COUNT; ++p) {
+        static const f64 fx[SERIES_PROBE_COUNT] = {0, 0.5, 1, 1, 1, 0.5, 0, 0};
+        static const f64 fy[SERIES_PROBE_COUNT] = {0, 0, 0, 0.5, 1, 1, 1, 0.5};
+        probe_re[p] = Frame.dc_re0 + fx[p] * width * zoom;
+        probe_im[p] = Frame.dc_im0 + fy[p] * height * zoom;
+    }
+    Frame.skip = SeriesFindSkip(&Reference, probe_re, probe_im, zoom);
+    if (Frame.skip > max_iterations) Frame.skip = max_iterations;
+    Frame.use_f32 = PerturbationF32IsEnough(width, height);
+
+    LastStats.reference_length = Reference.length;
+    LastStats.reference_limbs = Reference.limbs;
+    LastStats.series_skip = Frame.skip;
+    LastStats.reference_reused = reused;
+    LastStats.lanes = Frame.use_f32 ? PRECISION_F32 : PRECISION_F64;
+    return 1;
+}
+
+void PerturbationIterateSpan(i32 *iterations, i32 x0, i32 x1, i32 step, i32 y)
+{
+    // Em zooms muito fundos d^2 vira subnormal; zerá-lo não muda o resultado e evita a penalidade
+    u32 saved_csr = _mm_getcsr();
+    _mm_setcsr(saved_csr | _MM_FLUSH_ZERO_ON | _MM_DENORMALS_ZERO_ON);
+
+    f64 dc_im = Frame.dc_im0 + y * Frame.zoom;
+    PerturbLine(&Reference, &Frame, iterations, x0, x1, step, 1, Frame.dc_re0, dc_im, 0);
+
+    _mm_setcsr(saved_csr);
+}
+
+void PerturbationIterateColumn(i32 *iterations, i32 stride, i32 y0, i32 y1, i32 x)
+{
+    u32 saved_csr = _mm_getcsr();
+    _mm_setcsr(saved_csr | _MM_FLUSH_ZERO_ON | _MM_DENORMALS_ZERO_ON);
+
+    f64 dc_re = Frame.dc_re0 + x * Frame.zoom;
+    PerturbLine(&Reference, &Frame, iterations, y0, y1, 1, stride, Frame.dc_im0, dc_re, 1);
+
+    _mm_setcsr(saved_csr);
+}
+
+void RenderMandelbrotPerturbation(OffscreenBuffer *buffer, const HPReal *center_x, const HPReal *center_y,
+                                  f64 zoom, i32 max_iterations)
+{
+    // FrameSetupInit prepara a referência e o frame segue pelo mesmo escalonador de blocos dos outros modos
+    FrameSetup frame;
+    if (!FrameSetupInit(&frame, center_x, center_y, zoom, buffer->width, buffer->height, max_iterations, PRECISION_DEEP)) {
+        return;
+    }
+    FrameRender(&frame, buffer);
+}
+
+PerturbationStats GetPerturbationStats(void)
+{
+    return LastStats;
+}
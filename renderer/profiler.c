@@ -0,0 +1,344 @@
+#include "platform.h"
+#include "mandelbrot.h"
+#include "profiler.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+/*
+Cada thread grava as suas zonas num anel próprio, então registrar uma zona não
+disputa nada com as outras threads: só a thread dona escreve no anel, e ele só é
+lido entre frames (resumo, trace), quando as regiões paralelas já terminaram. Os
+contadores seguem a mesma ideia, um conjunto por thread somado no fim do frame.
+
+As threads recebem um número na primeira zona que registram; é esse número que
+aparece como tid no trace.
+
+O frame é marcado por uma thread só (a do laço da plataforma, ou a de renderização
+quando ela é separada), mas as etapas podem vir de outra: a janela mede eventos e
+apresentação enquanto a renderização mede o resto. Por isso os tempos das etapas
+são somados e recolhidos com operações atômicas.
+*/
+
+typedef struct {
+    const char *name;
+    f64 start;
+    f64 end;
+} ProfileEvent;
+
+typedef struct {
+    _Alignas(64) ProfileEvent *events;
+    u32 head; // Total de eventos já gravados; o anel guarda os últimos PROFILE_RING_EVENTS
+    i64 counters[PROFILE_COUNTER_COUNT];
+} ProfileThread;
+
+typedef struct {
+    f64 start;
+    f64 seconds[PROFILE_PHASE_COUNT];
+    i64 counters[PROFILE_COUNTER_COUNT];
+    i64 saved;
+} ProfileFrame;
+
+b32 IsProfilingEnabled = 0;
+
+static ProfileThread Threads[PROFILE_MAX_THREADS];
+static _Atomic int ThreadCount;
+static ProfileFrame Frames[PROFILE_HISTORY_FRAMES];
+static i64 FrameCount;
+static f64 FrameStart;
+static f64 PhaseSeconds[PROFILE_PHASE_COUNT];
+static f64 Epoch;
+
+static const char *const PhaseNames[PROFILE_PHASE_COUNT] = {"frame", "events", "render", "present"};
+
+static int ProfileThreadId = -1;
+#pragma omp threadprivate(ProfileThreadId)
+
+static ProfileThread *GetProfileThread(void)
+{
+    if (ProfileThreadId < 0) ProfileThreadId = atomic_fetch_add(&ThreadCount, 1);
+    if (ProfileThreadId >= PROFILE_MAX_THREADS) return NULL;
+    return &Threads[ProfileThreadId];
+}
+
+void SetProfilingEnabled(b32 enabled)
+{
+    if (enabled && Epoch == 0.0) Epoch = omp_get_wtime();
+    // Um frame aberto antes de ligar não tem início válido
+    if (enabled != IsProfilingEnabled) FrameStart = 0.0;
+    IsProfilingEnabled = enabled;
+}
+
+void ProfileRecordZone(const ProfileZone *zone, f64 end)
+{
+    ProfileThread *thread = GetProfileThread();
+    if (!thread) return;
+    if (!thread->events) {
+        thread->events = malloc(sizeof(ProfileEvent) * PROFILE_RING_EVENTS);
+        if (!thread->events) return;
+    }
+
+    ProfileEvent *event = &thread->events[thread->head++ & (PROFILE_RING_EVENTS - 1)];
+    event->name = zone->name;
+    event->start = zone->start;
+    event->end = end;
+
+    if (zone->phase >= 0) {
+        #pragma omp atomic
+        PhaseSeconds[zone->phase] += end - zone->start;
+    }
+}
+
+ProfileZone ProfileBeginPhase(ProfilePhase phase)
+{
+    ProfileZone zone = ProfileBegin(PhaseNames[phase]);
+    zone.phase = phase;
+    return zone;
+}
+
+void ProfileAddCount(ProfileCounter counter, i64 value)
+{
+    ProfileThread *thread = GetProfileThread();
+    if (thread) thread->counters[counter] += value;
+}
+
+void ProfileFrameBegin(void)
+{
+    if (!IsProfilingEnabled) return;
+    FrameStart = omp_get_wtime();
+}
+
+void ProfileFrameEnd(void)
+{
+    if (!IsProfilingEnabled || FrameStart == 0.0) return;
+
+    ProfileFrame frame = {0};
+    frame.start = FrameStart;
+    ProfileZone zone = {PhaseNames[PROFILE_PHASE_FRAME], FrameStart, -1};
+    f64 end = omp_get_wtime();
+    ProfileRecordZone(&zone, end);
+    for (int p = 0; p < PROFILE_PHASE_COUNT; ++p) {
+        #pragma omp atomic capture
+        { frame.seconds[p] = PhaseSeconds[p]; PhaseSeconds[p] = 0.0; }
+    }
+    frame.seconds[PROFILE_PHASE_FRAME] = end - FrameStart;
+
+    int threads = atomic_load(&ThreadCount);
+    if (threads > PROFILE_MAX_THREADS) threads = PROFILE_MAX_THREADS;
+    for (int t = 0; t < threads; ++t) {
+        for (int c = 0; c < PROFILE_COUNTER_COUNT; ++c) {
+            frame.counters[c] += Threads[t].counters[c];
+            Threads[t].counters[c] = 0;
+        }
+    }
+    // Toda renderização zera o total de poupadas ao começar, então o que há é deste frame
+    frame.saved = GetSavedIterations();
+
+    Frames[FrameCount % PROFILE_HISTORY_FRAMES] = frame;
+    ++FrameCount;
+    FrameStart = 0.0;
+}
+
+static int CompareF64(const void *a, const void *b)
+{
+    f64 x = *(const f64 *)a, y = *(const f64 *)b;
+    return (x > y) - (x < y);
+}
+
+static int HistogramBucket(f64 ms)
+{
+    int bucket = 0;
+    for (f64 edge = 0.25; bucket < PROFILE_HISTOGRAM_BUCKETS - 1 && ms >= edge; edge *= 2.0) ++bucket;
+    return bucket;
+}
+
+b32 GetProfileSummary(ProfileSummary *summary)
+{
+    memset(summary, 0, sizeof(*summary));
+    i32 frames = FrameCount < PROFILE_HISTORY_FRAMES ? (i32)FrameCount : PROFILE_HISTORY_FRAMES;
+    if (!frames) return 0;
+    summary->frames = frames;
+
+    f64 values[PROFILE_HISTORY_FRAMES];
+    for (int p = 0; p < PROFILE_PHASE_COUNT; ++p) {
+        ProfilePhaseSummary *phase = &summary->phases[p];
+        for (int i = 0; i < frames; ++i) {
+            values[i] = Frames[i].seconds[p] * 1000.0;
+            ++phase->histogram[HistogramBucket(values[i])];
+        }
+        qsort(values, frames, sizeof(f64), CompareF64);
+        phase->p50_ms = values[(frames - 1) / 2];
+        phase->p99_ms = values[(frames - 1) * 99 / 100];
+        phase->max_ms = values[frames - 1];
+    }
+
+    const ProfileFrame *last = &Frames[(FrameCount - 1) % PROFILE_HISTORY_FRAMES];
+    summary->pixels = last->counters[PROFILE_COUNTER_PIXELS];
+    summary->saved = last->saved;
+    summary->iterations = last->counters[PROFILE_COUNTER_ITERATIONS] - last->saved;
+    if (summary->iterations < 0) summary->iterations = 0;
+    return 1;
+}
+
+/*
+Formato "JSON Array/Object" do trace do Chrome: uma zona é um evento completo
+("ph": "X") com início e duração em microssegundos, e os contadores de cada frame
+viram eventos de contador ("ph": "C"), desenhados como gráfico acima das threads.
+*/
+b32 ProfileWriteChromeTrace(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) return 0;
+
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf(f, "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"mandelbrot\"}}");
+
+    int threads = atomic_load(&ThreadCount);
+    if (threads > PROFILE_MAX_THREADS) threads = PROFILE_MAX_THREADS;
+    for (int t = 0; t < threads; ++t) {
+        const ProfileThread *thread = &Threads[t];
+        fprintf(f, ",\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"thread %d\"}}",
+                t, t);
+        if (!thread->events) continue;
+
+        u32 count = thread->head < PROFILE_RING_EVENTS ? thread->head : PROFILE_RING_EVENTS;
+        for (u32 i = thread->head - count; i != thread->head; ++i) {
+            const ProfileEvent *event = &thread->events[i & (PROFILE_RING_EVENTS - 1)];
+            fprintf(f, ",\n  {\"name\": \"%s\", \"cat\": \"render\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                       "\"ts\": %.3f, \"dur\": %.3f}",
+                    event->name, t, (event->start - Epoch) * 1e6, (event->end - event->start) * 1e6);
+        }
+    }
+
+    i64 frames = FrameCount < PROFILE_HISTORY_FRAMES ? FrameCount : PROFILE_HISTORY_FRAMES;
+    for (i64 i = FrameCount - frames; i < FrameCount; ++i) {
+        const ProfileFrame *frame = &Frames[i % PROFILE_HISTORY_FRAMES];
+        i64 iterations = frame->counters[PROFILE_COUNTER_ITERATIONS] - frame->saved;
+        fprintf(f, ",\n  {\"name\": \"frame\", \"ph\": \"C\", \"pid\": 1, \"ts\": %.3f, "
+                   "\"args\": {\"pixels\": %lld, \"iterations\": %lld, \"saved\": %lld}}",
+                (frame->start - Epoch) * 1e6, (long long)frame->counters[PROFILE_COUNTER_PIXELS],
+                (long long)(iterations > 0 ? iterations : 0), (long long)frame->saved);
+    }
+
+    fprintf(f, "\n]}\n");
+    b32 is_ok = !ferror(f);
+    fclose(f);
+    return is_ok;
+}
+
+/*
+Fonte 3x5 para o overlay: cada glifo tem 5 linhas de 3 bits, uma por dígito octal,
+de cima para baixo. Só maiúsculas, algarismos e a pontuação que o painel usa.
+*/
+static const u16 FontDigits[10] = {
+    075557, 026227, 071747, 071717, 055711, 074717, 074757, 071111, 075757, 075717,
+};
+
+static const u16 FontLetters[26] = {
+    025755, 065656, 034443, 065556, 074647, 074644, 034553, 055755, 072227, 011152, 055655, 044447, 057755,
+    065555, 025552, 065644, 025563, 065655, 034216, 072222, 055557, 055552, 055775, 055255, 055222, 071247,
+};
+
+#define OVERLAY_SCALE 2
+#define OVERLAY_ADVANCE (4 * OVERLAY_SCALE)
+#define OVERLAY_LINE (7 * OVERLAY_SCALE)
+#define OVERLAY_MARGIN 6
+#define OVERLAY_BACKGROUND 0xFF101010
+#define OVERLAY_TEXT 0xFFE0E0E0
+#define OVERLAY_BAR 0xFF40C040
+
+static u16 OverlayGlyph(char c)
+{
+    if (c >= '0' && c <= '9') return FontDigits[c - '0'];
+    if (c >= 'A' && c <= 'Z') return FontLetters[c - 'A'];
+    if (c >= 'a' && c <= 'z') return FontLetters[c - 'a'];
+    switch (c) {
+        case '.': return 000002;
+        case ':': return 002020;
+        case '%': return 051245;
+        case '/': return 011244;
+        case '-': return 000700;
+        default: return 0;
+    }
+}
+
+static void OverlayFillRect(OffscreenBuffer *buffer, int x0, int y0, int x1, int y1, u32 color)
+{
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > buffer->width) x1 = buffer->width;
+    if (y1 > buffer->height) y1 = buffer->height;
+    for (int y = y0; y < y1; ++y) {
+        u32 *row = (u32 *)((u8 *)buffer->memory + (size_t)y * buffer->pitch);
+        for (int x = x0; x < x1; ++x) row[x] = color;
+    }
+}
+
+static void OverlayDrawText(OffscreenBuffer *buffer, int x, int y, const char *text)
+{
+    for (; *text; ++text, x += OVERLAY_ADVANCE) {
+        u16 glyph = OverlayGlyph(*text);
+        for (int row = 0; row < 5; ++row) {
+            for (int col = 0; col < 3; ++col) {
+                if (!(glyph & (1 << ((4 - row) * 3 + (2 - col))))) continue;
+                int px = x + col * OVERLAY_SCALE, py = y + row * OVERLAY_SCALE;
+                OverlayFillRect(buffer, px, py, px + OVERLAY_SCALE, py + OVERLAY_SCALE, OVERLAY_TEXT);
+            }
+        }
+    }
+}
+
+void ProfileDrawOverlay(OffscreenBuffer *buffer)
+{
+    static const char *const labels[PROFILE_PHASE_COUNT] = {"FRAME", "EVENTOS", "RENDER", "EXIBIR"};
+    const int columns = 44, bar_height = 40;
+
+    if (!buffer->memory || buffer->bytes_per_pixel != 4) return;
+
+    int width = 2 * OVERLAY_MARGIN + columns * OVERLAY_ADVANCE;
+    int height = 2 * OVERLAY_MARGIN + 8 * OVERLAY_LINE + bar_height;
+    OverlayFillRect(buffer, 0, 0, width, height, OVERLAY_BACKGROUND);
+
+    ProfileSummary summary;
+    char line[64];
+    int x = OVERLAY_MARGIN, y = OVERLAY_MARGIN;
+    if (!GetProfileSummary(&summary)) {
+        OverlayDrawText(buffer, x, y, "SEM FRAMES MEDIDOS");
+        return;
+    }
+
+    snprintf(line, sizeof(line), "%d FRAMES          P50    P99    MAX MS", summary.frames);
+    OverlayDrawText(buffer, x, y, line);
+    y += OVERLAY_LINE;
+    for (int p = 0; p < PROFILE_PHASE_COUNT; ++p) {
+        const ProfilePhaseSummary *phase = &summary.phases[p];
+        snprintf(line, sizeof(line), "%-14s %7.2f%7.2f%7.2f", labels[p], phase->p50_ms, phase->p99_ms, phase->max_ms);
+        OverlayDrawText(buffer, x, y, line);
+        y += OVERLAY_LINE;
+    }
+
+    f64 total = (f64)(summary.iterations + summary.saved);
+    snprintf(line, sizeof(line), "PIXELS %lld  MITER %.1f", (long long)summary.pixels, summary.iterations / 1e6);
+    OverlayDrawText(buffer, x, y, line);
+    y += OVERLAY_LINE;
+    snprintf(line, sizeof(line), "SAIDAS ANTECIPADAS %.1f%% DAS ITER", total > 0.0 ? 100.0 * summary.saved / total : 0.0);
+    OverlayDrawText(buffer, x, y, line);
+    y += OVERLAY_LINE;
+
+    // Histograma do frame: uma barra por faixa, dobrando de 1/4 ms até 1 s
+    const ProfilePhaseSummary *frame = &summary.phases[PROFILE_PHASE_FRAME];
+    int bar_width = (columns * OVERLAY_ADVANCE) / PROFILE_HISTOGRAM_BUCKETS;
+    y += OVERLAY_MARGIN;
+    for (int b = 0; b < PROFILE_HISTOGRAM_BUCKETS; ++b) {
+        int h = frame->histogram[b] * bar_height / summary.frames;
+        if (frame->histogram[b] && h == 0) h = 1;
+        OverlayFillRect(buffer, x + b * bar_width + 1, y + bar_height - h, x + (b + 1) * bar_width - 1, y + bar_height,
+                        OVERLAY_BAR);
+    }
+    y += bar_height + 2;
+    OverlayDrawText(buffer, x, y, "1/4 MS");
+    OverlayDrawText(buffer, x + (columns - 3) * OVERLAY_ADVANCE, y, "1 S");
+}
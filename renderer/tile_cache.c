@@ -0,0 +1,188 @@
+#include "platform.h"
+#include "mandelbrot.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+Cache de blocos de iterações, no formato das pirâmides de mapas: para cada zoom o
+plano tem uma grade absoluta de blocos de TILE_CACHE_SIZE pixels, e um bloco
+calculado uma vez serve para qualquer vista com aquele zoom que passe por ele.
+RenderMandelbrotCached (main.c) monta o frame com eles e só calcula os que faltam.
+
+As entradas ficam num vetor de tamanho fixo, o limite de memória dividido pelo
+tamanho de um bloco, e são achadas por uma tabela de hash com encadeamento. Cada
+entrada guarda o frame em que foi usada pela última vez: ao inserir, a que está há
+mais tempo sem uso dá lugar à nova, mas nunca uma que o frame atual já pegou.
+
+Todas as funções são chamadas pela thread que renderiza, fora das regiões paralelas.
+*/
+
+#define TILE_CACHE_BYTES ((i64)TILE_CACHE_SIZE * TILE_CACHE_SIZE * (i64)sizeof(i32))
+
+typedef struct {
+    TileCacheKey key;
+    i32 *iterations;
+    u64 last_used; // 0 se a entrada está livre
+    i32 next;      // Próxima entrada do mesmo balde, ou -1
+} TileCacheEntry;
+
+static TileCacheEntry *Entries;
+static i32 EntryCapacity;
+static i32 *Buckets;
+static u32 BucketMask;
+static i64 LimitBytes = (i64)TILE_CACHE_DEFAULT_MEGABYTES << 20;
+static u64 FrameClock = 1;
+static TileCacheStats Stats;
+
+static b32 IsSameKey(const TileCacheKey *a, const TileCacheKey *b)
+{
+    return a->zoom == b->zoom && a->tile_x == b->tile_x && a->tile_y == b->tile_y &&
+           a->max_iterations == b->max_iterations && a->precision == b->precision;
+}
+
+static u32 HashKey(const TileCacheKey *key)
+{
+    u64 zoom_bits;
+    memcpy(&zoom_bits, &key->zoom, sizeof(zoom_bits));
+    u64 hash = zoom_bits * 0x9E3779B97F4A7C15ull;
+    hash = (hash ^ (u64)key->tile_x) * 0xC2B2AE3D27D4EB4Full;
+    hash = (hash ^ (u64)key->tile_y) * 0x165667B19E3779F9ull;
+    hash = (hash ^ ((u64)(u32)key->max_iterations << 8) ^ (u64)key->precision) * 0x9E3779B97F4A7C15ull;
+    return (u32)(hash >> 32);
+}
+
+static b32 EnsureTileCache(void)
+{
+    if (Entries) return 1;
+
+    i64 capacity = LimitBytes / TILE_CACHE_BYTES;
+    if (capacity < 1) capacity = 1;
+    if (capacity > (1 << 24)) capacity = 1 << 24;
+    u32 bucket_count = 1;
+    while (bucket_count < 2 * capacity) bucket_count *= 2;
+
+    Entries = calloc((size_t)capacity, sizeof(TileCacheEntry));
+    Buckets = malloc(sizeof(i32) * bucket_count);
+    if (!Entries || !Buckets) {
+        free(Entries);
+        free(Buckets);
+        Entries = NULL;
+        Buckets = NULL;
+        return 0;
+    }
+    for (u32 i = 0; i < bucket_count; ++i) Buckets[i] = -1;
+    EntryCapacity = (i32)capacity;
+    BucketMask = bucket_count - 1;
+    return 1;
+}
+
+static void UnlinkEntry(i32 index)
+{
+    i32 *link = &Buckets[HashKey(&Entries[index].key) & BucketMask];
+    while (*link != index) link = &Entries[*link].next;
+    *link = Entries[index].next;
+    Entries[index].last_used = 0;
+    --Stats.tiles;
+}
+
+void TileCacheBeginFrame(void)
+{
+    ++FrameClock;
+    Stats.hits = 0;
+    Stats.misses = 0;
+}
+
+i32 *TileCacheFind(const TileCacheKey *key)
+{
+    if (!EnsureTileCache()) return NULL;
+
+    for (i32 index = Buckets[HashKey(key) & BucketMask]; index >= 0; index = Entries[index].next) {
+        TileCacheEntry *entry = &Entries[index];
+        if (IsSameKey(&entry->key, key)) {
+            entry->last_used = FrameClock;
+            ++Stats.hits;
+            return entry->iterations;
+        }
+    }
+    ++Stats.misses;
+    return NULL;
+}
+
+b32 TileCacheContains(const TileCacheKey *key)
+{
+    if (!Entries) return 0;
+
+    for (i32 index = Buckets[HashKey(key) & BucketMask]; index >= 0; index = Entries[index].next) {
+        if (IsSameKey(&Entries[index].key, key)) return 1;
+    }
+    return 0;
+}
+
+i32 *TileCacheInsert(const TileCacheKey *key)
+{
+    if (!EnsureTileCache()) return NULL;
+
+    // Uma entrada livre serve logo; senão, a usada há mais tempo, desde que não neste frame
+    i32 victim = -1;
+    u64 oldest = FrameClock;
+    for (i32 index = 0; index < EntryCapacity; ++index) {
+        u64 last_used = Entries[index].last_used;
+        if (last_used == 0) {
+            victim = index;
+            break;
+        }
+        if (last_used < oldest) {
+            oldest = last_used;
+            victim = index;
+        }
+    }
+    if (victim < 0) return NULL;
+
+    TileCacheEntry *entry = &Entries[victim];
+    if (entry->last_used) UnlinkEntry(victim);
+    if (!entry->iterations) {
+        entry->iterations = malloc(TILE_CACHE_BYTES);
+        if (!entry->iterations) return NULL;
+        Stats.bytes += TILE_CACHE_BYTES;
+    }
+
+    u32 bucket = HashKey(key) & BucketMask;
+    entry->key = *key;
+    entry->last_used = FrameClock;
+    entry->next = Buckets[bucket];
+    Buckets[bucket] = victim;
+    ++Stats.tiles;
+    return entry->iterations;
+}
+
+void TileCacheRemove(const TileCacheKey *key)
+{
+    if (!Entries) return;
+
+    for (i32 index = Buckets[HashKey(key) & BucketMask]; index >= 0; index = Entries[index].next) {
+        if (IsSameKey(&Entries[index].key, key)) {
+            UnlinkEntry(index);
+            return;
+        }
+    }
+}
+
+void SetTileCacheLimit(i64 bytes)
+{
+    if (Entries) {
+        for (i32 index = 0; index < EntryCapacity; ++index) free(Entries[index].iterations);
+    }
+    free(Entries);
+    free(Buckets);
+    Entries = NULL;
+    Buckets = NULL;
+    EntryCapacity = 0;
+    memset(&Stats, 0, sizeof(Stats));
+    LimitBytes = bytes;
+}
+
+TileCacheStats GetTileCacheStats(void)
+{
+    return Stats;
+}
@@ -0,0 +1,260 @@
+#ifndef _WIN32
+#define _GNU_SOURCE // sched_setaffinity e CPU_SET
+#endif
+
+#include "platform.h"
+#include "mandelbrot.h"
+
+#include <stdatomic.h>
+#include <omp.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+/*
+Escalonador de blocos 2D com roubo de trabalho.
+
+O retângulo é cortado em blocos de TileWidth x TileHeight, numerados linha a linha,
+e cada thread começa com uma faixa contígua dessa numeração (vizinhos na tela
+ficam na mesma thread e no mesmo cache). A thread consome a sua faixa pela frente;
+quando ela acaba, rouba a metade de trás da faixa de outra thread. Assim uma região
+cara da imagem (perto do conjunto) é repartida entre quem terminou cedo, sem o
+custo de um contador global disputado por todas as threads a cada linha.
+
+As threads são as do time do OpenMP, que o runtime cria uma vez e reaproveita em
+todas as regiões paralelas; um pool próprio disputaria os mesmos núcleos com as
+regiões OpenMP que continuam existindo (subdivisão, coloração).
+
+Cada faixa é um par [begin, end) num único u64 atômico: o dono avança begin e os
+ladrões recuam end, sempre por compare-and-swap, então ninguém espera por lock.
+*/
+
+#define TILE_MAX_THREADS 256
+
+typedef struct {
+    _Alignas(64) _Atomic u64 range; // begin nos 32 bits de cima, end nos de baixo
+    f64 busy_seconds;
+    i64 tiles;
+    i64 steals;
+} TileQueue;
+
+static TileQueue Queues[TILE_MAX_THREADS];
+static i32 TileWidth = TILE_DEFAULT_WIDTH;
+static i32 TileHeight = TILE_DEFAULT_HEIGHT;
+static b32 IsPinningEnabled = 0;
+static i32 StatsThreads;
+
+// Núcleo em que a thread do time está presa, ou -1; sobrevive entre regiões porque o time é o mesmo
+static int PinnedCpu = -1;
+#pragma omp threadprivate(PinnedCpu)
+
+static inline u64 PackRange(u32 begin, u32 end)
+{
+    return ((u64)begin << 32) | end;
+}
+
+static inline u32 RangeBegin(u64 range) { return (u32)(range >> 32); }
+static inline u32 RangeEnd(u64 range) { return (u32)range; }
+
+static b32 PopTile(TileQueue *queue, u32 *tile)
+{
+    u64 range = atomic_load_explicit(&queue->range, memory_order_acquire);
+    for (;;) {
+        u32 begin = RangeBegin(range), end = RangeEnd(range);
+        if (begin >= end) return 0;
+        if (atomic_compare_exchange_weak_explicit(&queue->range, &range, PackRange(begin + 1, end),
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+            *tile = begin;
+            return 1;
+        }
+    }
+}
+
+// Leva a metade de trás da faixa da vítima (arredondada para cima) para a fila da thread
+static b32 StealTiles(TileQueue *victim, TileQueue *queue)
+{
+    u64 range = atomic_load_explicit(&victim->range, memory_order_acquire);
+    for (;;) {
+        u32 begin = RangeBegin(range), end = RangeEnd(range);
+        if (begin >= end) return 0;
+        u32 take = (end - begin + 1) / 2;
+        if (atomic_compare_exchange_weak_explicit(&victim->range, &range, PackRange(begin, end - take),
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+            atomic_store_explicit(&queue->range, PackRange(end - take, end), memory_order_release);
+            ++queue->steals;
+            return 1;
+        }
+    }
+}
+
+#ifdef _WIN32
+static void PinCurrentThread(int thread)
+{
+    DWORD_PTR process_mask, system_mask;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) return;
+
+    if (thread < 0) {
+        SetThreadAffinityMask(GetCurrentThread(), process_mask);
+        PinnedCpu = -1;
+        return;
+    }
+
+    // A thread t fica no t-ésimo núcleo que o processo pode usar
+    int allowed = 0;
+    for (int cpu = 0; cpu < (int)(sizeof(DWORD_PTR) * 8); ++cpu) {
+        if (!(process_mask & ((DWORD_PTR)1 << cpu))) continue;
+        ++allowed;
+    }
+    if (!allowed) return;
+    int target = thread % allowed;
+    for (int cpu = 0; cpu < (int)(sizeof(DWORD_PTR) * 8); ++cpu) {
+        if (!(process_mask & ((DWORD_PTR)1 << cpu))) continue;
+        if (target-- == 0) {
+            if (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu)) PinnedCpu = cpu;
+            return;
+        }
+    }
+}
+#else
+static cpu_set_t ProcessCpus;
+static b32 IsProcessCpusValid = 0;
+
+static void PinCurrentThread(int thread)
+{
+    if (!IsProcessCpusValid) return;
+
+    if (thread < 0) {
+        sched_setaffinity(0, sizeof(ProcessCpus), &ProcessCpus);
+        PinnedCpu = -1;
+        return;
+    }
+
+    // A thread t fica no t-ésimo núcleo que o processo pode usar
+    int allowed = CPU_COUNT(&ProcessCpus);
+    if (!allowed) return;
+    int target = thread % allowed;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &ProcessCpus)) continue;
+        if (target-- == 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            if (sched_setaffinity(0, sizeof(set), &set) == 0) PinnedCpu = cpu;
+            return;
+        }
+    }
+}
+#endif
+
+void SetTileSize(i32 width, i32 height)
+{
+    TileWidth = width > 0 ? width : TILE_DEFAULT_WIDTH;
+    TileHeight = height > 0 ? height : TILE_DEFAULT_HEIGHT;
+}
+
+void SetThreadPinning(b32 enabled)
+{
+#ifndef _WIN32
+    // Guarda a máscara original antes de qualquer thread ser presa, para poder soltar depois
+    if (enabled && !IsProcessCpusValid) {
+        IsProcessCpusValid = (sched_getaffinity(0, sizeof(ProcessCpus), &ProcessCpus) == 0);
+    }
+#endif
+    IsPinningEnabled = enabled;
+}
+
+void ScheduleTiles(i32 x0, i32 y0, i32 x1, i32 y1, TileWorkFn *work, void *context)
+{
+    if (x0 >= x1 || y0 >= y1) return;
+
+    i32 tile_w = TileWidth, tile_h = TileHeight;
+    i32 tiles_x = (x1 - x0 + tile_w - 1) / tile_w;
+    i32 tiles_y = (y1 - y0 + tile_h - 1) / tile_h;
+    u32 tile_count = (u32)tiles_x * (u32)tiles_y;
+
+    int threads = omp_get_max_threads();
+    if (threads > TILE_MAX_THREADS) threads = TILE_MAX_THREADS;
+    if ((u32)threads > tile_count) threads = (int)tile_count;
+
+    b32 should_pin = IsPinningEnabled;
+
+    #pragma omp parallel num_threads(threads)
+    {
+        int thread = omp_get_thread_num();
+        int team = omp_get_num_threads();
+        TileQueue *queue = &Queues[thread];
+
+        if (should_pin && PinnedCpu < 0) PinCurrentThread(thread);
+        else if (!should_pin && PinnedCpu >= 0) PinCurrentThread(-1);
+
+        atomic_store_explicit(&queue->range,
+                              PackRange((u32)((u64)tile_count * thread / team),
+                                        (u32)((u64)tile_count * (thread + 1) / team)),
+                              memory_order_release);
+
+        // Ninguém rouba antes de todas as faixas estarem no lugar
+        #pragma omp barrier
+
+        f64 busy = 0.0;
+        for (;;) {
+            // Renderização cancelada: os blocos restantes são abandonados
+            if (IsRenderCancelled()) break;
+
+            u32 tile;
+            if (!PopTile(queue, &tile)) {
+                // Começa pela vizinha: é quem tem os blocos mais próximos dos que acabamos de calcular
+                b32 has_stolen = 0;
+                for (int k = 1; k < team && !has_stolen; ++k) {
+                    has_stolen = StealTiles(&Queues[(thread + k) % team], queue);
+                }
+                if (!has_stolen) break;
+                continue;
+            }
+
+            i32 tx = x0 + (i32)(tile % (u32)tiles_x) * tile_w;
+            i32 ty = y0 + (i32)(tile / (u32)tiles_x) * tile_h;
+            i32 tx1 = (tx + tile_w < x1) ? tx + tile_w : x1;
+            i32 ty1 = (ty + tile_h < y1) ? ty + tile_h : y1;
+
+            f64 tile_start = omp_get_wtime();
+            work(context, tx, ty, tx1, ty1);
+            busy += omp_get_wtime() - tile_start;
+            ++queue->tiles;
+        }
+        queue->busy_seconds += busy;
+
+        #pragma omp single nowait
+        if (team > StatsThreads) StatsThreads = team;
+    }
+}
+
+void ResetTileStats(void)
+{
+    for (int i = 0; i < TILE_MAX_THREADS; ++i) {
+        Queues[i].busy_seconds = 0.0;
+        Queues[i].tiles = 0;
+        Queues[i].steals = 0;
+    }
+    StatsThreads = 0;
+}
+
+TileStats GetTileStats(void)
+{
+    TileStats stats = {0};
+    stats.threads = StatsThreads;
+    stats.tile_width = TileWidth;
+    stats.tile_height = TileHeight;
+
+    f64 total_busy = 0.0;
+    for (int i = 0; i < StatsThreads; ++i) {
+        stats.tiles += Queues[i].tiles;
+        stats.steals += Queues[i].steals;
+        total_busy += Queues[i].busy_seconds;
+        if (Queues[i].busy_seconds > stats.max_busy_seconds) stats.max_busy_seconds = Queues[i].busy_seconds;
+    }
+    if (StatsThreads) stats.mean_busy_seconds = total_busy / StatsThreads;
+    return stats;
+}
@@ -0,0 +1,303 @@
+#include "platform.h"
+#include "mandelbrot.h"
+#include "profiler.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+
+/*
+Filme de zoom a partir de quadros-chave. O quadro-chave k tem o dobro da resolução
+do filme e cobre a vista do frame na posição k (em oitavas a partir do início), com
+pixels de start_zoom * 2^-k / 2. Um frame na posição k + t, t em (0, 1], sai do
+quadro-chave k + 1 onde ele alcança, com 2 a 4 pixels dele por pixel do frame, e do
+k nas bordas, com 1 a 2; em t = 1 o frame inteiro vem do k + 1 e a oitava seguinte
+começa igual. Cada frame é só a média de caixa das cores dos quadros-chave, sem
+iteração nenhuma: o custo do filme são os quadros-chave, 3 frames por oitava (com o
+reaproveitamento abaixo), seja qual for o número de frames dela.
+
+O miolo do quadro-chave k cobre a mesma região do k + 1 inteiro com metade da
+densidade, no mesmo reticulado: os pixels pares (nos dois eixos) do k + 1 são
+copiados do miolo do k e só os outros 3/4 são iterados, por trechos de linha. Sem a
+recarga de lanes dos kernels de bloco, eles empatam com o quadro-chave inteiro onde
+as lanes terminam em tempos muito diferentes e ganham no resto.
+
+Os frames precisam ser pedidos em ordem crescente; ficam guardados só os dois
+quadros-chave da oitava atual.
+*/
+
+// Amostras por eixo de cada pixel do frame, que cobre de 1 a 2 pixels da imagem amostrada
+#define ZOOM_MOVIE_MAX_SAMPLES 2
+
+typedef struct {
+    i32 index; // Oitava do quadro-chave, ou -1 se ainda não calculado
+    i32 *iterations;
+    u32 *colors;
+    u32 *half; // Média de cada 2x2 das cores: o de dentro é amostrado nela, com a densidade do de fora
+} Keyframe;
+
+typedef struct {
+    HPReal center_x;
+    HPReal center_y;
+    f64 start_zoom;
+    f64 octaves;
+    i32 frame_count;
+    i32 width;
+    i32 height;
+    i32 key_width;
+    i32 key_height;
+    i32 max_iterations;
+    RenderPrecision precision;
+    i32 *inner_columns; // Colunas das amostras de cada pixel do frame, no quadro-chave de dentro e no de fora
+    i32 *outer_columns;
+    Keyframe keys[2]; // keys[0] é o da oitava atual, keys[1] o seguinte
+} ZoomMovieState;
+
+static ZoomMovieState Movie;
+static ZoomMovieStats Stats;
+
+void ZoomMovieEnd(void)
+{
+    free(Movie.inner_columns);
+    free(Movie.outer_columns);
+    for (int k = 0; k < 2; ++k) {
+        free(Movie.keys[k].iterations);
+        free(Movie.keys[k].colors);
+        free(Movie.keys[k].half);
+    }
+    memset(&Movie, 0, sizeof(Movie));
+}
+
+b32 ZoomMovieBegin(const HPReal *center_x, const HPReal *center_y, f64 start_zoom, f64 octaves, i32 frame_count,
+                   i32 width, i32 height, i32 max_iterations, RenderPrecision precision)
+{
+    ZoomMovieEnd();
+    memset(&Stats, 0, sizeof(Stats));
+    if (width <= 0 || height <= 0 || frame_count <= 0 || start_zoom <= 0.0 || octaves < 0.0) return 0;
+
+    Movie.center_x = *center_x;
+    Movie.center_y = *center_y;
+    Movie.start_zoom = start_zoom;
+    Movie.octaves = octaves;
+    Movie.frame_count = frame_count;
+    Movie.width = width;
+    Movie.height = height;
+    // Múltiplos de 4: o pixel par q do quadro-chave seguinte cai sobre o pixel (q + lado/2) / 2 deste
+    Movie.key_width = (2 * width + 3) & ~3;
+    Movie.key_height = (2 * height + 3) & ~3;
+    Movie.max_iterations = max_iterations < 1 ? 1 : max_iterations;
+    Movie.precision = precision;
+
+    size_t key_pixels = (size_t)Movie.key_width * Movie.key_height;
+    Movie.inner_columns = malloc(sizeof(i32) * ZOOM_MOVIE_MAX_SAMPLES * width);
+    Movie.outer_columns = malloc(sizeof(i32) * ZOOM_MOVIE_MAX_SAMPLES * width);
+    for (int k = 0; k < 2; ++k) {
+        Movie.keys[k].index = -1;
+        Movie.keys[k].iterations = malloc(sizeof(i32) * key_pixels);
+        Movie.keys[k].colors = malloc(sizeof(u32) * key_pixels);
+        Movie.keys[k].half = malloc(sizeof(u32) * key_pixels / 4);
+    }
+    if (!Movie.inner_columns || !Movie.outer_columns || !Movie.keys[0].iterations || !Movie.keys[0].colors ||
+        !Movie.keys[0].half || !Movie.keys[1].iterations || !Movie.keys[1].colors || !Movie.keys[1].half) {
+        ZoomMovieEnd();
+        return 0;
+    }
+    return 1;
+}
+
+ZoomMovieStats GetZoomMovieStats(void)
+{
+    return Stats;
+}
+
+// Média por canal, com dois canais por soma; 'samples' é constante em cada chamada, para os laços saírem desenrolados
+static inline u32 BoxAverage(const u32 *colors, i32 stride, const i32 *xs, const i32 *ys, i32 samples)
+{
+    u32 sum_even = 0, sum_odd = 0;
+    for (int sy = 0; sy < samples; ++sy) {
+        const u32 *source_row = colors + (size_t)ys[sy] * stride;
+        for (int sx = 0; sx < samples; ++sx) {
+            u32 color = source_row[xs[sx]];
+            sum_even += color & 0x00FF00FF;
+            sum_odd += (color >> 8) & 0x00FF00FF;
+        }
+    }
+    u32 shift = samples == 2 ? 2 : 0;
+    u32 round = samples == 2 ? 0x00020002 : 0;
+    sum_even = ((sum_even + round) >> shift) & 0x00FF00FF;
+    sum_odd = ((sum_odd + round) >> shift) & 0x00FF00FF;
+    return sum_even | (sum_odd << 8);
+}
+
+// 'previous' é o quadro-chave index - 1, de onde sai 1/4 dos pixels, ou NULL para calcular todos
+static b32 RenderKeyframe(Keyframe *key, i32 index, const Keyframe *previous)
+{
+    i32 width = Movie.key_width;
+    i32 height = Movie.key_height;
+    f64 zoom = Movie.start_zoom * ldexp(0.5, -index);
+
+    RenderPrecision precision = Movie.precision;
+    if (precision == PRECISION_AUTO) {
+        precision = ChooseRenderPrecision(HPToF64(&Movie.center_x), HPToF64(&Movie.center_y), zoom, width, height);
+    }
+    FrameSetup frame;
+    if (!FrameSetupInit(&frame, &Movie.center_x, &Movie.center_y, zoom, width, height, Movie.max_iterations,
+                        precision)) {
+        return 0;
+    }
+
+    f64 start = omp_get_wtime();
+    ProfileZone zone = ProfileBegin("keyframe");
+
+    i32 *iterations = key->iterations;
+    i64 computed = (i64)width * height;
+    if (!previous) {
+        FrameIterateRegion(&frame, iterations, 0, 0, width, height);
+    } else {
+        // O pixel par q deste cai sobre o pixel (q + lado/2) / 2 do anterior
+        const i32 *source = previous->iterations;
+        #pragma omp parallel for schedule(static)
+        for (int y = 0; y < height; y += 2) {
+            const i32 *source_row = source + (size_t)((y + height / 2) / 2) * width + width / 4;
+            i32 *row = iterations + (size_t)y * width;
+            for (int x = 0; x < width; x += 2) row[x] = source_row[x / 2];
+        }
+
+        // Linhas ímpares inteiras e, nas pares, só as colunas ímpares
+        #pragma omp parallel for schedule(dynamic)
+        for (int y = 0; y < height; ++y) {
+            if (IsRenderCancelled()) continue;
+            b32 is_odd = y & 1;
+            FrameIterateSpan(&frame, iterations + (size_t)y * width, is_odd ? 0 : 1, width, is_odd ? 1 : 2, y);
+        }
+        computed -= (i64)(width / 2) * (height / 2);
+    }
+    if (IsRenderCancelled()) {
+        ProfileEnd(&zone);
+        return 0;
+    }
+
+    PrepareColorLookup(NULL, 0, 0, 0, frame.max_iterations);
+    #pragma omp parallel for schedule(static)
+    for (int y = 0; y < height; ++y) {
+        size_t offset = (size_t)y * width;
+        ColorizeRow(key->colors + offset, iterations + offset, width, frame.max_iterations);
+    }
+
+    i32 half_width = width / 2;
+    #pragma omp parallel for schedule(static)
+    for (int y = 0; y < height / 2; ++y) {
+        const i32 ys[2] = {2 * y, 2 * y + 1};
+        u32 *row = key->half + (size_t)y * half_width;
+        for (int x = 0; x < half_width; ++x) {
+            i32 xs[2] = {2 * x, 2 * x + 1};
+            row[x] = BoxAverage(key->colors, width, xs, ys, 2);
+        }
+    }
+    key->index = index;
+
+    ProfileEnd(&zone);
+    ++Stats.keyframes;
+    Stats.computed_pixels += computed;
+    Stats.keyframe_seconds += omp_get_wtime() - start;
+    return 1;
+}
+
+// Garante os quadros-chave 'index' e 'index' + 1, reaproveitando os que a oitava anterior já tinha
+static b32 EnsureKeyframes(i32 index)
+{
+    if (Movie.keys[0].index == index && Movie.keys[1].index == index + 1) return 1;
+    if (Movie.keys[1].index == index) {
+        Keyframe swap = Movie.keys[0];
+        Movie.keys[0] = Movie.keys[1];
+        Movie.keys[1] = swap;
+    } else if (Movie.keys[0].index != index) {
+        if (!RenderKeyframe(&Movie.keys[0], index, NULL)) return 0;
+    }
+    return RenderKeyframe(&Movie.keys[1], index + 1, &Movie.keys[0]);
+}
+
+/*
+Índices do pixel mais próximo de cada amostra de um eixo, centradas no pixel 'p' do
+frame; 'origin' é a posição, na imagem amostrada, do centro do frame.
+*/
+static void SampleAxis(i32 *indices, i32 samples, i32 p, i32 frame_size, f64 origin, f64 scale)
+{
+    for (int s = 0; s < samples; ++s) {
+        f64 u = (p + (s + 0.5) / samples - 0.5 - frame_size / 2.0) * scale + origin;
+        indices[s] = (i32)floor(u + 0.5);
+    }
+}
+
+static i32 ClampIndex(i32 value, i32 size)
+{
+    return value < 0 ? 0 : (value >= size ? size - 1 : value);
+}
+
+b32 ZoomMovieFrame(i32 frame_index, OffscreenBuffer *buffer)
+{
+    if (!Movie.inner_columns || buffer->width != Movie.width || buffer->height != Movie.height) return 0;
+    if (frame_index < 0 || frame_index >= Movie.frame_count) return 0;
+
+    // Posição em oitavas; t em (0, 1] dentro da oitava 'index', a não ser no primeiro frame
+    f64 position = Movie.frame_count > 1 ? Movie.octaves * frame_index / (Movie.frame_count - 1) : 0.0;
+    i32 index = position > 0.0 ? (i32)ceil(position) - 1 : 0;
+    if (Movie.keys[0].index > index) return 0;
+    if (!EnsureKeyframes(index)) return 0;
+
+    f64 start = omp_get_wtime();
+    ProfileZone zone = ProfileBegin("resample");
+
+    // Pixels por pixel do frame, de 1 a 2 nos dois: o quadro-chave de fora e a metade do de dentro
+    f64 scale = 2.0 * exp2(index - position);
+    i32 samples = scale > 1.0 + 1e-9 ? 2 : 1;
+
+    i32 width = Movie.width, height = Movie.height;
+    i32 key_width = Movie.key_width, key_height = Movie.key_height;
+    i32 half_width = key_width / 2, half_height = key_height / 2;
+    const u32 *outer = Movie.keys[0].colors;
+    const u32 *inner = Movie.keys[1].half;
+    // O pixel j da metade é a média dos pixels 2j e 2j + 1, centrada em 2j + 0.5 do quadro-chave
+    f64 half_origin_x = key_width / 4.0 - 0.25, half_origin_y = key_height / 4.0 - 0.25;
+
+    // As colunas não mudam de uma linha para outra; a de dentro vale -1 onde alguma amostra cai fora dele
+    i32 *inner_columns = Movie.inner_columns;
+    i32 *outer_columns = Movie.outer_columns;
+    for (int x = 0; x < width; ++x) {
+        i32 *inner_x = inner_columns + x * ZOOM_MOVIE_MAX_SAMPLES;
+        i32 *outer_x = outer_columns + x * ZOOM_MOVIE_MAX_SAMPLES;
+        SampleAxis(inner_x, samples, x, width, half_origin_x, scale);
+        SampleAxis(outer_x, samples, x, width, key_width / 2.0, scale);
+        if (inner_x[0] < 0 || inner_x[samples - 1] >= half_width) inner_x[0] = -1;
+        for (int s = 0; s < samples; ++s) outer_x[s] = ClampIndex(outer_x[s], key_width);
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (int y = 0; y < height; ++y) {
+        i32 inner_y[ZOOM_MOVIE_MAX_SAMPLES], outer_y[ZOOM_MOVIE_MAX_SAMPLES];
+        SampleAxis(inner_y, samples, y, height, half_origin_y, scale);
+        SampleAxis(outer_y, samples, y, height, key_height / 2.0, scale);
+        b32 is_inner_row = inner_y[0] >= 0 && inner_y[samples - 1] < half_height;
+        for (int s = 0; s < samples; ++s) outer_y[s] = ClampIndex(outer_y[s], key_height);
+
+        u32 *row = (u32 *)((u8 *)buffer->memory + (size_t)y * buffer->pitch);
+        for (int x = 0; x < width; ++x) {
+            const i32 *inner_x = inner_columns + x * ZOOM_MOVIE_MAX_SAMPLES;
+            const i32 *outer_x = outer_columns + x * ZOOM_MOVIE_MAX_SAMPLES;
+            b32 is_inner = is_inner_row && inner_x[0] >= 0;
+            if (samples == 1) {
+                row[x] = is_inner ? BoxAverage(inner, half_width, inner_x, inner_y, 1)
+                                  : BoxAverage(outer, key_width, outer_x, outer_y, 1);
+            } else {
+                row[x] = is_inner ? BoxAverage(inner, half_width, inner_x, inner_y, 2)
+                                  : BoxAverage(outer, key_width, outer_x, outer_y, 2);
+            }
+        }
+    }
+
+    ProfileEnd(&zone);
+    ++Stats.frames;
+    Stats.resample_seconds += omp_get_wtime() - start;
+    return 1;
+}